@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ARCReplacer::ARCReplacer(size_t num_frames)
+    : replacer_size_(num_frames), correlated_loads_(std::max<size_t>(num_frames / 64, 1)), frames_(num_frames) {}
+
+auto ARCReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> guard(latch_);
+  // REPLACE from the paper: shrink T1 while it is above its target, otherwise T2; fall back to the other list if
+  // every frame in the preferred one is pinned
+  const bool prefer_t1 = !t1_.empty() && t1_.size() > target_t1_;
+  const bool found = prefer_t1 ? EvictFrom(&t1_, frame_id) || EvictFrom(&t2_, frame_id)
+                               : EvictFrom(&t2_, frame_id) || EvictFrom(&t1_, frame_id);
+  if (!found) {
+    return false;
+  }
+
+  const auto &info = frames_[*frame_id];
+  const page_id_t page_id = info.page_id_;
+  const Queue queue = info.queue_;
+  Untrack(*frame_id);
+  if (page_id != INVALID_PAGE_ID) {
+    (queue == Queue::T1 ? b1_ : b2_).PushFront(page_id);
+    TrimGhosts();
+  }
+  return true;
+}
+
+void ARCReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto &info = frames_[frame_id];
+  switch (info.queue_) {
+    case Queue::NONE:
+      t1_.push_front(frame_id);
+      info.queue_ = Queue::T1;
+      info.pos_ = t1_.begin();
+      info.loaded_at_ = load_clock_++;
+      break;
+    case Queue::T1:
+      if (load_clock_ - info.loaded_at_ > correlated_loads_) {
+        t2_.splice(t2_.begin(), t1_, info.pos_);
+        info.queue_ = Queue::T2;
+      }
+      break;
+    case Queue::T2:
+      t2_.splice(t2_.begin(), t2_, info.pos_);
+      break;
+  }
+}
+
+void ARCReplacer::RecordLoad(frame_id_t frame_id, page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto &info = frames_[frame_id];
+  if (info.queue_ == Queue::NONE) {
+    return;
+  }
+  info.page_id_ = page_id;
+
+  // a ghost hit adapts the target: the list the page was evicted from was too small
+  if (b1_.Contains(page_id)) {
+    const size_t delta = std::max<size_t>(b2_.Size() / b1_.Size(), 1);
+    target_t1_ = std::min(target_t1_ + delta, replacer_size_);
+    b1_.Erase(page_id);
+  } else if (b2_.Contains(page_id)) {
+    const size_t delta = std::max<size_t>(b1_.Size() / b2_.Size(), 1);
+    target_t1_ = target_t1_ > delta ? target_t1_ - delta : 0;
+    b2_.Erase(page_id);
+  } else {
+    return;
+  }
+  if (info.queue_ == Queue::T1) {
+    t2_.splice(t2_.begin(), t1_, info.pos_);
+    info.queue_ = Queue::T2;
+  }
+}
+
+void ARCReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto &info = frames_[frame_id];
+  if (info.queue_ == Queue::NONE || info.evictable_ == set_evictable) {
+    return;
+  }
+  info.evictable_ = set_evictable;
+  if (set_evictable) {
+    evictable_count_++;
+  } else {
+    evictable_count_--;
+  }
+}
+
+void ARCReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  if (frames_[frame_id].queue_ == Queue::NONE) {
+    return;
+  }
+  BUSTUB_ENSURE(frames_[frame_id].evictable_, "cannot remove a non-evictable frame");
+  Untrack(frame_id);
+}
+
+auto ARCReplacer::Size() -> size_t {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_count_;
+}
+
+auto ARCReplacer::EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> candidates;
+  const bool prefer_t1 = !t1_.empty() && t1_.size() > target_t1_;
+  for (const auto *list : {prefer_t1 ? &t1_ : &t2_, prefer_t1 ? &t2_ : &t1_}) {
+    for (auto it = list->rbegin(); it != list->rend() && candidates.size() < max_count; ++it) {
+      if (frames_[*it].evictable_) {
+        candidates.push_back(*it);
+      }
+    }
+  }
+  return candidates;
+}
+
+void ARCReplacer::CheckFrameId(frame_id_t frame_id) const {
+  BUSTUB_ENSURE(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+}
+
+auto ARCReplacer::EvictFrom(std::list<frame_id_t> *list, frame_id_t *frame_id) -> bool {
+  for (auto it = list->rbegin(); it != list->rend(); ++it) {
+    if (frames_[*it].evictable_) {
+      *frame_id = *it;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ARCReplacer::Untrack(frame_id_t frame_id) {
+  auto &info = frames_[frame_id];
+  (info.queue_ == Queue::T1 ? t1_ : t2_).erase(info.pos_);
+  if (info.evictable_) {
+    evictable_count_--;
+  }
+  info = FrameInfo{};
+}
+
+void ARCReplacer::TrimGhosts() {
+  while (b1_.Size() > 0 && t1_.size() + b1_.Size() > replacer_size_) {
+    b1_.PopBack();
+  }
+  while (t1_.size() + t2_.size() + b1_.Size() + b2_.Size() > 2 * replacer_size_) {
+    if (b2_.Size() > 0) {
+      b2_.PopBack();
+    } else {
+      b1_.PopBack();
+    }
+  }
+}
+
+}  // namespace bustub
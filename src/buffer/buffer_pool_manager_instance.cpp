@@ -12,17 +12,84 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <future>  // NOLINT
+#include <new>
+#include <thread>  // NOLINT
+
+#include "common/logger.h"
 #include "common/macros.h"
 
 namespace bustub {
 
+namespace {
+
+/** First word of a warm start file. */
+constexpr uint32_t WARM_START_MAGIC = 0x42545753;
+
+/** Write the page ids next to path and rename the file over it, so a crash never leaves a torn list behind. */
+void WriteWarmStartFile(const std::string &path, const std::vector<page_id_t> &page_ids) {
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    const auto count = static_cast<uint32_t>(page_ids.size());
+    out.write(reinterpret_cast<const char *>(&WARM_START_MAGIC), sizeof(WARM_START_MAGIC));
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+    if (!out) {
+      LOG_WARN("cannot write warm start file %s", tmp_path.c_str());
+      return;
+    }
+  }
+  std::rename(tmp_path.c_str(), path.c_str());
+}
+
+/** @return false if the file is missing or is not a complete warm start file */
+auto ReadWarmStartFile(const std::string &path, std::vector<page_id_t> *page_ids) -> bool {
+  std::ifstream in(path, std::ios::binary);
+  uint32_t magic = 0;
+  uint32_t count = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if (!in || magic != WARM_START_MAGIC) {
+    return false;
+  }
+  page_ids->resize(count);
+  in.read(reinterpret_cast<char *>(page_ids->data()), count * sizeof(page_id_t));
+  return static_cast<bool>(in);
+}
+
+}  // namespace
+
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, replacer_type) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      bg_writer_lookahead_(std::max<size_t>(pool_size / 16, 1)),
+      bg_writer_free_target_(std::max<size_t>(pool_size / 64, 1)),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 0.");
   // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  frame_arena_ = std::make_unique<FrameArena>(pool_size_, enable_huge_page_frames);
+  pages_ = static_cast<Page *>(::operator new[](pool_size_ * sizeof(Page), std::align_val_t{alignof(Page)}));
+  for (size_t i = 0; i < pool_size_; ++i) {
+    new (&pages_[i]) Page(frame_arena_->GetFrame(i));
+  }
+  page_table_ = new ConcurrentPageTable(pool_size_);
+  replacer_ = Replacer::Create(replacer_type, pool_size, replacer_k);
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -31,160 +98,654 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopBackgroundWriter();
+  {
+    const std::lock_guard<std::mutex> guard(prefetch_latch_);
+    stop_prefetch_ = true;
+  }
+  prefetch_cv_.notify_all();
+  for (auto &thread : prefetch_threads_) {
+    thread.join();
+  }
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_, std::align_val_t{alignof(Page)});
   delete page_table_;
-  delete replacer_;
 }
+
+void BufferPoolManagerInstance::RunBackgroundWriter() {
+  const std::lock_guard<std::mutex> guard(bg_writer_latch_);
+  if (bg_writer_thread_.joinable()) {
+    return;
+  }
+  stop_bg_writer_ = false;
+  bg_writer_thread_ = std::thread(&BufferPoolManagerInstance::BackgroundWriter, this);
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  std::thread thread;
+  {
+    const std::lock_guard<std::mutex> guard(bg_writer_latch_);
+    stop_bg_writer_ = true;
+    thread = std::move(bg_writer_thread_);
+  }
+  bg_writer_cv_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
 /*flush不需要清空数据*/
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
-  const std::lock_guard<std::mutex> guard(latch_);
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
   frame_id_t frame_id;
-  if (!page_table_->Find(page_id, frame_id)) {
-    return false;
+  {
+    // page latches are never waited for under latch_, the pin keeps the page in its frame after latch_ is released
+    const std::lock_guard<std::mutex> guard(latch_);
+    if (!page_table_->Find(page_id, frame_id)) {
+      return false;
+    }
+    PinResident(frame_id);
   }
-  disk_manager_->WritePage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
-  pages_[frame_id].is_dirty_ = false;
+  pages_[frame_id].RLatch();
+  WriteBackLatched(&pages_[frame_id]);
+  pages_[frame_id].RUnlatch();
+  UnpinResident(frame_id);
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  const std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> pinned;
+  {
+    const std::lock_guard<std::mutex> guard(latch_);
+    for (size_t i = 0; i < pool_size_; i++) {
+      if (pages_[i].is_dirty_ && pages_[i].page_id_ != INVALID_PAGE_ID) {
+        PinResident(static_cast<frame_id_t>(i));
+        pinned.push_back(static_cast<frame_id_t>(i));
+      }
+    }
+  }
 
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].is_dirty_ && pages_[i].page_id_ != INVALID_PAGE_ID) {
-      disk_manager_->WritePage(pages_[i].GetPageId(), pages_[i].GetData());
-      pages_[i].is_dirty_ = false;
+  // Start every write before waiting for any, so an asynchronous disk manager can have them all in flight. Holding
+  // one read latch while waiting for another could deadlock with a writer crabbing the other way, so pages that are
+  // latched now are written afterwards, one at a time.
+  std::vector<std::future<void>> writes;
+  std::vector<frame_id_t> latched;
+  std::vector<frame_id_t> busy;
+  for (auto frame_id : pinned) {
+    auto &page = pages_[frame_id];
+    if (!page.TryRLatch()) {
+      busy.push_back(frame_id);
+      continue;
     }
+    page.is_dirty_ = false;
+    PrepareWriteBack(&page);
+    writes.push_back(disk_manager_->WritePageAsync(page.GetPageId(), page.GetData()));
+    latched.push_back(frame_id);
+  }
+  for (auto &write : writes) {
+    write.get();
+  }
+  for (auto frame_id : latched) {
+    pages_[frame_id].rec_lsn_ = INVALID_LSN;
+    pages_[frame_id].RUnlatch();
+  }
+  for (auto frame_id : busy) {
+    pages_[frame_id].RLatch();
+    WriteBackLatched(&pages_[frame_id]);
+    pages_[frame_id].RUnlatch();
   }
+  for (auto frame_id : pinned) {
+    UnpinResident(frame_id);
+  }
+  disk_manager_->FlushAllocations();
 }
 /*newPage和fetchPage的区别：new是创建一个新页，在磁盘上新建的；而fetch是这个页本身都在磁盘上存在，只是去读*/
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  const std::lock_guard<std::mutex> guard(latch_);
+auto BufferPoolManagerInstance::NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * {
+  std::unique_lock<std::mutex> lock(latch_);
 
-  int new_page_id = AllocatePage();
   frame_id_t frame_id;
-  // 1. 可用page
-
-  if (!free_list_.empty()) {
-    // 1. 先从空闲链表
-    frame_id = free_list_.back();
-    free_list_.pop_back();
-  } else {
-    // 2. 再从替换器replacer中找
-    if (!replacer_->Evict(&frame_id)) {
-      return nullptr;
-    }
-
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
-    }
-    page_table_->Remove(pages_[frame_id].GetPageId());
+  if (!ClaimFrame(&frame_id)) {
+    return nullptr;
   }
 
+  // Only allocate once a frame is secured, so a full instance does not burn page ids.
+  // A freed id may still be resident, fetched back by an unlatched reader or a warm start. Its frame is dropped before
+  // the id is reused, and ids whose frame is still pinned are skipped and freed again afterwards.
+  std::vector<page_id_t> skipped;
+  page_id_t new_page_id = AllocatePage(near_page_id);
+  while (!DropFreedFrame(&lock, new_page_id)) {
+    skipped.push_back(new_page_id);
+    new_page_id = AllocatePage(near_page_id);
+  }
+  for (auto skipped_page_id : skipped) {
+    DeallocatePage(skipped_page_id);
+  }
   page_table_->Insert(new_page_id, frame_id);
   auto &current_page = pages_[frame_id];
   // metadata
   current_page.page_id_ = new_page_id;
   current_page.ResetMemory();
   current_page.is_dirty_ = false;
-  current_page.pin_count_ = 1;
 
   replacer_->RecordAccess(frame_id);
+  replacer_->RecordLoad(frame_id, new_page_id);
   replacer_->SetEvictable(frame_id, false);
+  // publishing the pin count hands the frame out, optimistic pins may succeed from here on
+  current_page.pin_count_ = 1;
   *page_id = new_page_id;
   return &current_page;
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  /*按照.h中的文字描述，照着实现一遍*/
-  const std::lock_guard<std::mutex> guard(latch_);
+  ValidatePageId(page_id);
 
+  // Hit path: pin the frame first, then check that it still holds the page.
   frame_id_t frame_id;
+  if (FindFrameOptimistic(page_id, &frame_id)) {
+    const int old_pin_count = TryPin(&pages_[frame_id]);
+    if (old_pin_count != FRAME_CLAIMED) {
+      if (pages_[frame_id].page_id_ == page_id) {
+        // pin之后就不能换出
+        replacer_->RecordAccess(frame_id);
+        if (old_pin_count == 0) {
+          replacer_->SetEvictable(frame_id, false);
+        }
+        return &pages_[frame_id];
+      }
+      // the frame was handed to another page between the lookup and the pin
+      pages_[frame_id].pin_count_--;
+    }
+  }
+
+  /*按照.h中的文字描述，照着实现一遍*/
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitForPrefetch(&lock, page_id);
   if (page_table_->Find(page_id, frame_id)) {
-    pages_[frame_id].pin_count_++;
-    // pin之后就不能换出
+    // frames are only claimed under latch_, so a resident page can always be pinned here
+    const int old_pin_count = TryPin(&pages_[frame_id]);
+    BUSTUB_ASSERT(old_pin_count != FRAME_CLAIMED, "resident page must not be claimed while holding the latch");
     replacer_->RecordAccess(frame_id);
-    replacer_->SetEvictable(frame_id, false);
+    if (old_pin_count == 0) {
+      replacer_->SetEvictable(frame_id, false);
+    }
     return &pages_[frame_id];
   }
   // 1. 未从page_table中找到，先从空闲链表找，再从replacer中找
-
-  if (!free_list_.empty()) {
-    // 1. 先从空闲链表
-    frame_id = free_list_.back();
-    free_list_.pop_back();
-  } else {
-    // 2. 再从替换器replacer中找
-    if (!replacer_->Evict(&frame_id)) {
-      return nullptr;
-    }
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
-    }
-    page_table_->Remove(pages_[frame_id].GetPageId());
+  if (!ClaimFrame(&frame_id)) {
+    return nullptr;
   }
 
   page_table_->Insert(page_id, frame_id);
   // metadata
   pages_[frame_id].page_id_ = page_id;
   pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].pin_count_ = 1;
   // 要从磁盘读出数据呀！！！
   disk_manager_->ReadPage(page_id, pages_[frame_id].data_);
 
   replacer_->RecordAccess(frame_id);
+  replacer_->RecordLoad(frame_id, page_id);
   replacer_->SetEvictable(frame_id, false);
+  pages_[frame_id].pin_count_ = 1;
   return &pages_[frame_id];
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  const std::lock_guard<std::mutex> guard(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  WaitForPrefetch(&lock, page_id);
   frame_id_t frame_id;
   if (!page_table_->Find(page_id, frame_id)) {
+    DeallocatePage(page_id);
     return true;
   }
-  if (pages_[frame_id].pin_count_ != 0) {
+  int unpinned = 0;
+  if (!pages_[frame_id].pin_count_.compare_exchange_strong(unpinned, FRAME_CLAIMED)) {
     return false;
   }
   if (pages_[frame_id].IsDirty()) {
+    PrepareWriteBack(&pages_[frame_id]);
     disk_manager_->WritePage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
     pages_[frame_id].is_dirty_ = false;
   }
-  page_table_->Remove(page_id);
+  FreeFrame(frame_id);
+
+  DeallocatePage(page_id);
+  return true;
+}
+
+auto BufferPoolManagerInstance::DropFreedFrame(std::unique_lock<std::mutex> *lock, page_id_t page_id) -> bool {
+  WaitForPrefetch(lock, page_id);
+  frame_id_t frame_id;
+  if (!page_table_->Find(page_id, frame_id)) {
+    return true;
+  }
+  int unpinned = 0;
+  if (!pages_[frame_id].pin_count_.compare_exchange_strong(unpinned, FRAME_CLAIMED)) {
+    return false;
+  }
+  // the page was freed, what the frame holds is not written anywhere
+  FreeFrame(frame_id);
+  return true;
+}
 
+void BufferPoolManagerInstance::FreeFrame(frame_id_t frame_id) {
+  pages_[frame_id].rec_lsn_ = INVALID_LSN;
+  page_table_->Remove(pages_[frame_id].GetPageId());
+
+  // a racing pin/unpin pair may have left the frame non-evictable, and Remove only drops evictable frames
+  replacer_->SetEvictable(frame_id, true);
   replacer_->Remove(frame_id);
   free_list_.push_back(frame_id);
   // reset metadata
   pages_[frame_id].page_id_ = INVALID_PAGE_ID;
   pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].pin_count_ = 0;
   pages_[frame_id].ResetMemory();
-
-  DeallocatePage(page_id);
-  return true;
+  pages_[frame_id].pin_count_ = 0;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  const std::lock_guard<std::mutex> guard(latch_);
-
   frame_id_t frame_id;
-  if (!page_table_->Find(page_id, frame_id) || pages_[frame_id].pin_count_ <= 0) {
-    return false;
+  if (!FindFrameOptimistic(page_id, &frame_id)) {
+    const std::lock_guard<std::mutex> guard(latch_);
+    if (!page_table_->Find(page_id, frame_id)) {
+      return false;
+    }
   }
   auto &current_page = pages_[frame_id];
-  current_page.pin_count_--;
-  current_page.is_dirty_ |= is_dirty;
-  if (current_page.pin_count_ == 0) {
+  int pin_count = current_page.pin_count_;
+  if (pin_count <= 0) {
+    return false;
+  }
+  // mark dirty before dropping the pin, so an eviction that claims the frame sees the flag
+  if (is_dirty) {
+    current_page.is_dirty_ = true;
+  }
+  while (!current_page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1)) {
+    if (pin_count <= 0) {
+      return false;
+    }
+  }
+  if (pin_count == 1) {
     replacer_->SetEvictable(frame_id, true);
   }
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManagerInstance::PrefetchPgsImp(const std::vector<page_id_t> &page_ids) {
+  for (auto page_id : page_ids) {
+    ValidatePageId(page_id);
+  }
+  std::call_once(prefetch_threads_started_, [this] {
+    for (int i = 0; i < PREFETCH_IO_THREADS; i++) {
+      prefetch_threads_.emplace_back(&BufferPoolManagerInstance::PrefetchWorker, this);
+    }
+  });
+  {
+    const std::lock_guard<std::mutex> guard(prefetch_latch_);
+    for (auto page_id : page_ids) {
+      if (prefetch_queue_.size() >= pool_size_) {
+        break;
+      }
+      prefetch_queue_.push_back(page_id);
+    }
+  }
+  prefetch_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::WaitForPrefetch(std::unique_lock<std::mutex> *lock, page_id_t page_id) {
+  prefetch_done_.wait(*lock, [&] { return prefetching_.count(page_id) == 0; });
+}
+
+void BufferPoolManagerInstance::PrefetchWorker() {
+  while (true) {
+    page_id_t page_id;
+    {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      prefetch_cv_.wait(lock, [&] { return stop_prefetch_ || !prefetch_queue_.empty(); });
+      if (stop_prefetch_) {
+        return;
+      }
+      page_id = prefetch_queue_.front();
+      prefetch_queue_.pop_front();
+    }
+    PrefetchPage(page_id);
+  }
+}
+
+void BufferPoolManagerInstance::PrefetchPage(page_id_t page_id) {
+  frame_id_t frame_id;
+  {
+    const std::lock_guard<std::mutex> guard(latch_);
+    if (page_table_->Find(page_id, frame_id) || prefetching_.count(page_id) != 0 || !ClaimFrame(&frame_id)) {
+      return;
+    }
+    prefetching_.insert(page_id);
+    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+  }
+
+  // the frame is claimed and not in the page table, nobody else touches it during the read
+  disk_manager_->ReadPage(page_id, pages_[frame_id].data_);
+
+  {
+    const std::lock_guard<std::mutex> guard(latch_);
+    page_table_->Insert(page_id, frame_id);
+    pages_[frame_id].page_id_ = page_id;
+    pages_[frame_id].is_dirty_ = false;
+    replacer_->RecordAccess(frame_id);
+    replacer_->RecordLoad(frame_id, page_id);
+    replacer_->SetEvictable(frame_id, true);
+    pages_[frame_id].pin_count_ = 0;
+    prefetching_.erase(page_id);
+  }
+  prefetch_done_.notify_all();
+}
+
+void BufferPoolManagerInstance::BackgroundWriter() {
+  auto last_dump = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(bg_writer_latch_);
+  while (!stop_bg_writer_) {
+    lock.unlock();
+    CleanEvictionCandidates();
+    RefillFreeList();
+    if (std::chrono::steady_clock::now() - last_dump >= warm_start_dump_interval) {
+      DumpResidentPages();
+      last_dump = std::chrono::steady_clock::now();
+    }
+    lock.lock();
+    bg_writer_cv_.wait_for(lock, bg_writer_interval, [&] { return stop_bg_writer_ || bg_writer_wakeup_; });
+    bg_writer_wakeup_ = false;
+  }
+}
+
+void BufferPoolManagerInstance::CleanEvictionCandidates() {
+  std::vector<frame_id_t> pinned;
+  std::vector<frame_id_t> latched;
+  std::vector<std::future<void>> writes;
+  for (auto frame_id : replacer_->EvictionCandidates(bg_writer_lookahead_)) {
+    auto &page = pages_[frame_id];
+    if (!page.IsDirty()) {
+      continue;
+    }
+    // the pin keeps the frame from being replaced, and from being read back from disk before the write is done
+    const int old_pin_count = TryPin(&page);
+    if (old_pin_count == FRAME_CLAIMED) {
+      continue;
+    }
+    if (old_pin_count == 0) {
+      replacer_->SetEvictable(frame_id, false);
+    }
+    pinned.push_back(frame_id);
+    // skip pages that are being modified rather than wait for them, they are not going to be evicted soon
+    if (page.page_id_ != INVALID_PAGE_ID && page.IsDirty() && page.TryRLatch()) {
+      // clear the flag before writing, so a modification made after the write marks the page dirty again
+      page.is_dirty_ = false;
+      PrepareWriteBack(&page);
+      writes.push_back(disk_manager_->WritePageAsync(page.GetPageId(), page.GetData()));
+      latched.push_back(frame_id);
+    }
+  }
+
+  // the writes of one round are in flight together
+  for (auto &write : writes) {
+    write.get();
+  }
+  for (auto frame_id : latched) {
+    // the read latch kept changes out during the write, and a checkpoint counts the page dirty until here
+    pages_[frame_id].rec_lsn_ = INVALID_LSN;
+    pages_[frame_id].RUnlatch();
+  }
+  for (auto frame_id : pinned) {
+    if (pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+      replacer_->SetEvictable(frame_id, true);
+    }
+  }
+}
+
+void BufferPoolManagerInstance::RefillFreeList() {
+  const std::lock_guard<std::mutex> guard(latch_);
+  frame_id_t frame_id;
+  while (free_list_.size() < bg_writer_free_target_ && EvictUnpinned(&frame_id)) {
+    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+    pages_[frame_id].pin_count_ = 0;
+    free_list_.push_back(frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::SetWarmStartFile(const std::string &path) {
+  const std::lock_guard<std::mutex> guard(bg_writer_latch_);
+  warm_start_file_ = path;
+}
+
+void BufferPoolManagerInstance::DumpResidentPages() {
+  // bg_writer_latch_ also keeps an explicit dump and one of the background writer from writing the file together
+  const std::lock_guard<std::mutex> guard(bg_writer_latch_);
+  if (warm_start_file_.empty()) {
+    return;
+  }
+  std::vector<page_id_t> page_ids;
+  {
+    const std::lock_guard<std::mutex> latch_guard(latch_);
+    page_ids = ResidentPagesByRecency();
+  }
+  WriteWarmStartFile(warm_start_file_, page_ids);
+}
+
+auto BufferPoolManagerInstance::WarmStart() -> size_t {
+  std::vector<page_id_t> page_ids;
+  {
+    const std::lock_guard<std::mutex> guard(bg_writer_latch_);
+    if (warm_start_file_.empty() || !ReadWarmStartFile(warm_start_file_, &page_ids)) {
+      return 0;
+    }
+  }
+
+  const std::lock_guard<std::mutex> guard(latch_);
+  // keep the most recently used pages that fit into the free frames, most recent first
+  std::vector<page_id_t> to_load;
+  std::unordered_set<page_id_t> seen;
+  for (auto it = page_ids.rbegin(); it != page_ids.rend() && to_load.size() < free_list_.size(); ++it) {
+    frame_id_t frame_id;
+    // a page deleted after the dump is not loaded, its id may be handed out again
+    if (*it < 0 || static_cast<uint32_t>(*it) % num_instances_ != instance_index_ || !seen.insert(*it).second ||
+        page_table_->Find(*it, frame_id) || !disk_manager_->IsAllocated(*it)) {
+      continue;
+    }
+    to_load.push_back(*it);
+  }
+
+  // Read runs of pages that follow each other on disk with one read each. The frames stay claimed until every page
+  // is in, so a concurrent fetch of a page being loaded waits for latch_ instead of pinning it.
+  std::vector<page_id_t> by_page_id = to_load;
+  std::sort(by_page_id.begin(), by_page_id.end());
+  std::vector<char> batch(WARM_START_READ_PAGES * BUSTUB_PAGE_SIZE);
+  std::unordered_map<page_id_t, frame_id_t> frames;
+  for (size_t run_start = 0; run_start < by_page_id.size();) {
+    const page_id_t first_page_id = by_page_id[run_start];
+    size_t run_end = run_start + 1;
+    while (run_end < by_page_id.size() &&
+           by_page_id[run_end] == by_page_id[run_end - 1] + static_cast<page_id_t>(num_instances_) &&
+           static_cast<size_t>(by_page_id[run_end] - first_page_id) < WARM_START_READ_PAGES) {
+      run_end++;
+    }
+    // pages of other instances between the ones of this instance are read along and dropped
+    const auto num_pages = static_cast<size_t>(by_page_id[run_end - 1] - first_page_id) + 1;
+    disk_manager_->ReadPages(first_page_id, num_pages, batch.data());
+    for (size_t i = run_start; i < run_end; i++) {
+      frame_id_t frame_id;
+      BUSTUB_ENSURE(ClaimFrame(&frame_id), "warm start only loads as many pages as there are free frames");
+      memcpy(pages_[frame_id].data_, batch.data() + (by_page_id[i] - first_page_id) * BUSTUB_PAGE_SIZE,
+             BUSTUB_PAGE_SIZE);
+      page_table_->Insert(by_page_id[i], frame_id);
+      pages_[frame_id].page_id_ = by_page_id[i];
+      pages_[frame_id].is_dirty_ = false;
+      frames[by_page_id[i]] = frame_id;
+    }
+    run_start = run_end;
+  }
+
+  // hand the pages to the replacer from least to most recently used, so they are evicted in their old order
+  for (auto it = to_load.rbegin(); it != to_load.rend(); ++it) {
+    const frame_id_t frame_id = frames[*it];
+    replacer_->RecordAccess(frame_id);
+    replacer_->RecordLoad(frame_id, *it);
+    replacer_->SetEvictable(frame_id, true);
+    pages_[frame_id].pin_count_ = 0;
+  }
+  return to_load.size();
+}
+
+auto BufferPoolManagerInstance::ResidentPagesByRecency() -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  std::vector<bool> listed(pool_size_, false);
+  for (auto frame_id : replacer_->EvictionCandidates(pool_size_)) {
+    listed[frame_id] = true;
+    if (pages_[frame_id].page_id_ != INVALID_PAGE_ID) {
+      page_ids.push_back(pages_[frame_id].page_id_);
+    }
+  }
+  // pages that are not eviction candidates are pinned, they count as the most recently used ones
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (!listed[i] && pages_[i].page_id_ != INVALID_PAGE_ID) {
+      page_ids.push_back(pages_[i].page_id_);
+    }
+  }
+  return page_ids;
+}
+
+auto BufferPoolManagerInstance::TryPin(Page *page) -> int {
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count < 0) {
+      return FRAME_CLAIMED;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  return pin_count;
+}
+
+auto BufferPoolManagerInstance::FindFrameOptimistic(page_id_t page_id, frame_id_t *frame_id) -> bool {
+  return page_table_->Find(page_id, *frame_id) && pages_[*frame_id].page_id_ == page_id;
+}
+
+auto BufferPoolManagerInstance::ClaimFrame(frame_id_t *frame_id) -> bool {
+  if (!free_list_.empty()) {
+    // 1. 先从空闲链表
+    *frame_id = free_list_.back();
+    free_list_.pop_back();
+    // a stale optimistic pin may hold a free frame for a moment before it fails validation and lets go
+    int unpinned = 0;
+    while (!pages_[*frame_id].pin_count_.compare_exchange_weak(unpinned, FRAME_CLAIMED)) {
+      unpinned = 0;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  // 2. 再从替换器replacer中找
+  // the free list ran dry, let the background writer refill it before the next miss
+  bg_writer_wakeup_ = true;
+  bg_writer_cv_.notify_one();
+  // The replacer's evictable flags are updated after the pin count changes, so a pin racing with an unpin can leave
+  // them stale. The compare-and-swap on the pin count is what decides whether a victim can really be reused.
+  if (EvictUnpinned(frame_id)) {
+    return true;
+  }
+  // A stale flag may have hidden an unpinned frame from the replacer. Hand those back and try once more.
+  bool found_unpinned = false;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].pin_count_ == 0) {
+      replacer_->RecordAccess(static_cast<frame_id_t>(i));
+      replacer_->RecordLoad(static_cast<frame_id_t>(i), pages_[i].page_id_);
+      replacer_->SetEvictable(static_cast<frame_id_t>(i), true);
+      found_unpinned = true;
+    }
+  }
+  return found_unpinned && EvictUnpinned(frame_id);
+}
+
+auto BufferPoolManagerInstance::EvictUnpinned(frame_id_t *frame_id) -> bool {
+  while (replacer_->Evict(frame_id)) {
+    auto &victim = pages_[*frame_id];
+    int unpinned = 0;
+    if (!victim.pin_count_.compare_exchange_strong(unpinned, FRAME_CLAIMED)) {
+      // pinned by a hit that raced with its unpin: track it again, its unpin will make it evictable
+      replacer_->RecordAccess(*frame_id);
+      replacer_->RecordLoad(*frame_id, victim.page_id_);
+      replacer_->SetEvictable(*frame_id, false);
+      continue;
+    }
+    if (victim.IsDirty()) {
+      PrepareWriteBack(&victim);
+      disk_manager_->WritePage(victim.GetPageId(), victim.GetData());
+      victim.is_dirty_ = false;
+    }
+    victim.rec_lsn_ = INVALID_LSN;
+    page_table_->Remove(victim.GetPageId());
+    return true;
+  }
+  return false;
+}
+
+void BufferPoolManagerInstance::PrepareWriteBack(Page *page) {
+  if (page->rec_lsn_ == INVALID_LSN || log_manager_ == nullptr) {
+    return;
+  }
+  if (page->GetLSN() > log_manager_->GetPersistentLSN()) {
+    log_manager_->Flush(page->GetLSN());
+  }
+}
+
+void BufferPoolManagerInstance::WriteBackLatched(Page *page) {
+  page->is_dirty_ = false;
+  PrepareWriteBack(page);
+  disk_manager_->WritePage(page->GetPageId(), page->GetData());
+  page->rec_lsn_ = INVALID_LSN;
+}
+
+void BufferPoolManagerInstance::PinResident(frame_id_t frame_id) {
+  // frames are only claimed under latch_, so a resident page can always be pinned here
+  const int old_pin_count = TryPin(&pages_[frame_id]);
+  BUSTUB_ASSERT(old_pin_count != FRAME_CLAIMED, "resident page must not be claimed while holding the latch");
+  if (old_pin_count == 0) {
+    replacer_->SetEvictable(frame_id, false);
+  }
+}
+
+void BufferPoolManagerInstance::UnpinResident(frame_id_t frame_id) {
+  if (pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+    replacer_->SetEvictable(frame_id, true);
+  }
+}
+
+auto BufferPoolManagerInstance::GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> {
+  const std::lock_guard<std::mutex> guard(latch_);
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (size_t i = 0; i < pool_size_; i++) {
+    const page_id_t page_id = pages_[i].page_id_;
+    const lsn_t rec_lsn = pages_[i].rec_lsn_;
+    if (page_id != INVALID_PAGE_ID && rec_lsn != INVALID_LSN) {
+      dirty_pages.emplace_back(page_id, rec_lsn);
+    }
+  }
+  return dirty_pages;
+}
+
+auto BufferPoolManagerInstance::AllocatePage(page_id_t near_page_id) -> page_id_t {
+  const page_id_t page_id = disk_manager_->AllocatePage(near_page_id, num_instances_, instance_index_);
+  if (page_id != INVALID_PAGE_ID) {
+    ValidatePageId(page_id);
+    return page_id;
+  }
+  const page_id_t next_page_id = next_page_id_.fetch_add(static_cast<page_id_t>(num_instances_));
+  ValidatePageId(next_page_id);
+  return next_page_id;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  // allocated pages mod back to this BPI
+  BUSTUB_ASSERT(static_cast<uint32_t>(page_id) % num_instances_ == instance_index_, "page routed to the wrong BPI");
+}
 
 }  // namespace bustub
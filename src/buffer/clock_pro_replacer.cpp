@@ -0,0 +1,253 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.cpp
+//
+// Identification: src/buffer/clock_pro_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_pro_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ClockProReplacer::ClockProReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      correlated_loads_(std::max<size_t>(num_frames / 64, 1)),
+      cold_target_(std::max<size_t>(num_frames / 4, 1)),
+      hand_cold_(clock_.end()),
+      hand_hot_(clock_.end()),
+      hand_test_(clock_.end()),
+      frame_entry_(num_frames, clock_.end()) {}
+
+auto ClockProReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (evictable_count_ == 0) {
+    return false;
+  }
+
+  // every referenced cold page the hand passes loses its reference bit, so two rounds reach an evictable cold page
+  // if there is one
+  for (size_t steps = 2 * clock_.size(); steps > 0; steps--) {
+    auto it = hand_cold_;
+    hand_cold_ = Next(hand_cold_);
+    if (it->frame_id_ == -1 || it->hot_ || !it->evictable_) {
+      continue;
+    }
+    if (it->referenced_) {
+      it->referenced_ = false;
+      if (it->in_test_) {
+        // reused within its test period
+        it->hot_ = true;
+        it->in_test_ = false;
+        hot_count_++;
+        RunHandHot();
+      } else {
+        it->in_test_ = true;
+      }
+      continue;
+    }
+
+    *frame_id = it->frame_id_;
+    frame_entry_[*frame_id] = clock_.end();
+    evictable_count_--;
+    if (it->in_test_ && it->page_id_ != INVALID_PAGE_ID) {
+      // keep the page as a non-resident entry until its test period ends
+      it->frame_id_ = -1;
+      it->evictable_ = false;
+      non_resident_[it->page_id_] = it;
+      while (non_resident_.size() > replacer_size_) {
+        RunHandTest();
+      }
+    } else {
+      Erase(it);
+    }
+    return true;
+  }
+
+  // only hot or pinned cold pages left, take any evictable page
+  for (auto it = clock_.begin(); it != clock_.end(); ++it) {
+    if (it->frame_id_ != -1 && it->evictable_) {
+      *frame_id = it->frame_id_;
+      EraseResident(it);
+      return true;
+    }
+  }
+  UNREACHABLE("evictable_count_ does not match the clock");
+}
+
+void ClockProReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto it = frame_entry_[frame_id];
+  if (it != clock_.end()) {
+    if (load_clock_ - it->loaded_at_ > correlated_loads_) {
+      it->referenced_ = true;
+    }
+    return;
+  }
+
+  Entry entry;
+  entry.frame_id_ = frame_id;
+  entry.in_test_ = true;
+  entry.loaded_at_ = load_clock_++;
+  if (clock_.empty()) {
+    clock_.push_back(entry);
+    hand_cold_ = hand_hot_ = hand_test_ = clock_.begin();
+    frame_entry_[frame_id] = clock_.begin();
+  } else {
+    frame_entry_[frame_id] = clock_.insert(hand_hot_, entry);
+  }
+}
+
+void ClockProReplacer::RecordLoad(frame_id_t frame_id, page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto it = frame_entry_[frame_id];
+  if (it == clock_.end()) {
+    return;
+  }
+  it->page_id_ = page_id;
+  auto ghost = non_resident_.find(page_id);
+  if (ghost == non_resident_.end()) {
+    return;
+  }
+
+  // the page was reused within its test period: cold pages need more room, and the page comes back hot
+  cold_target_ = std::min(cold_target_ + 1, std::max<size_t>(replacer_size_ - 1, 1));
+  Erase(ghost->second);
+  non_resident_.erase(ghost);
+  if (!it->hot_) {
+    it->hot_ = true;
+    it->in_test_ = false;
+    hot_count_++;
+    RunHandHot();
+  }
+}
+
+void ClockProReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto it = frame_entry_[frame_id];
+  if (it == clock_.end() || it->evictable_ == set_evictable) {
+    return;
+  }
+  it->evictable_ = set_evictable;
+  if (set_evictable) {
+    evictable_count_++;
+  } else {
+    evictable_count_--;
+  }
+}
+
+void ClockProReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto it = frame_entry_[frame_id];
+  if (it == clock_.end()) {
+    return;
+  }
+  BUSTUB_ENSURE(it->evictable_, "cannot remove a non-evictable frame");
+  EraseResident(it);
+}
+
+auto ClockProReplacer::Size() -> size_t {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_count_;
+}
+
+auto ClockProReplacer::EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> {
+  std::lock_guard<std::mutex> guard(latch_);
+  // the cold hand takes unreferenced cold pages first and the referenced ones on a later round; hot pages are only
+  // evicted once no cold page is left, so they are not worth cleaning ahead of time
+  std::vector<frame_id_t> candidates;
+  for (const bool referenced : {false, true}) {
+    auto it = hand_cold_;
+    for (size_t steps = clock_.size(); steps > 0 && candidates.size() < max_count; steps--, it = Next(it)) {
+      if (it->frame_id_ != -1 && !it->hot_ && it->evictable_ && it->referenced_ == referenced) {
+        candidates.push_back(it->frame_id_);
+      }
+    }
+  }
+  return candidates;
+}
+
+void ClockProReplacer::CheckFrameId(frame_id_t frame_id) const {
+  BUSTUB_ENSURE(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+}
+
+auto ClockProReplacer::Next(EntryIter it) -> EntryIter {
+  ++it;
+  return it == clock_.end() ? clock_.begin() : it;
+}
+
+void ClockProReplacer::Erase(EntryIter it) {
+  if (clock_.size() == 1) {
+    clock_.clear();
+    hand_cold_ = hand_hot_ = hand_test_ = clock_.end();
+    return;
+  }
+  auto next = Next(it);
+  for (auto *hand : {&hand_cold_, &hand_hot_, &hand_test_}) {
+    if (*hand == it) {
+      *hand = next;
+    }
+  }
+  clock_.erase(it);
+}
+
+void ClockProReplacer::EraseResident(EntryIter it) {
+  frame_entry_[it->frame_id_] = clock_.end();
+  if (it->evictable_) {
+    evictable_count_--;
+  }
+  if (it->hot_) {
+    hot_count_--;
+  }
+  Erase(it);
+}
+
+void ClockProReplacer::RunHandHot() {
+  const size_t hot_limit = replacer_size_ - cold_target_;
+  // a hot page survives at most one pass of the hand, so two passes bring hot_count_ down to the limit
+  for (size_t steps = 2 * clock_.size(); hot_count_ > hot_limit && steps > 0; steps--) {
+    auto it = hand_hot_;
+    hand_hot_ = Next(hand_hot_);
+    if (it->frame_id_ == -1) {
+      // the hot hand ends the test period of every cold page it passes
+      non_resident_.erase(it->page_id_);
+      Erase(it);
+      cold_target_ = std::max<size_t>(cold_target_ - 1, 1);
+    } else if (!it->hot_) {
+      it->in_test_ = false;
+    } else if (it->referenced_) {
+      it->referenced_ = false;
+    } else {
+      it->hot_ = false;
+      hot_count_--;
+    }
+  }
+}
+
+void ClockProReplacer::RunHandTest() {
+  for (size_t steps = clock_.size(); steps > 0; steps--) {
+    auto it = hand_test_;
+    hand_test_ = Next(hand_test_);
+    if (it->frame_id_ == -1) {
+      non_resident_.erase(it->page_id_);
+      Erase(it);
+      cold_target_ = std::max<size_t>(cold_target_ - 1, 1);
+      return;
+    }
+    if (!it->hot_) {
+      it->in_test_ = false;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_page_table.cpp
+//
+// Identification: src/buffer/concurrent_page_table.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/concurrent_page_table.h"
+
+#include <vector>
+
+namespace bustub {
+
+ConcurrentPageTable::ConcurrentPageTable(size_t max_entries) : capacity_bits_(3) {
+  // Live entries use at most 1/4 of the slots and Insert rehashes once tombstones push the load past 1/2,
+  // so probe sequences stay short and rehashing happens at most once every capacity_ / 4 removals.
+  while ((static_cast<size_t>(1) << capacity_bits_) < 4 * max_entries) {
+    capacity_bits_++;
+  }
+  capacity_ = static_cast<size_t>(1) << capacity_bits_;
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+auto ConcurrentPageTable::Find(page_id_t page_id, frame_id_t &frame_id) const -> bool {
+  const size_t mask = capacity_ - 1;
+  size_t idx = HomeSlot(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & mask) {
+    const uint64_t slot = slots_[idx].load(std::memory_order_acquire);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (slot != TOMBSTONE_SLOT && KeyOf(slot) == page_id) {
+      frame_id = ValueOf(slot);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ConcurrentPageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot map an invalid page id");
+  if (2 * (num_entries_ + num_tombstones_ + 1) > capacity_) {
+    Rehash();
+  }
+
+  const size_t mask = capacity_ - 1;
+  size_t idx = HomeSlot(page_id);
+  size_t target = capacity_;
+  for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & mask) {
+    const uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      if (target == capacity_) {
+        target = idx;
+      }
+      break;
+    }
+    if (slot == TOMBSTONE_SLOT) {
+      if (target == capacity_) {
+        target = idx;
+      }
+      continue;
+    }
+    if (KeyOf(slot) == page_id) {
+      slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+      return;
+    }
+  }
+
+  BUSTUB_ASSERT(target != capacity_, "page table is full");
+  if (slots_[target].load(std::memory_order_relaxed) == TOMBSTONE_SLOT) {
+    num_tombstones_--;
+  }
+  slots_[target].store(Pack(page_id, frame_id), std::memory_order_release);
+  num_entries_++;
+}
+
+auto ConcurrentPageTable::Remove(page_id_t page_id) -> bool {
+  const size_t mask = capacity_ - 1;
+  size_t idx = HomeSlot(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & mask) {
+    const uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (slot != TOMBSTONE_SLOT && KeyOf(slot) == page_id) {
+      slots_[idx].store(TOMBSTONE_SLOT, std::memory_order_release);
+      num_entries_--;
+      num_tombstones_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ConcurrentPageTable::Rehash() {
+  // Lock-free readers that race with this may miss an entry, which only sends them to the latched slow path.
+  std::vector<uint64_t> live;
+  live.reserve(num_entries_);
+  for (size_t i = 0; i < capacity_; i++) {
+    const uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+    if (slot != EMPTY_SLOT && slot != TOMBSTONE_SLOT) {
+      live.push_back(slot);
+    }
+    slots_[i].store(EMPTY_SLOT, std::memory_order_release);
+  }
+  num_entries_ = 0;
+  num_tombstones_ = 0;
+
+  const size_t mask = capacity_ - 1;
+  for (auto slot : live) {
+    size_t idx = HomeSlot(KeyOf(slot));
+    while (slots_[idx].load(std::memory_order_relaxed) != EMPTY_SLOT) {
+      idx = (idx + 1) & mask;
+    }
+    slots_[idx].store(slot, std::memory_order_release);
+    num_entries_++;
+  }
+}
+
+}  // namespace bustub
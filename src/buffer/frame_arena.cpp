@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/exception.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, bool use_huge_pages) {
+  const size_t size = std::max<size_t>(num_frames, 1) * BUSTUB_PAGE_SIZE;
+  if (!use_huge_pages) {
+    mapping_size_ = size;
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping_ == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, fmt::format("cannot map {} bytes of frames", size));
+    }
+    data_ = static_cast<char *>(mapping_);
+    return;
+  }
+
+  const size_t huge_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+  mapping_ = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mapping_ != MAP_FAILED) {
+    mapping_size_ = huge_size;
+    data_ = static_cast<char *>(mapping_);
+    huge_tlb_ = true;
+    return;
+  }
+#endif
+
+  // no reserved huge pages: over-map by one huge page so the arena can start on a huge page boundary
+  mapping_size_ = huge_size + HUGE_PAGE_SIZE;
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping_ == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, fmt::format("cannot map {} bytes of frames", mapping_size_));
+  }
+  const auto start = reinterpret_cast<uintptr_t>(mapping_);
+  const uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  data_ = reinterpret_cast<char *>(aligned);
+#ifdef MADV_HUGEPAGE
+  // only advice, the arena works the same without transparent huge pages
+  madvise(data_, huge_size, MADV_HUGEPAGE);
+#endif
+}
+
+FrameArena::~FrameArena() { munmap(mapping_, mapping_size_); }
+
+}  // namespace bustub
@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_heap_replacer.cpp
+//
+// Identification: src/buffer/lru_k_heap_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_heap_replacer.h"
+
+#include <queue>
+#include <utility>
+
+namespace bustub {
+
+HeapLRUKReplacer::HeapLRUKReplacer(size_t num_frames, size_t k)
+    : replacer_size_(num_frames),
+      k_(k),
+      history_(num_frames * k),
+      access_count_(num_frames, 0),
+      heap_pos_(num_frames, NOT_IN_HEAP) {
+  BUSTUB_ASSERT(k > 0, "k must be positive");
+  heap_.reserve(num_frames);
+}
+
+auto HeapLRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (heap_.empty()) {
+    return false;
+  }
+  *frame_id = heap_.front();
+  HeapErase(*frame_id);
+  ResetFrame(*frame_id);
+  return true;
+}
+
+void HeapLRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto &count = access_count_[frame_id];
+  history_[frame_id * k_ + count % k_] = current_timestamp_++;
+  count++;
+
+  // a new access never moves a frame towards eviction: its k-th most recent access gets later, or it leaves the
+  // +inf group, so the frame can only sink in the heap
+  if (heap_pos_[frame_id] != NOT_IN_HEAP) {
+    SiftDown(heap_pos_[frame_id]);
+  }
+}
+
+void HeapLRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  if (access_count_[frame_id] == 0) {
+    return;
+  }
+  const bool is_evictable = heap_pos_[frame_id] != NOT_IN_HEAP;
+  if (set_evictable && !is_evictable) {
+    HeapPush(frame_id);
+  } else if (!set_evictable && is_evictable) {
+    HeapErase(frame_id);
+  }
+}
+
+void HeapLRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  if (access_count_[frame_id] == 0) {
+    return;
+  }
+  BUSTUB_ENSURE(heap_pos_[frame_id] != NOT_IN_HEAP, "cannot remove a non-evictable frame");
+  HeapErase(frame_id);
+  ResetFrame(frame_id);
+}
+
+auto HeapLRUKReplacer::Size() -> size_t {
+  std::lock_guard<std::mutex> guard(latch_);
+  return heap_.size();
+}
+
+auto HeapLRUKReplacer::EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> {
+  std::lock_guard<std::mutex> guard(latch_);
+  // best-first walk of the heap: the next victim is always the root or a child of a position already taken
+  auto later = [this](size_t a, size_t b) { return EvictsBefore(heap_[b], heap_[a]); };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(later)> frontier(later);
+  std::vector<frame_id_t> candidates;
+  if (!heap_.empty()) {
+    frontier.push(0);
+  }
+  while (!frontier.empty() && candidates.size() < max_count) {
+    const size_t pos = frontier.top();
+    frontier.pop();
+    candidates.push_back(heap_[pos]);
+    for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap_.size(); child++) {
+      frontier.push(child);
+    }
+  }
+  return candidates;
+}
+
+void HeapLRUKReplacer::CheckFrameId(frame_id_t frame_id) const {
+  BUSTUB_ENSURE(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+}
+
+auto HeapLRUKReplacer::KeyTimestamp(frame_id_t frame_id) const -> size_t {
+  const size_t count = access_count_[frame_id];
+  // with k or more accesses the oldest of the last k sits where the next access will be written,
+  // otherwise the ring buffer has not wrapped and the first access is at its start
+  const size_t slot = count >= k_ ? count % k_ : 0;
+  return history_[frame_id * k_ + slot];
+}
+
+auto HeapLRUKReplacer::EvictsBefore(frame_id_t a, frame_id_t b) const -> bool {
+  const bool a_inf = access_count_[a] < k_;
+  const bool b_inf = access_count_[b] < k_;
+  if (a_inf != b_inf) {
+    return a_inf;
+  }
+  return KeyTimestamp(a) < KeyTimestamp(b);
+}
+
+void HeapLRUKReplacer::HeapPush(frame_id_t frame_id) {
+  heap_pos_[frame_id] = heap_.size();
+  heap_.push_back(frame_id);
+  SiftUp(heap_.size() - 1);
+}
+
+void HeapLRUKReplacer::HeapErase(frame_id_t frame_id) {
+  const size_t pos = heap_pos_[frame_id];
+  const size_t last = heap_.size() - 1;
+  if (pos != last) {
+    HeapSwap(pos, last);
+  }
+  heap_.pop_back();
+  heap_pos_[frame_id] = NOT_IN_HEAP;
+  if (pos < heap_.size()) {
+    const frame_id_t moved = heap_[pos];
+    SiftUp(pos);
+    SiftDown(heap_pos_[moved]);
+  }
+}
+
+void HeapLRUKReplacer::SiftUp(size_t pos) {
+  while (pos > 0) {
+    const size_t parent = (pos - 1) / 2;
+    if (!EvictsBefore(heap_[pos], heap_[parent])) {
+      break;
+    }
+    HeapSwap(pos, parent);
+    pos = parent;
+  }
+}
+
+void HeapLRUKReplacer::SiftDown(size_t pos) {
+  const size_t size = heap_.size();
+  while (true) {
+    const size_t left = 2 * pos + 1;
+    if (left >= size) {
+      break;
+    }
+    size_t child = left;
+    if (left + 1 < size && EvictsBefore(heap_[left + 1], heap_[left])) {
+      child = left + 1;
+    }
+    if (!EvictsBefore(heap_[child], heap_[pos])) {
+      break;
+    }
+    HeapSwap(pos, child);
+    pos = child;
+  }
+}
+
+void HeapLRUKReplacer::HeapSwap(size_t a, size_t b) {
+  std::swap(heap_[a], heap_[b]);
+  heap_pos_[heap_[a]] = a;
+  heap_pos_[heap_[b]] = b;
+}
+
+void HeapLRUKReplacer::ResetFrame(frame_id_t frame_id) { access_count_[frame_id] = 0; }
+
+}  // namespace bustub
@@ -143,4 +143,18 @@ void LRUKReplacer::Remove(frame_id_t frame_id) {
 
 auto LRUKReplacer::Size() -> size_t { return current_size_; }
 
+auto LRUKReplacer::EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> {
+  std::lock_guard<std::mutex> guard(latch_);
+  // 与Evict相同的顺序：先history_list，再cache_list，都从尾部开始
+  std::vector<frame_id_t> candidates;
+  for (const auto *list : {&history_list_, &cache_list_}) {
+    for (auto it = list->rbegin(); it != list->rend() && candidates.size() < max_count; ++it) {
+      if (is_accessible_[*it]) {
+        candidates.push_back(*it);
+      }
+    }
+  }
+  return candidates;
+}
+
 }  // namespace bustub
@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <string>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     ReplacerType replacer_type)
+    : num_instances_(num_instances), pool_size_(pool_size) {
+  BUSTUB_ASSERT(num_instances > 0, "a parallel buffer pool needs at least one instance");
+  // Allocate and create individual BufferPoolManagerInstances
+  instances_.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    instances_.emplace_back(std::make_unique<BufferPoolManagerInstance>(
+        pool_size_, static_cast<uint32_t>(num_instances_), static_cast<uint32_t>(i), disk_manager, replacer_k,
+        log_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() = default;
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t { return num_instances_ * pool_size_; }
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
+  return instances_[static_cast<uint32_t>(page_id) % num_instances_].get();
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  // Create new page. We will request page allocation in a round robin manner from the underlying
+  // BufferPoolManagerInstances:
+  // 1. From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
+  // starting index and return nullptr
+  // 2. Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
+  // is called
+  const size_t start = next_instance_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    auto *page = instances_[(start + i) % num_instances_]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * {
+  const size_t start = static_cast<size_t>(near_page_id) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    auto *page = instances_[(start + i) % num_instances_]->NewPageNear(page_id, near_page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  for (auto &instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+void ParallelBufferPoolManager::RunBackgroundWriter() {
+  for (auto &instance : instances_) {
+    instance->RunBackgroundWriter();
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto &instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+void ParallelBufferPoolManager::SetWarmStartFile(const std::string &path) {
+  for (size_t i = 0; i < num_instances_; i++) {
+    instances_[i]->SetWarmStartFile(path + "." + std::to_string(i));
+  }
+}
+
+void ParallelBufferPoolManager::DumpResidentPages() {
+  for (auto &instance : instances_) {
+    instance->DumpResidentPages();
+  }
+}
+
+auto ParallelBufferPoolManager::WarmStart() -> size_t {
+  size_t num_pages = 0;
+  for (auto &instance : instances_) {
+    num_pages += instance->WarmStart();
+  }
+  return num_pages;
+}
+
+auto ParallelBufferPoolManager::GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (auto &instance : instances_) {
+    auto instance_dirty_pages = instance->GetDirtyPageTable();
+    dirty_pages.insert(dirty_pages.end(), instance_dirty_pages.begin(), instance_dirty_pages.end());
+  }
+  return dirty_pages;
+}
+
+void ParallelBufferPoolManager::PrefetchPgsImp(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> per_instance(num_instances_);
+  for (auto page_id : page_ids) {
+    per_instance[static_cast<size_t>(page_id) % num_instances_].push_back(page_id);
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    if (!per_instance[i].empty()) {
+      instances_[i]->PrefetchPages(per_instance[i]);
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_window.cpp
+//
+// Identification: src/buffer/read_ahead_window.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead_window.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iterator>
+
+namespace bustub {
+
+ReadAheadWindow::ReadAheadWindow(BufferPoolManager *bpm, size_t window, NextPageFn next_page_of)
+    : bpm_(bpm), window_(std::min(window, bpm->GetPoolSize() / 4)), next_page_of_(next_page_of) {}
+
+void ReadAheadWindow::Advance(page_id_t page_id, page_id_t next_page_id) {
+  if (window_ == 0) {
+    return;
+  }
+  if (fill_.valid()) {
+    if (fill_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return;
+    }
+    const auto &filled = fill_.get();
+    pages_.insert(pages_.end(), filled.begin(), filled.end());
+    fill_ = {};
+  }
+  // forget the pages up to the current one, or everything if the scan left the chain that was read ahead
+  auto reached = std::find(pages_.begin(), pages_.end(), page_id);
+  pages_.erase(pages_.begin(), reached == pages_.end() ? reached : std::next(reached));
+
+  if (pages_.empty()) {
+    if (next_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    bpm_->PrefetchPages({next_page_id});
+    pages_.push_back(next_page_id);
+    // the read of next_page_id was just queued, following its link now would wait for it
+    fill_ = std::async(std::launch::async, [bpm = bpm_, next_page_of = next_page_of_, first_page_id = next_page_id,
+                                           count = window_ - 1] {
+              std::vector<page_id_t> filled;
+              for (page_id_t cur_page_id = first_page_id; filled.size() < count;) {
+                Page *page = bpm->FetchPage(cur_page_id);
+                if (page == nullptr) {
+                  break;
+                }
+                // the task holds no other latch, so it may block
+                page->RLatch();
+                cur_page_id = next_page_of(page);
+                page->RUnlatch();
+                bpm->UnpinPage(page->GetPageId(), false);
+                if (cur_page_id == INVALID_PAGE_ID) {
+                  break;
+                }
+                bpm->PrefetchPages({cur_page_id});
+                filled.push_back(cur_page_id);
+              }
+              return filled;
+            }).share();
+    return;
+  }
+  while (pages_.size() < window_) {
+    const page_id_t last_page_id = pages_.back();
+    Page *last_page = bpm_->FetchPage(last_page_id);
+    if (last_page == nullptr) {
+      return;
+    }
+    // the caller holds a page latch, so never block on another one
+    if (!last_page->TryRLatch()) {
+      bpm_->UnpinPage(last_page_id, false);
+      return;
+    }
+    const page_id_t after_last_page_id = next_page_of_(last_page);
+    last_page->RUnlatch();
+    bpm_->UnpinPage(last_page_id, false);
+    if (after_last_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    bpm_->PrefetchPages({after_last_page_id});
+    pages_.push_back(after_last_page_id);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer.cpp
+//
+// Identification: src/buffer/replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacer.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_pro_replacer.h"
+#include "buffer/lru_k_heap_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+auto Replacer::Create(ReplacerType type, size_t num_frames, size_t k) -> std::unique_ptr<Replacer> {
+  switch (type) {
+    case ReplacerType::LRUK:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+    case ReplacerType::HEAP_LRUK:
+      return std::make_unique<HeapLRUKReplacer>(num_frames, k);
+    case ReplacerType::TWO_Q:
+      return std::make_unique<TwoQReplacer>(num_frames);
+    case ReplacerType::ARC:
+      return std::make_unique<ARCReplacer>(num_frames);
+    case ReplacerType::CLOCK_PRO:
+      return std::make_unique<ClockProReplacer>(num_frames);
+  }
+  UNREACHABLE("unknown replacer type");
+}
+
+auto Replacer::ParseType(const std::string &name, ReplacerType *type) -> bool {
+  if (name == "lru_k") {
+    *type = ReplacerType::LRUK;
+  } else if (name == "heap_lru_k") {
+    *type = ReplacerType::HEAP_LRUK;
+  } else if (name == "2q") {
+    *type = ReplacerType::TWO_Q;
+  } else if (name == "arc") {
+    *type = ReplacerType::ARC;
+  } else if (name == "clock_pro") {
+    *type = ReplacerType::CLOCK_PRO;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.cpp
+//
+// Identification: src/buffer/two_q_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+TwoQReplacer::TwoQReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      kin_(std::max<size_t>(num_frames / 4, 1)),
+      kout_(std::max<size_t>(num_frames / 2, 1)),
+      frames_(num_frames) {}
+
+auto TwoQReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> guard(latch_);
+  // take from A1in while it is over its target, so Am keeps the rest of the pool; fall back to the other queue if
+  // every frame in the preferred one is pinned
+  const bool found = a1in_.size() > kin_ ? EvictFrom(&a1in_, frame_id) || EvictFrom(&am_, frame_id)
+                                         : EvictFrom(&am_, frame_id) || EvictFrom(&a1in_, frame_id);
+  if (!found) {
+    return false;
+  }
+
+  auto &info = frames_[*frame_id];
+  if (info.queue_ == Queue::A1IN && info.page_id_ != INVALID_PAGE_ID) {
+    a1out_.push_front(info.page_id_);
+    a1out_map_[info.page_id_] = a1out_.begin();
+    if (a1out_.size() > kout_) {
+      a1out_map_.erase(a1out_.back());
+      a1out_.pop_back();
+    }
+  }
+  Untrack(*frame_id);
+  return true;
+}
+
+void TwoQReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto &info = frames_[frame_id];
+  switch (info.queue_) {
+    case Queue::NONE:
+      a1in_.push_front(frame_id);
+      info.queue_ = Queue::A1IN;
+      info.pos_ = a1in_.begin();
+      break;
+    case Queue::AM:
+      am_.splice(am_.begin(), am_, info.pos_);
+      break;
+    case Queue::A1IN:
+      // correlated references while in A1in do not count as reuse
+      break;
+  }
+}
+
+void TwoQReplacer::RecordLoad(frame_id_t frame_id, page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto &info = frames_[frame_id];
+  if (info.queue_ == Queue::NONE) {
+    return;
+  }
+  info.page_id_ = page_id;
+  auto ghost = a1out_map_.find(page_id);
+  if (ghost == a1out_map_.end()) {
+    return;
+  }
+  a1out_.erase(ghost->second);
+  a1out_map_.erase(ghost);
+  if (info.queue_ == Queue::A1IN) {
+    am_.splice(am_.begin(), a1in_, info.pos_);
+    info.queue_ = Queue::AM;
+  }
+}
+
+void TwoQReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  auto &info = frames_[frame_id];
+  if (info.queue_ == Queue::NONE || info.evictable_ == set_evictable) {
+    return;
+  }
+  info.evictable_ = set_evictable;
+  if (set_evictable) {
+    evictable_count_++;
+  } else {
+    evictable_count_--;
+  }
+}
+
+void TwoQReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  CheckFrameId(frame_id);
+  if (frames_[frame_id].queue_ == Queue::NONE) {
+    return;
+  }
+  BUSTUB_ENSURE(frames_[frame_id].evictable_, "cannot remove a non-evictable frame");
+  Untrack(frame_id);
+}
+
+auto TwoQReplacer::Size() -> size_t {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_count_;
+}
+
+auto TwoQReplacer::EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<frame_id_t> candidates;
+  const bool prefer_a1in = a1in_.size() > kin_;
+  for (const auto *list : {prefer_a1in ? &a1in_ : &am_, prefer_a1in ? &am_ : &a1in_}) {
+    for (auto it = list->rbegin(); it != list->rend() && candidates.size() < max_count; ++it) {
+      if (frames_[*it].evictable_) {
+        candidates.push_back(*it);
+      }
+    }
+  }
+  return candidates;
+}
+
+void TwoQReplacer::CheckFrameId(frame_id_t frame_id) const {
+  BUSTUB_ENSURE(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+}
+
+auto TwoQReplacer::EvictFrom(std::list<frame_id_t> *list, frame_id_t *frame_id) -> bool {
+  for (auto it = list->rbegin(); it != list->rend(); ++it) {
+    if (frames_[*it].evictable_) {
+      *frame_id = *it;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TwoQReplacer::Untrack(frame_id_t frame_id) {
+  auto &info = frames_[frame_id];
+  (info.queue_ == Queue::A1IN ? a1in_ : am_).erase(info.pos_);
+  if (info.evictable_) {
+    evictable_count_--;
+  }
+  info = FrameInfo{};
+}
+
+}  // namespace bustub
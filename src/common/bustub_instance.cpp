@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <optional>
 #include <shared_mutex>
 #include <string>
@@ -12,6 +13,7 @@
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
 #include "common/bustub_instance.h"
@@ -33,6 +35,7 @@
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_manager_uring.h"
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -41,27 +44,44 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn) -> std::unique_ptr<Ex
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+BustubInstance::BustubInstance(const std::string &db_file_name, size_t bpm_instances, ReplacerType replacer_type,
+                               DeadlockPolicy deadlock_policy) {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  disk_manager_ = new DiskManagerUring(db_file_name);
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
 
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
+  // With more than one instance, the 128 frames are split evenly across the shards, each keeping at least one.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    if (bpm_instances > 1) {
+      buffer_pool_manager_ =
+          new ParallelBufferPoolManager(bpm_instances, std::max<size_t>(128 / bpm_instances, 1), disk_manager_,
+                                        LRUK_REPLACER_K, log_manager_, replacer_type);
+    } else {
+      buffer_pool_manager_ =
+          new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_, replacer_type);
+    }
+    // reload the pages that were resident at the last shutdown before serving queries
+    buffer_pool_manager_->SetWarmStartFile(db_file_name + ".warm");
+    buffer_pool_manager_->WarmStart();
+    // pages go to a real file, keep write-back off the miss path
+    buffer_pool_manager_->RunBackgroundWriter();
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
   }
 
   // Transaction (txn) related.
-  lock_manager_ = new LockManager();
+  lock_manager_ = new LockManager(deadlock_policy);
   txn_manager_ = new TransactionManager(lock_manager_, log_manager_);
+  // drop the versions left behind by long snapshot transactions
+  txn_manager_->RunGarbageCollector();
+  txn_manager_->GetOccManager()->RunEpochAdvancer();
 
   // Checkpoint related.
   checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_);
@@ -73,7 +93,7 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
 }
 
-BustubInstance::BustubInstance() {
+BustubInstance::BustubInstance(size_t bpm_instances, ReplacerType replacer_type, DeadlockPolicy deadlock_policy) {
   enable_logging = false;
 
   // Storage related.
@@ -84,16 +104,27 @@ BustubInstance::BustubInstance() {
 
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
+  // With more than one instance, the 128 frames are split evenly across the shards, each keeping at least one.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    if (bpm_instances > 1) {
+      buffer_pool_manager_ =
+          new ParallelBufferPoolManager(bpm_instances, std::max<size_t>(128 / bpm_instances, 1), disk_manager_,
+                                        LRUK_REPLACER_K, log_manager_, replacer_type);
+    } else {
+      buffer_pool_manager_ =
+          new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_, replacer_type);
+    }
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
   }
 
   // Transaction (txn) related.
-  lock_manager_ = new LockManager();
+  lock_manager_ = new LockManager(deadlock_policy);
   txn_manager_ = new TransactionManager(lock_manager_, log_manager_);
+  // drop the versions left behind by long snapshot transactions
+  txn_manager_->RunGarbageCollector();
+  txn_manager_->GetOccManager()->RunEpochAdvancer();
 
   // Checkpoint related.
   checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_);
@@ -176,7 +207,7 @@ auto BustubInstance::ExecuteSql(const std::string &sql, ResultWriter &writer) ->
   auto txn = txn_manager_->Begin();
   auto result = ExecuteSqlTxn(sql, writer, txn);
   txn_manager_->Commit(txn);
-  delete txn;
+  txn_manager_->Recycle(txn);
   return result;
 }
 
@@ -365,7 +396,7 @@ void BustubInstance::GenerateTestTable() {
   l.unlock();
 
   txn_manager_->Commit(txn);
-  delete txn;
+  txn_manager_->Recycle(txn);
 }
 
 /**
@@ -384,13 +415,19 @@ void BustubInstance::GenerateMockTable() {
   l.unlock();
 
   txn_manager_->Commit(txn);
-  delete txn;
+  txn_manager_->Recycle(txn);
 }
 
 BustubInstance::~BustubInstance() {
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
+  txn_manager_->StopGarbageCollector();
+  txn_manager_->GetOccManager()->StopEpochAdvancer();
+  if (buffer_pool_manager_ != nullptr) {
+    buffer_pool_manager_->StopBackgroundWriter();
+    buffer_pool_manager_->DumpResidentPages();
+  }
   delete execution_engine_;
   delete catalog_;
   delete checkpoint_manager_;
@@ -20,4 +20,24 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::atomic<size_t> scan_prefetch_window(8);
+
+std::atomic<bool> enable_huge_page_frames(false);
+
+std::chrono::milliseconds bg_writer_interval = std::chrono::milliseconds(100);
+
+std::atomic<bool> enable_direct_io(false);
+
+std::atomic<bool> enable_segment_preallocation(false);
+
+std::chrono::milliseconds warm_start_dump_interval = std::chrono::seconds(60);
+
+std::atomic<size_t> lock_escalation_threshold(5000);
+
+std::chrono::milliseconds version_gc_interval = std::chrono::milliseconds(100);
+
+std::chrono::milliseconds occ_epoch_interval = std::chrono::milliseconds(40);
+
+std::atomic<double> bulk_load_fill_factor(0.9);
+
 }  // namespace bustub
@@ -12,37 +12,636 @@
 
 #include "concurrency/lock_manager.h"
 
+#include <algorithm>
+
 #include "common/config.h"
+#include "common/macros.h"
+#include "common/util/hash_util.h"
 #include "concurrency/transaction.h"
 #include "concurrency/transaction_manager.h"
 
 namespace bustub {
 
-auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool { return true; }
+auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    // wounded by an older transaction, or picked by the cycle detection
+    return false;
+  }
+  CheckLockAllowed(txn, lock_mode);
+
+  std::unique_lock<std::mutex> map_lock(table_lock_map_latch_);
+  auto &queue = table_lock_map_[oid];
+  if (queue == nullptr) {
+    queue = std::make_shared<LockRequestQueue>();
+  }
+  // the queue stays in the map, tables are few
+  std::shared_ptr<LockRequestQueue> table_queue = queue;
+  std::unique_lock<std::mutex> lock(table_queue->latch_);
+  map_lock.unlock();
+  return Acquire(txn, lock_mode, table_queue, &lock, oid, nullptr);
+}
 
-auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool { return true; }
+auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool {
+  for (const auto &row_lock_set : {txn->GetSharedRowLockSet(), txn->GetExclusiveRowLockSet()}) {
+    auto rows = row_lock_set->find(oid);
+    if (rows != row_lock_set->end() && !rows->second.empty()) {
+      AbortTransaction(txn, AbortReason::TABLE_UNLOCKED_BEFORE_UNLOCKING_ROWS);
+    }
+  }
+
+  std::unique_lock<std::mutex> map_lock(table_lock_map_latch_);
+  auto queue = table_lock_map_.find(oid);
+  if (queue == table_lock_map_.end()) {
+    map_lock.unlock();
+    AbortTransaction(txn, AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
+  }
+  LockRequestQueue *table_queue = queue->second.get();
+  const std::lock_guard<std::mutex> guard(table_queue->latch_);
+  map_lock.unlock();
+  Release(txn, table_queue, nullptr, true);
+  txn->GetEscalatedTableSet()->erase(oid);
+  return true;
+}
 
 auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (lock_mode != LockMode::SHARED && lock_mode != LockMode::EXCLUSIVE) {
+    AbortTransaction(txn, AbortReason::ATTEMPTED_INTENTION_LOCK_ON_ROW);
+  }
+  CheckLockAllowed(txn, lock_mode);
+  const bool table_locked =
+      lock_mode == LockMode::EXCLUSIVE
+          ? txn->IsTableExclusiveLocked(oid) || txn->IsTableIntentionExclusiveLocked(oid) ||
+                txn->IsTableSharedIntentionExclusiveLocked(oid)
+          : txn->IsTableExclusiveLocked(oid) || txn->IsTableIntentionExclusiveLocked(oid) ||
+                txn->IsTableSharedIntentionExclusiveLocked(oid) || txn->IsTableSharedLocked(oid) ||
+                txn->IsTableIntentionSharedLocked(oid);
+  if (!table_locked) {
+    AbortTransaction(txn, AbortReason::TABLE_LOCK_NOT_PRESENT);
+  }
+  if (txn->IsTableEscalated(oid) &&
+      (txn->IsTableExclusiveLocked(oid) ||
+       (lock_mode == LockMode::SHARED &&
+        (txn->IsTableSharedLocked(oid) || txn->IsTableSharedIntentionExclusiveLocked(oid))))) {
+    // the table lock the row locks were escalated to covers this row
+    return true;
+  }
+
+  RowLockBucket &bucket = BucketOf(oid, rid);
+  std::unique_lock<std::mutex> bucket_lock(bucket.latch_);
+  auto &queue = bucket.row_lock_map_[rid];
+  if (queue == nullptr) {
+    queue = std::make_shared<LockRequestQueue>();
+  }
+  // the request keeps the queue from being dropped once the bucket latch is released
+  std::shared_ptr<LockRequestQueue> row_queue = queue;
+  std::unique_lock<std::mutex> lock(row_queue->latch_);
+  bucket_lock.unlock();
+  if (!Acquire(txn, lock_mode, row_queue, &lock, oid, &rid)) {
+    if (row_queue->request_queue_.empty()) {
+      // drop the queue this request created, latches are taken bucket first
+      lock.unlock();
+      bucket_lock.lock();
+      lock.lock();
+      auto current = bucket.row_lock_map_.find(rid);
+      if (row_queue->request_queue_.empty() && current != bucket.row_lock_map_.end() && current->second == row_queue) {
+        bucket.row_lock_map_.erase(current);
+      }
+    }
+    return false;
+  }
+  lock.unlock();
+  TryEscalate(txn, oid);
+  return true;
+}
+
+auto LockManager::UnlockRow(Transaction *txn, const table_oid_t &oid, const RID &rid) -> bool {
+  if (txn->IsTableEscalated(oid) && !txn->IsRowSharedLocked(oid, rid) && !txn->IsRowExclusiveLocked(oid, rid)) {
+    // given up for the table lock, which is released with the table
+    return true;
+  }
+  if (!ReleaseRow(txn, oid, rid, true)) {
+    AbortTransaction(txn, AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
+  }
+  return true;
+}
+
+auto LockManager::ReleaseRow(Transaction *txn, const table_oid_t &oid, const RID &rid, bool update_state) -> bool {
+  RowLockBucket &bucket = BucketOf(oid, rid);
+  const std::lock_guard<std::mutex> bucket_guard(bucket.latch_);
+  auto queue = bucket.row_lock_map_.find(rid);
+  if (queue == bucket.row_lock_map_.end()) {
+    return false;
+  }
+  std::shared_ptr<LockRequestQueue> row_queue = queue->second;
+  const std::lock_guard<std::mutex> guard(row_queue->latch_);
+  Release(txn, row_queue.get(), &rid, update_state);
+  // without requests left, nobody can be waiting on the queue, and the next lock creates a new one
+  if (row_queue->request_queue_.empty()) {
+    bucket.row_lock_map_.erase(queue);
+  }
+  return true;
+}
+
+void LockManager::TryEscalate(Transaction *txn, const table_oid_t &oid) {
+  const size_t threshold = lock_escalation_threshold;
+  if (threshold == 0 || txn->GetState() != TransactionState::GROWING) {
+    return;
+  }
+  size_t num_row_locks = 0;
+  for (const auto &row_lock_set : {txn->GetSharedRowLockSet(), txn->GetExclusiveRowLockSet()}) {
+    auto rows = row_lock_set->find(oid);
+    if (rows != row_lock_set->end()) {
+      num_row_locks += rows->second.size();
+    }
+  }
+  // after a failed attempt, the next one comes once as many row locks more are held
+  if (num_row_locks == 0 || num_row_locks % threshold != 0) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> map_lock(table_lock_map_latch_);
+  std::shared_ptr<LockRequestQueue> queue = table_lock_map_[oid];
+  std::unique_lock<std::mutex> lock(queue->latch_);
+  map_lock.unlock();
+  auto &requests = queue->request_queue_;
+  auto held = std::find_if(requests.begin(), requests.end(), [&](const LockRequest *request) {
+    return request->txn_id_ == txn->GetTransactionId() && request->granted_;
+  });
+  BUSTUB_ASSERT(held != requests.end(), "a row lock needs a table lock");
+
+  // the weakest table lock that covers every row lock, on top of the intention lock held
+  auto rows = txn->GetExclusiveRowLockSet()->find(oid);
+  const bool exclusive = rows != txn->GetExclusiveRowLockSet()->end() && !rows->second.empty();
+  LockMode lock_mode = (*held)->lock_mode_;
+  if (exclusive) {
+    lock_mode = LockMode::EXCLUSIVE;
+  } else if (lock_mode == LockMode::INTENTION_SHARED) {
+    lock_mode = LockMode::SHARED;
+  } else if (lock_mode == LockMode::INTENTION_EXCLUSIVE) {
+    lock_mode = LockMode::SHARED_INTENTION_EXCLUSIVE;
+  }
+  if (lock_mode != (*held)->lock_mode_) {
+    // escalation never waits, if another transaction has a lock in the way the row locks are kept
+    if (queue->upgrading_ != INVALID_TXN_ID) {
+      return;
+    }
+    for (const LockRequest *other : requests) {
+      if (other != *held && other->granted_ && !AreCompatible(other->lock_mode_, lock_mode)) {
+        return;
+      }
+    }
+    UpdateLockSet(txn, *held, false, false);
+    (*held)->lock_mode_ = lock_mode;
+    UpdateLockSet(txn, *held, false, true);
+  }
+  lock.unlock();
+
+  for (const auto &row_lock_set : {txn->GetSharedRowLockSet(), txn->GetExclusiveRowLockSet()}) {
+    auto table_rows = row_lock_set->find(oid);
+    if (table_rows == row_lock_set->end()) {
+      continue;
+    }
+    const std::vector<RID> rids(table_rows->second.begin(), table_rows->second.end());
+    for (const RID &rid : rids) {
+      ReleaseRow(txn, oid, rid, false);
+    }
+  }
+  txn->GetEscalatedTableSet()->insert(oid);
+  num_escalations_++;
+}
+
+auto LockManager::ParseDeadlockPolicy(const std::string &name, DeadlockPolicy *policy) -> bool {
+  if (name == "detection") {
+    *policy = DeadlockPolicy::DETECTION;
+  } else if (name == "wound_wait") {
+    *policy = DeadlockPolicy::WOUND_WAIT;
+  } else if (name == "wait_die") {
+    *policy = DeadlockPolicy::WAIT_DIE;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+auto LockManager::BucketOf(const table_oid_t &oid, const RID &rid) -> RowLockBucket & {
+  const hash_t hash = HashUtil::CombineHashes(std::hash<table_oid_t>()(oid), std::hash<RID>()(rid));
+  return row_lock_buckets_[hash % LOCK_TABLE_BUCKETS];
+}
+
+void LockManager::CheckLockAllowed(Transaction *txn, LockMode lock_mode) {
+  const bool is_shared = lock_mode == LockMode::SHARED || lock_mode == LockMode::INTENTION_SHARED ||
+                         lock_mode == LockMode::SHARED_INTENTION_EXCLUSIVE;
+  const bool shrinking = txn->GetState() == TransactionState::SHRINKING;
+  switch (txn->GetIsolationLevel()) {
+    case IsolationLevel::READ_UNCOMMITTED:
+      if (is_shared) {
+        AbortTransaction(txn, AbortReason::LOCK_SHARED_ON_READ_UNCOMMITTED);
+      }
+      if (shrinking) {
+        AbortTransaction(txn, AbortReason::LOCK_ON_SHRINKING);
+      }
+      break;
+    case IsolationLevel::READ_COMMITTED:
+      if (shrinking && lock_mode != LockMode::SHARED && lock_mode != LockMode::INTENTION_SHARED) {
+        AbortTransaction(txn, AbortReason::LOCK_ON_SHRINKING);
+      }
+      break;
+    case IsolationLevel::REPEATABLE_READ:
+    case IsolationLevel::OPTIMISTIC:
+      if (shrinking) {
+        AbortTransaction(txn, AbortReason::LOCK_ON_SHRINKING);
+      }
+      break;
+    case IsolationLevel::SNAPSHOT_ISOLATION:
+      // a snapshot reads without locks, and never writes
+      if (lock_mode != LockMode::SHARED && lock_mode != LockMode::INTENTION_SHARED) {
+        AbortTransaction(txn, AbortReason::LOCK_EXCLUSIVE_ON_SNAPSHOT_ISOLATION);
+      }
+      if (shrinking) {
+        AbortTransaction(txn, AbortReason::LOCK_ON_SHRINKING);
+      }
+      break;
+  }
+}
+
+auto LockManager::Acquire(Transaction *txn, LockMode lock_mode, const std::shared_ptr<LockRequestQueue> &queue,
+                          std::unique_lock<std::mutex> *lock, const table_oid_t &oid, const RID *rid) -> bool {
+  const txn_id_t txn_id = txn->GetTransactionId();
+  auto &requests = queue->request_queue_;
+  auto insert_at = requests.end();
+  auto held = std::find_if(requests.begin(), requests.end(),
+                           [&](const LockRequest *request) { return request->txn_id_ == txn_id; });
+  if (held != requests.end()) {
+    if ((*held)->lock_mode_ == lock_mode) {
+      return true;
+    }
+    if (queue->upgrading_ != INVALID_TXN_ID) {
+      AbortTransaction(txn, AbortReason::UPGRADE_CONFLICT);
+    }
+    if (!CanUpgrade((*held)->lock_mode_, lock_mode)) {
+      AbortTransaction(txn, AbortReason::INCOMPATIBLE_UPGRADE);
+    }
+    // drop the old lock and wait ahead of every request that is still waiting
+    UpdateLockSet(txn, *held, rid != nullptr, false);
+    PoolOf(txn)->Delete(*held);
+    requests.erase(held);
+    insert_at = std::find_if(requests.begin(), requests.end(),
+                             [](const LockRequest *request) { return !request->granted_; });
+    queue->upgrading_ = txn_id;
+  }
+
+  LockRequest *request =
+      rid == nullptr ? PoolOf(txn)->New(txn_id, lock_mode, oid) : PoolOf(txn)->New(txn_id, lock_mode, oid, *rid);
+  auto position = requests.insert(insert_at, request);
+  const bool must_wait = !IsGrantable(*queue, request);
+  if (must_wait) {
+    // registered before the state is checked, so that whoever aborts txn afterwards finds it
+    const std::lock_guard<std::mutex> guard(waiting_on_latch_);
+    waiting_on_[txn_id] = queue;
+  }
+  while (txn->GetState() != TransactionState::ABORTED && !IsGrantable(*queue, request)) {
+    std::vector<txn_id_t> wounded;
+    PreventDeadlock(txn, *queue, request, &wounded);
+    if (!wounded.empty()) {
+      // the wounded requests waiting in this queue leave it, the others have to be woken up wherever they wait
+      queue->cv_.notify_all();
+      lock->unlock();
+      for (auto victim : wounded) {
+        WakeUp(victim);
+      }
+      lock->lock();
+      continue;
+    }
+    if (txn->GetState() != TransactionState::ABORTED) {
+      queue->cv_.wait(*lock);
+    }
+  }
+  if (must_wait) {
+    const std::lock_guard<std::mutex> guard(waiting_on_latch_);
+    waiting_on_.erase(txn_id);
+  }
+  if (queue->upgrading_ == txn_id) {
+    queue->upgrading_ = INVALID_TXN_ID;
+  }
+  if (txn->GetState() == TransactionState::ABORTED) {
+    requests.erase(position);
+    PoolOf(txn)->Delete(request);
+    // the requests behind this one may be grantable now
+    queue->cv_.notify_all();
+    return false;
+  }
+  request->granted_ = true;
+  UpdateLockSet(txn, request, rid != nullptr, true);
   return true;
 }
 
-auto LockManager::UnlockRow(Transaction *txn, const table_oid_t &oid, const RID &rid) -> bool { return true; }
+void LockManager::Release(Transaction *txn, LockRequestQueue *queue, const RID *rid, bool update_state) {
+  auto &requests = queue->request_queue_;
+  auto held = std::find_if(requests.begin(), requests.end(), [&](const LockRequest *request) {
+    return request->txn_id_ == txn->GetTransactionId() && request->granted_;
+  });
+  if (held == requests.end()) {
+    AbortTransaction(txn, AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
+  }
+  LockRequest *request = *held;
+  requests.erase(held);
+  queue->cv_.notify_all();
+
+  if (update_state && txn->GetState() == TransactionState::GROWING) {
+    const bool shrinks =
+        request->lock_mode_ == LockMode::EXCLUSIVE ||
+        (request->lock_mode_ == LockMode::SHARED && txn->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ);
+    if (shrinks) {
+      txn->SetState(TransactionState::SHRINKING);
+    }
+  }
+  UpdateLockSet(txn, request, rid != nullptr, false);
+  PoolOf(txn)->Delete(request);
+}
 
-void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {}
+void LockManager::PreventDeadlock(Transaction *txn, const LockRequestQueue &queue, const LockRequest *request,
+                                  std::vector<txn_id_t> *wounded) {
+  if (deadlock_policy_ == DeadlockPolicy::DETECTION) {
+    return;
+  }
+  for (const LockRequest *other : queue.request_queue_) {
+    if (other == request) {
+      return;
+    }
+    if (AreCompatible(other->lock_mode_, request->lock_mode_)) {
+      continue;
+    }
+    // a smaller id is an older transaction
+    if (other->txn_id_ < request->txn_id_) {
+      if (deadlock_policy_ == DeadlockPolicy::WAIT_DIE) {
+        txn->SetState(TransactionState::ABORTED);
+        return;
+      }
+    } else if (deadlock_policy_ == DeadlockPolicy::WOUND_WAIT &&
+               TransactionManager::GetTransaction(other->txn_id_)->MarkAborted()) {
+      wounded->push_back(other->txn_id_);
+    }
+  }
+}
 
-void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {}
+void LockManager::WakeUp(txn_id_t txn_id) {
+  std::shared_ptr<LockRequestQueue> queue;
+  {
+    const std::lock_guard<std::mutex> guard(waiting_on_latch_);
+    auto waiting = waiting_on_.find(txn_id);
+    if (waiting == waiting_on_.end()) {
+      // a running transaction notices at its next lock
+      return;
+    }
+    queue = waiting->second;
+  }
+  const std::lock_guard<std::mutex> guard(queue->latch_);
+  queue->cv_.notify_all();
+}
 
-auto LockManager::HasCycle(txn_id_t *txn_id) -> bool { return false; }
+auto LockManager::IsGrantable(const LockRequestQueue &queue, const LockRequest *request) -> bool {
+  // granted requests are always at the front, the waiting ones ahead of request are served first
+  for (const LockRequest *other : queue.request_queue_) {
+    if (other == request) {
+      return true;
+    }
+    if (!AreCompatible(other->lock_mode_, request->lock_mode_)) {
+      return false;
+    }
+  }
+  UNREACHABLE("the request is in the queue");
+}
+
+auto LockManager::AreCompatible(LockMode held, LockMode requested) -> bool {
+  switch (held) {
+    case LockMode::INTENTION_SHARED:
+      return requested != LockMode::EXCLUSIVE;
+    case LockMode::INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::INTENTION_EXCLUSIVE;
+    case LockMode::SHARED:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::SHARED;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED;
+    case LockMode::EXCLUSIVE:
+      return false;
+  }
+  UNREACHABLE("unknown lock mode");
+}
+
+auto LockManager::CanUpgrade(LockMode from, LockMode to) -> bool {
+  switch (from) {
+    case LockMode::INTENTION_SHARED:
+      return true;
+    case LockMode::SHARED:
+    case LockMode::INTENTION_EXCLUSIVE:
+      return to == LockMode::EXCLUSIVE || to == LockMode::SHARED_INTENTION_EXCLUSIVE;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return to == LockMode::EXCLUSIVE;
+    case LockMode::EXCLUSIVE:
+      return false;
+  }
+  UNREACHABLE("unknown lock mode");
+}
+
+void LockManager::UpdateLockSet(Transaction *txn, const LockRequest *request, bool is_row, bool insert) {
+  if (is_row) {
+    auto row_lock_set =
+        request->lock_mode_ == LockMode::SHARED ? txn->GetSharedRowLockSet() : txn->GetExclusiveRowLockSet();
+    if (insert) {
+      (*row_lock_set)[request->oid_].insert(request->rid_);
+    } else {
+      (*row_lock_set)[request->oid_].erase(request->rid_);
+    }
+    return;
+  }
+
+  TableLockSet *table_lock_set = nullptr;
+  switch (request->lock_mode_) {
+    case LockMode::SHARED:
+      table_lock_set = txn->GetSharedTableLockSet();
+      break;
+    case LockMode::EXCLUSIVE:
+      table_lock_set = txn->GetExclusiveTableLockSet();
+      break;
+    case LockMode::INTENTION_SHARED:
+      table_lock_set = txn->GetIntentionSharedTableLockSet();
+      break;
+    case LockMode::INTENTION_EXCLUSIVE:
+      table_lock_set = txn->GetIntentionExclusiveTableLockSet();
+      break;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      table_lock_set = txn->GetSharedIntentionExclusiveTableLockSet();
+      break;
+  }
+  if (insert) {
+    table_lock_set->insert(request->oid_);
+  } else {
+    table_lock_set->erase(request->oid_);
+  }
+}
+
+void LockManager::AbortTransaction(Transaction *txn, AbortReason reason) {
+  txn->SetState(TransactionState::ABORTED);
+  throw TransactionAbortException(txn->GetTransactionId(), reason);
+}
+
+auto LockManager::PoolOf(Transaction *txn) -> LockRequestPool * {
+  if (txn->GetLockRequestPool() == nullptr) {
+    txn->SetLockRequestPool(std::make_shared<LockRequestPool>());
+  }
+  return txn->GetLockRequestPool();
+}
+
+void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {
+  const std::lock_guard<std::mutex> guard(waits_for_latch_);
+  auto &edges = waits_for_[t1];
+  auto edge = std::lower_bound(edges.begin(), edges.end(), t2);
+  if (edge == edges.end() || *edge != t2) {
+    edges.insert(edge, t2);
+  }
+}
+
+void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {
+  const std::lock_guard<std::mutex> guard(waits_for_latch_);
+  auto edges = waits_for_.find(t1);
+  if (edges == waits_for_.end()) {
+    return;
+  }
+  auto edge = std::lower_bound(edges->second.begin(), edges->second.end(), t2);
+  if (edge != edges->second.end() && *edge == t2) {
+    edges->second.erase(edge);
+  }
+  if (edges->second.empty()) {
+    waits_for_.erase(edges);
+  }
+}
+
+auto LockManager::HasCycle(txn_id_t *txn_id) -> bool {
+  const std::lock_guard<std::mutex> guard(waits_for_latch_);
+  std::vector<txn_id_t> txn_ids;
+  txn_ids.reserve(waits_for_.size());
+  for (const auto &[waiter, edges] : waits_for_) {
+    txn_ids.push_back(waiter);
+  }
+  // start from the oldest transaction, so that the same graph always gives the same victim
+  std::sort(txn_ids.begin(), txn_ids.end());
+  std::unordered_set<txn_id_t> visited;
+  std::vector<txn_id_t> path;
+  for (auto waiter : txn_ids) {
+    if (visited.count(waiter) == 0 && FindCycle(waiter, &path, &visited, txn_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto LockManager::FindCycle(txn_id_t txn_id, std::vector<txn_id_t> *path, std::unordered_set<txn_id_t> *visited,
+                            txn_id_t *newest) -> bool {
+  visited->insert(txn_id);
+  path->push_back(txn_id);
+  auto edges = waits_for_.find(txn_id);
+  if (edges != waits_for_.end()) {
+    for (auto next : edges->second) {
+      auto on_path = std::find(path->begin(), path->end(), next);
+      if (on_path != path->end()) {
+        *newest = *std::max_element(on_path, path->end());
+        return true;
+      }
+      if (visited->count(next) == 0 && FindCycle(next, path, visited, newest)) {
+        return true;
+      }
+    }
+  }
+  path->pop_back();
+  return false;
+}
 
 auto LockManager::GetEdgeList() -> std::vector<std::pair<txn_id_t, txn_id_t>> {
-  std::vector<std::pair<txn_id_t, txn_id_t>> edges(0);
+  const std::lock_guard<std::mutex> guard(waits_for_latch_);
+  std::vector<std::pair<txn_id_t, txn_id_t>> edges;
+  for (const auto &[waiter, holders] : waits_for_) {
+    for (auto holder : holders) {
+      edges.emplace_back(waiter, holder);
+    }
+  }
+  return edges;
+}
+
+auto LockManager::CollectWaitsFor() -> std::vector<std::pair<txn_id_t, txn_id_t>> {
+  std::vector<std::pair<txn_id_t, txn_id_t>> edges;
+  auto collect = [&edges](LockRequestQueue *queue) {
+    const std::lock_guard<std::mutex> guard(queue->latch_);
+    auto &requests = queue->request_queue_;
+    for (auto waiter = requests.begin(); waiter != requests.end(); ++waiter) {
+      if ((*waiter)->granted_) {
+        continue;
+      }
+      for (auto other = requests.begin(); other != waiter; ++other) {
+        if (!AreCompatible((*other)->lock_mode_, (*waiter)->lock_mode_)) {
+          edges.emplace_back((*waiter)->txn_id_, (*other)->txn_id_);
+        }
+      }
+    }
+  };
+
+  {
+    const std::lock_guard<std::mutex> guard(table_lock_map_latch_);
+    for (const auto &[oid, queue] : table_lock_map_) {
+      collect(queue.get());
+    }
+  }
+  for (size_t i = 0; i < LOCK_TABLE_BUCKETS; i++) {
+    const std::lock_guard<std::mutex> guard(row_lock_buckets_[i].latch_);
+    for (const auto &[rid, queue] : row_lock_buckets_[i].row_lock_map_) {
+      collect(queue.get());
+    }
+  }
   return edges;
 }
 
 void LockManager::RunCycleDetection() {
   while (enable_cycle_detection_) {
     std::this_thread::sleep_for(cycle_detection_interval);
-    {  // TODO(students): detect deadlock
+    // the graph is rebuilt from the queues every round, edges added through AddEdge stay
+    const auto edges = CollectWaitsFor();
+    for (const auto &[waiter, holder] : edges) {
+      AddEdge(waiter, holder);
+    }
+
+    txn_id_t victim;
+    while (HasCycle(&victim)) {
+      {
+        const std::lock_guard<std::mutex> guard(waits_for_latch_);
+        waits_for_.erase(victim);
+        for (auto &[waiter, holders] : waits_for_) {
+          holders.erase(std::remove(holders.begin(), holders.end(), victim), holders.end());
+        }
+      }
+
+      std::shared_ptr<LockRequestQueue> queue;
+      {
+        const std::lock_guard<std::mutex> guard(waiting_on_latch_);
+        auto waiting = waiting_on_.find(victim);
+        if (waiting == waiting_on_.end()) {
+          continue;
+        }
+        queue = waiting->second;
+      }
+      // the graph may be stale, only abort the victim if it still waits, which also keeps it from going away
+      const std::lock_guard<std::mutex> guard(queue->latch_);
+      const bool still_waiting =
+          std::any_of(queue->request_queue_.begin(), queue->request_queue_.end(),
+                      [&](const LockRequest *request) { return request->txn_id_ == victim && !request->granted_; });
+      if (still_waiting && TransactionManager::GetTransaction(victim)->MarkAborted()) {
+        queue->cv_.notify_all();
+      }
+    }
+
+    for (const auto &[waiter, holder] : edges) {
+      RemoveEdge(waiter, holder);
     }
   }
 }
@@ -0,0 +1,259 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// occ_manager.cpp
+//
+// Identification: src/concurrency/occ_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/occ_manager.h"
+
+#include <algorithm>
+
+#include "concurrency/transaction.h"
+
+namespace bustub {
+
+OccManager::WordBucket::~WordBucket() {
+  for (auto *node = head_.load(); node != nullptr;) {
+    auto *next = node->next_.load();
+    delete node;
+    node = next;
+  }
+  for (auto *node : retired_) {
+    delete node;
+  }
+}
+
+void OccManager::Register(Transaction *txn) {
+  const std::lock_guard<std::mutex> guard(active_latch_);
+  txn->SetOccEpoch(epoch_);
+  active_epochs_.insert(txn->GetOccEpoch());
+}
+
+void OccManager::Unregister(Transaction *txn) {
+  const std::lock_guard<std::mutex> guard(active_latch_);
+  active_epochs_.erase(active_epochs_.find(txn->GetOccEpoch()));
+}
+
+auto OccManager::FindWord(WordBucket *bucket, const RID &rid) -> std::atomic<uint64_t> * {
+  for (auto *node = bucket->head_.load(); node != nullptr; node = node->next_.load()) {
+    if (node->rid_ == rid && node->word_.load() != RECLAIMED_WORD) {
+      // only write the cache line once per epoch
+      const uint64_t epoch = epoch_;
+      if (node->access_epoch_.load(std::memory_order_relaxed) != epoch) {
+        node->access_epoch_.store(epoch);
+      }
+      return &node->word_;
+    }
+  }
+  return nullptr;
+}
+
+auto OccManager::FindOrInsertWord(WordBucket *bucket, const RID &rid) -> std::atomic<uint64_t> * {
+  if (auto *word = FindWord(bucket, rid); word != nullptr) {
+    return word;
+  }
+  const std::lock_guard<std::mutex> guard(bucket->latch_);
+  if (auto *word = FindWord(bucket, rid); word != nullptr) {
+    return word;
+  }
+  auto *node = new WordNode(rid, epoch_);
+  node->next_.store(bucket->head_.load());
+  bucket->head_.store(node);
+  return &node->word_;
+}
+
+auto OccManager::LoadWord(const RID &rid) -> uint64_t {
+  auto &bucket = BucketOf(rid);
+  const BucketReadGuard read_guard(&bucket);
+  while (true) {
+    const uint64_t cur = FindOrInsertWord(&bucket, rid)->load();
+    if (cur != RECLAIMED_WORD) {
+      return cur;
+    }
+  }
+}
+
+void OccManager::MarkAbsent(const RID &rid, txn_id_t txn_id) {
+  auto &bucket = BucketOf(rid);
+  const BucketReadGuard read_guard(&bucket);
+  const uint64_t absent = (static_cast<uint64_t>(txn_id) << WORD_SHIFT) | ABSENT_BIT;
+  while (true) {
+    auto *word = FindOrInsertWord(&bucket, rid);
+    uint64_t cur = word->load();
+    while (cur != RECLAIMED_WORD && !word->compare_exchange_weak(cur, absent | (cur & LOCK_BIT))) {
+    }
+    if (cur != RECLAIMED_WORD) {
+      return;
+    }
+  }
+}
+
+void OccManager::BumpWord(const RID &rid) {
+  auto &bucket = BucketOf(rid);
+  const BucketReadGuard read_guard(&bucket);
+  while (true) {
+    auto *word = FindWord(&bucket, rid);
+    if (word == nullptr) {
+      // no optimistic transaction may have seen the tuple
+      return;
+    }
+    uint64_t cur = word->load();
+    while (cur != RECLAIMED_WORD &&
+           !word->compare_exchange_weak(cur, (((cur >> WORD_SHIFT) + 1) << WORD_SHIFT) | (cur & LOCK_BIT))) {
+    }
+    if (cur != RECLAIMED_WORD) {
+      return;
+    }
+  }
+}
+
+auto OccManager::LockAndValidate(Transaction *txn, const std::vector<RID> &write_rids, uint64_t *tid) -> bool {
+  uint64_t max_tid = 0;
+  for (const auto &rid : write_rids) {
+    auto &bucket = BucketOf(rid);
+    const BucketReadGuard read_guard(&bucket);
+    auto *word = FindOrInsertWord(&bucket, rid);
+    while (true) {
+      uint64_t cur = word->load();
+      if (cur == RECLAIMED_WORD) {
+        word = FindOrInsertWord(&bucket, rid);
+        continue;
+      }
+      if ((cur & LOCK_BIT) == 0 && word->compare_exchange_weak(cur, cur | LOCK_BIT)) {
+        if ((cur & ABSENT_BIT) == 0) {
+          max_tid = std::max(max_tid, cur >> WORD_SHIFT);
+        }
+        break;
+      }
+      std::this_thread::yield();
+    }
+  }
+  // the writes are serialized in this epoch or a later one
+  const uint64_t epoch = epoch_;
+
+  const auto by_rid = [](const RID &lhs, const RID &rhs) { return lhs.Get() < rhs.Get(); };
+  for (const auto &[rid, seen] : *txn->GetOccReadSet()) {
+    const bool locked_by_txn = std::binary_search(write_rids.begin(), write_rids.end(), rid, by_rid);
+    const uint64_t expected = locked_by_txn ? seen | LOCK_BIT : seen;
+    if ((seen & LOCK_BIT) != 0 || LoadWord(rid) != expected) {
+      Unlock(write_rids);
+      return false;
+    }
+    if ((seen & ABSENT_BIT) == 0) {
+      max_tid = std::max(max_tid, seen >> WORD_SHIFT);
+    }
+  }
+
+  static thread_local uint64_t last_tid = 0;
+  *tid = std::max({max_tid + 1, last_tid + 1, epoch << 32});
+  last_tid = *tid;
+  return true;
+}
+
+void OccManager::Publish(const std::vector<RID> &write_rids, uint64_t tid) {
+  // a locked word is never reclaimed
+  for (const auto &rid : write_rids) {
+    auto &bucket = BucketOf(rid);
+    const BucketReadGuard read_guard(&bucket);
+    FindWord(&bucket, rid)->store(tid << WORD_SHIFT);
+  }
+}
+
+void OccManager::Unlock(const std::vector<RID> &write_rids) {
+  for (const auto &rid : write_rids) {
+    auto &bucket = BucketOf(rid);
+    const BucketReadGuard read_guard(&bucket);
+    FindWord(&bucket, rid)->fetch_and(~LOCK_BIT);
+  }
+}
+
+void OccManager::AdvanceEpoch() {
+  epoch_++;
+  Reclaim();
+}
+
+auto OccManager::Reclaim() -> size_t {
+  uint64_t oldest_epoch;
+  {
+    const std::lock_guard<std::mutex> guard(active_latch_);
+    oldest_epoch = active_epochs_.empty() ? epoch_.load() : *active_epochs_.begin();
+  }
+
+  size_t num_reclaimed = 0;
+  for (size_t i = 0; i < OCC_WORD_BUCKETS; i++) {
+    auto &bucket = buckets_[i];
+    const std::lock_guard<std::mutex> guard(bucket.latch_);
+    std::atomic<WordNode *> *link = &bucket.head_;
+    for (auto *node = link->load(); node != nullptr; node = link->load()) {
+      // a running transaction that began before the access may hold the word in its read set
+      uint64_t cur = node->word_.load();
+      if (node->access_epoch_.load() < oldest_epoch && (cur & (LOCK_BIT | ABSENT_BIT)) == 0 &&
+          node->word_.compare_exchange_strong(cur, RECLAIMED_WORD)) {
+        // lookups on the node go on to the rest of the chain
+        link->store(node->next_.load());
+        bucket.retired_.push_back(node);
+        num_reclaimed++;
+      } else {
+        link = &node->next_;
+      }
+    }
+    // a lookup that starts now no longer finds the unlinked nodes
+    if (!bucket.retired_.empty() && bucket.readers_.load() == 0) {
+      for (auto *node : bucket.retired_) {
+        delete node;
+      }
+      bucket.retired_.clear();
+    }
+  }
+  return num_reclaimed;
+}
+
+auto OccManager::GetNumWords() -> size_t {
+  size_t num_words = 0;
+  for (size_t i = 0; i < OCC_WORD_BUCKETS; i++) {
+    const std::lock_guard<std::mutex> guard(buckets_[i].latch_);
+    for (auto *node = buckets_[i].head_.load(); node != nullptr; node = node->next_.load()) {
+      num_words++;
+    }
+  }
+  return num_words;
+}
+
+void OccManager::RunEpochAdvancer() {
+  const std::lock_guard<std::mutex> guard(epoch_latch_);
+  if (epoch_thread_.joinable()) {
+    return;
+  }
+  stop_epoch_advancer_ = false;
+  epoch_thread_ = std::thread(&OccManager::EpochAdvancer, this);
+}
+
+void OccManager::StopEpochAdvancer() {
+  std::thread thread;
+  {
+    const std::lock_guard<std::mutex> guard(epoch_latch_);
+    stop_epoch_advancer_ = true;
+    thread = std::move(epoch_thread_);
+  }
+  epoch_cv_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void OccManager::EpochAdvancer() {
+  std::unique_lock<std::mutex> lock(epoch_latch_);
+  while (!epoch_cv_.wait_for(lock, occ_epoch_interval, [&] { return stop_epoch_advancer_; })) {
+    lock.unlock();
+    AdvanceEpoch();
+    lock.lock();
+  }
+}
+
+}  // namespace bustub
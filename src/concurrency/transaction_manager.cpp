@@ -12,10 +12,14 @@
 
 #include "concurrency/transaction_manager.h"
 
+#include <algorithm>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "catalog/catalog.h"
 #include "storage/table/table_heap.h"
@@ -23,19 +27,43 @@ namespace bustub {
 
 std::unordered_map<txn_id_t, Transaction *> TransactionManager::txn_map = {};
 std::shared_mutex TransactionManager::txn_map_mutex = {};
+thread_local std::vector<std::unique_ptr<Transaction>> TransactionManager::txn_pool = {};
 
 auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level) -> Transaction * {
   // Acquire the global transaction latch in shared mode.
   global_txn_latch_.RLock();
 
-  if (txn == nullptr) {
+  if (txn == nullptr && !txn_pool.empty()) {
+    txn = txn_pool.back().release();
+    txn_pool.pop_back();
+    txn->Reset(next_txn_id_++, isolation_level);
+  } else if (txn == nullptr) {
     txn = new Transaction(next_txn_id_++, isolation_level);
   }
 
-  if (enable_logging) {
-    LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
-    lsn_t lsn = log_manager_->AppendLogRecord(&record);
-    txn->SetPrevLSN(lsn);
+  txn->SetVersionStore(&version_store_);
+  txn->SetOccManager(&occ_manager_);
+  if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC) {
+    occ_manager_.Register(txn);
+  }
+  if (txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT_ISOLATION) {
+    // the writes of the writers that keep no versions are final once they end
+    version_store_.BeginSnapshot();
+  }
+  {
+    // taking the read timestamp under the latch keeps the garbage collector from dropping what the snapshot reads
+    const std::lock_guard<std::mutex> guard(active_txns_latch_);
+    // a fuzzy checkpoint that comes after the BEGIN record in the log also finds the transaction in the table
+    if (enable_logging) {
+      LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+      lsn_t lsn = log_manager_->AppendLogRecord(&record);
+      txn->SetPrevLSN(lsn);
+    }
+    active_txns_[txn->GetTransactionId()] = {txn, txn->GetPrevLSN()};
+    if (txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT_ISOLATION) {
+      txn->SetReadTs(last_commit_ts_);
+      snapshots_.insert(txn->GetReadTs());
+    }
   }
 
   std::unique_lock<std::shared_mutex> l(txn_map_mutex);
@@ -43,11 +71,31 @@ auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level)
   return txn;
 }
 
-void TransactionManager::Commit(Transaction *txn) {
+auto TransactionManager::Commit(Transaction *txn) -> bool {
+  if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC && txn->GetOccManager() != nullptr &&
+      !ValidateAndWrite(txn)) {
+    Abort(txn);
+    return false;
+  }
   txn->SetState(TransactionState::COMMITTED);
 
-  // Perform all deletes before we commit.
+  // Stamp the versions of the writes, the snapshots that begin after this see the writes.
   auto write_set = txn->GetWriteSet();
+  const bool keeps_versions = txn->KeepsVersions().value_or(false) && !write_set->empty();
+  timestamp_t watermark = 0;
+  if (keeps_versions) {
+    {
+      const std::lock_guard<std::mutex> guard(commit_latch_);
+      const timestamp_t commit_ts = last_commit_ts_ + 1;
+      for (const auto &item : *write_set) {
+        version_store_.Commit(item.rid_, txn->GetTransactionId(), commit_ts);
+      }
+      last_commit_ts_ = commit_ts;
+    }
+    watermark = GetWatermark();
+  }
+
+  // Perform all deletes before we commit.
   while (!write_set->empty()) {
     auto &item = write_set->back();
     auto *table = item.table_;
@@ -55,18 +103,67 @@ void TransactionManager::Commit(Transaction *txn) {
       // Note that this also releases the lock when holding the page latch.
       table->ApplyDelete(item.rid_, txn);
     }
+    // without a snapshot older than the commit, nobody reads the versions
+    if (keeps_versions) {
+      version_store_.CollectGarbage(item.rid_, watermark);
+    }
     write_set->pop_back();
   }
   write_set->clear();
 
+  if (enable_logging) {
+    LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&record);
+    txn->SetPrevLSN(lsn);
+    // the commit is durable once its record is, concurrent commits share the log write
+    log_manager_->Flush(lsn);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
+  Unregister(txn);
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
+  return true;
+}
+
+auto TransactionManager::ValidateAndWrite(Transaction *txn) -> bool {
+  // the tuples the transaction writes, including the ones it inserted, which nobody else sees yet
+  std::vector<RID> write_rids;
+  for (const auto &write : *txn->GetOccWriteSet()) {
+    write_rids.push_back(write.rid_);
+  }
+  for (const auto &write : *txn->GetWriteSet()) {
+    write_rids.push_back(write.rid_);
+  }
+  std::sort(write_rids.begin(), write_rids.end(),
+            [](const RID &lhs, const RID &rhs) { return lhs.Get() < rhs.Get(); });
+  write_rids.erase(std::unique(write_rids.begin(), write_rids.end()), write_rids.end());
+
+  uint64_t tid;
+  if (!occ_manager_.LockAndValidate(txn, write_rids, &tid)) {
+    return false;
+  }
+  // from here on the table heaps take the writes instead of buffering them
+  txn->SetState(TransactionState::SHRINKING);
+  for (const auto &write : *txn->GetOccWriteSet()) {
+    const bool applied = write.wtype_ == WType::DELETE ? write.table_->MarkDelete(write.rid_, txn)
+                                                       : write.table_->UpdateTuple(write.tuple_, write.rid_, txn);
+    if (!applied) {
+      occ_manager_.Unlock(write_rids);
+      return false;
+    }
+  }
+  occ_manager_.Publish(write_rids, tid);
+  txn->GetOccWriteSet()->clear();
+  txn->GetOccReadSet()->clear();
+  return true;
 }
 
 void TransactionManager::Abort(Transaction *txn) {
   txn->SetState(TransactionState::ABORTED);
+  txn->GetOccWriteSet()->clear();
+  txn->GetOccReadSet()->clear();
   // Rollback before releasing the lock.
   auto table_write_set = txn->GetWriteSet();
   while (!table_write_set->empty()) {
@@ -80,6 +177,9 @@ void TransactionManager::Abort(Transaction *txn) {
     } else if (item.wtype_ == WType::UPDATE) {
       table->UpdateTuple(item.tuple_, item.rid_, txn);
     }
+    if (txn->KeepsVersions().value_or(false)) {
+      version_store_.Rollback(item.rid_, txn->GetTransactionId());
+    }
     table_write_set->pop_back();
   }
   table_write_set->clear();
@@ -109,12 +209,108 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  if (enable_logging) {
+    LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&record);
+    txn->SetPrevLSN(lsn);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
+  Unregister(txn);
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
 }
 
+void TransactionManager::Recycle(Transaction *txn) {
+  BUSTUB_ASSERT(txn->GetState() == TransactionState::COMMITTED || txn->GetState() == TransactionState::ABORTED,
+                "only a finished transaction can be reused");
+  if (txn_pool.size() >= TXN_POOL_SIZE) {
+    delete txn;
+    return;
+  }
+  txn_pool.emplace_back(txn);
+}
+
+void TransactionManager::Unregister(Transaction *txn) {
+  {
+    const std::lock_guard<std::mutex> guard(active_txns_latch_);
+    active_txns_.erase(txn->GetTransactionId());
+    if (txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT_ISOLATION) {
+      snapshots_.erase(snapshots_.find(txn->GetReadTs()));
+    }
+  }
+  if (txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT_ISOLATION) {
+    version_store_.EndSnapshot();
+  }
+  version_store_.EndWriter(txn);
+  if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC) {
+    occ_manager_.Unregister(txn);
+  }
+  // the lock manager only looks up transactions that hold or wait for a lock, which this one no longer does
+  std::unique_lock<std::shared_mutex> l(txn_map_mutex);
+  txn_map.erase(txn->GetTransactionId());
+}
+
+auto TransactionManager::GetActiveTransactionTable() -> std::vector<std::pair<txn_id_t, lsn_t>> {
+  const std::lock_guard<std::mutex> guard(active_txns_latch_);
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns;
+  active_txns.reserve(active_txns_.size());
+  for (const auto &[txn_id, txn_and_begin_lsn] : active_txns_) {
+    active_txns.emplace_back(txn_id, txn_and_begin_lsn.first->GetPrevLSN());
+  }
+  return active_txns;
+}
+
+auto TransactionManager::GetOldestBeginLSN() -> lsn_t {
+  const std::lock_guard<std::mutex> guard(active_txns_latch_);
+  lsn_t oldest_lsn = INVALID_LSN;
+  for (const auto &[txn_id, txn_and_begin_lsn] : active_txns_) {
+    const lsn_t begin_lsn = txn_and_begin_lsn.second;
+    if (begin_lsn != INVALID_LSN && (oldest_lsn == INVALID_LSN || begin_lsn < oldest_lsn)) {
+      oldest_lsn = begin_lsn;
+    }
+  }
+  return oldest_lsn;
+}
+
+auto TransactionManager::GetWatermark() -> timestamp_t {
+  const std::lock_guard<std::mutex> guard(active_txns_latch_);
+  return snapshots_.empty() ? last_commit_ts_.load() : *snapshots_.begin();
+}
+
+void TransactionManager::RunGarbageCollector() {
+  const std::lock_guard<std::mutex> guard(gc_latch_);
+  if (gc_thread_.joinable()) {
+    return;
+  }
+  stop_gc_ = false;
+  gc_thread_ = std::thread(&TransactionManager::GarbageCollector, this);
+}
+
+void TransactionManager::StopGarbageCollector() {
+  std::thread thread;
+  {
+    const std::lock_guard<std::mutex> guard(gc_latch_);
+    stop_gc_ = true;
+    thread = std::move(gc_thread_);
+  }
+  gc_cv_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void TransactionManager::GarbageCollector() {
+  std::unique_lock<std::mutex> lock(gc_latch_);
+  while (!stop_gc_) {
+    lock.unlock();
+    CollectGarbage();
+    lock.lock();
+    gc_cv_.wait_for(lock, version_gc_interval, [&] { return stop_gc_; });
+  }
+}
+
 void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
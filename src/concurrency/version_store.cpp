@@ -0,0 +1,158 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.cpp
+//
+// Identification: src/concurrency/version_store.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/version_store.h"
+
+#include <iterator>
+
+#include "concurrency/transaction.h"
+
+namespace bustub {
+
+auto VersionStore::KeepsVersions(Transaction *writer) -> bool {
+  if (!writer->KeepsVersions().has_value()) {
+    num_unversioned_writers_++;
+    const bool keeps_versions = num_snapshots_ > 0;
+    if (keeps_versions) {
+      ReleaseUnversionedWriter();
+    }
+    writer->SetKeepsVersions(keeps_versions);
+  }
+  return *writer->KeepsVersions();
+}
+
+void VersionStore::EndWriter(Transaction *writer) {
+  if (writer->KeepsVersions().has_value() && !*writer->KeepsVersions()) {
+    ReleaseUnversionedWriter();
+  }
+}
+
+void VersionStore::BeginSnapshot() {
+  num_snapshots_++;
+  std::unique_lock<std::mutex> lock(writers_latch_);
+  writers_cv_.wait(lock, [this] { return num_unversioned_writers_ == 0; });
+}
+
+void VersionStore::ReleaseUnversionedWriter() {
+  if (--num_unversioned_writers_ == 0) {
+    const std::lock_guard<std::mutex> guard(writers_latch_);
+    writers_cv_.notify_all();
+  }
+}
+
+void VersionStore::AddUndo(const RID &rid, txn_id_t writer, bool exists, const Tuple &before) {
+  auto &bucket = BucketOf(rid);
+  const std::lock_guard<std::mutex> guard(bucket.latch_);
+  bucket.chains_[rid].push_back({writer, UNCOMMITTED_TS, exists, exists ? before : Tuple{}});
+}
+
+void VersionStore::Commit(const RID &rid, txn_id_t writer, timestamp_t commit_ts) {
+  auto &bucket = BucketOf(rid);
+  const std::lock_guard<std::mutex> guard(bucket.latch_);
+  auto it = bucket.chains_.find(rid);
+  if (it == bucket.chains_.end()) {
+    return;
+  }
+  for (auto &undo : it->second) {
+    if (undo.writer_ == writer && undo.commit_ts_ == UNCOMMITTED_TS) {
+      undo.commit_ts_ = commit_ts;
+    }
+  }
+}
+
+void VersionStore::Rollback(const RID &rid, txn_id_t writer) {
+  auto &bucket = BucketOf(rid);
+  const std::lock_guard<std::mutex> guard(bucket.latch_);
+  auto it = bucket.chains_.find(rid);
+  if (it == bucket.chains_.end()) {
+    return;
+  }
+  auto &chain = it->second;
+  for (auto undo = chain.rbegin(); undo != chain.rend(); ++undo) {
+    if (undo->writer_ == writer && undo->commit_ts_ == UNCOMMITTED_TS) {
+      chain.erase(std::next(undo).base());
+      break;
+    }
+  }
+  if (chain.empty()) {
+    bucket.chains_.erase(it);
+  }
+}
+
+void VersionStore::Resolve(const RID &rid, timestamp_t read_ts, bool *exists, Tuple *tuple) {
+  auto &bucket = BucketOf(rid);
+  const std::lock_guard<std::mutex> guard(bucket.latch_);
+  auto it = bucket.chains_.find(rid);
+  if (it == bucket.chains_.end()) {
+    return;
+  }
+  const auto &chain = it->second;
+  for (auto undo = chain.rbegin(); undo != chain.rend() && undo->commit_ts_ > read_ts; ++undo) {
+    *exists = undo->exists_;
+    if (undo->exists_) {
+      *tuple = undo->before_;
+    }
+  }
+}
+
+auto VersionStore::Prune(VersionChain *chain, timestamp_t watermark) -> size_t {
+  // every snapshot stops at the newest write committed at or before the watermark, or at a newer one
+  for (auto undo = chain->rbegin(); undo != chain->rend(); ++undo) {
+    if (undo->commit_ts_ <= watermark) {
+      const auto num_dropped = static_cast<size_t>(chain->rend() - undo);
+      chain->erase(chain->begin(), undo.base());
+      return num_dropped;
+    }
+  }
+  return 0;
+}
+
+auto VersionStore::CollectGarbage(timestamp_t watermark) -> size_t {
+  size_t num_dropped = 0;
+  for (size_t i = 0; i < VERSION_STORE_BUCKETS; i++) {
+    auto &bucket = buckets_[i];
+    const std::lock_guard<std::mutex> guard(bucket.latch_);
+    for (auto it = bucket.chains_.begin(); it != bucket.chains_.end();) {
+      num_dropped += Prune(&it->second, watermark);
+      it = it->second.empty() ? bucket.chains_.erase(it) : std::next(it);
+    }
+  }
+  return num_dropped;
+}
+
+auto VersionStore::CollectGarbage(const RID &rid, timestamp_t watermark) -> size_t {
+  auto &bucket = BucketOf(rid);
+  const std::lock_guard<std::mutex> guard(bucket.latch_);
+  auto it = bucket.chains_.find(rid);
+  if (it == bucket.chains_.end()) {
+    return 0;
+  }
+  const size_t num_dropped = Prune(&it->second, watermark);
+  if (it->second.empty()) {
+    bucket.chains_.erase(it);
+  }
+  return num_dropped;
+}
+
+auto VersionStore::GetNumVersions() -> size_t {
+  size_t num_versions = 0;
+  for (size_t i = 0; i < VERSION_STORE_BUCKETS; i++) {
+    auto &bucket = buckets_[i];
+    const std::lock_guard<std::mutex> guard(bucket.latch_);
+    for (const auto &[rid, chain] : bucket.chains_) {
+      num_versions += chain.size();
+    }
+  }
+  return num_versions;
+}
+
+}  // namespace bustub
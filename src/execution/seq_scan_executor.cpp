@@ -17,6 +17,7 @@ namespace bustub {
 SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx), plan_(plan) {
   table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
   table_iterator_ = table_info_->table_->Begin(exec_ctx_->GetTransaction());
+  table_iterator_.EnableReadAhead(scan_prefetch_window);
 }
 
 void SeqScanExecutor::Init() {  }
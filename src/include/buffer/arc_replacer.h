@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ARCReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST '03).
+ *
+ * Resident frames are split between T1, pages seen once recently, and T2, pages seen at least twice. The ghost
+ * lists B1 and B2 remember the page ids recently evicted from T1 and T2. A page loaded again while in B1 means T1 was
+ * too small, and the target size p of T1 grows; a hit in B2 shrinks it. Scans only churn T1, so T2 is kept unless
+ * the workload really shifts.
+ *
+ * A table scan touches each page once per tuple. As in 2Q and LRU-K, such correlated references do not count as
+ * reuse: a page in T1 is promoted to T2 only by an access after at least correlated_loads_ other pages were loaded.
+ */
+class ARCReplacer : public Replacer {
+ public:
+  /**
+   * @brief Create a new ARCReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ARCReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ARCReplacer);
+
+  ~ARCReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordLoad(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override { return Evict(frame_id); }
+
+  void Pin(frame_id_t frame_id) override { SetEvictable(frame_id, false); }
+
+  void Unpin(frame_id_t frame_id) override {
+    RecordAccess(frame_id);
+    SetEvictable(frame_id, true);
+  }
+
+  /** @return the current target size of T1, for tests */
+  auto GetTarget() -> size_t {
+    std::lock_guard<std::mutex> guard(latch_);
+    return target_t1_;
+  }
+
+ private:
+  enum class Queue { NONE, T1, T2 };
+
+  struct FrameInfo {
+    Queue queue_{Queue::NONE};
+    bool evictable_{false};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Value of load_clock_ when the page was loaded. */
+    size_t loaded_at_{0};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** A list of ghost page ids, most recent first, with an index for lookups. */
+  struct GhostList {
+    std::list<page_id_t> list_;
+    std::unordered_map<page_id_t, std::list<page_id_t>::iterator> map_;
+
+    void PushFront(page_id_t page_id) {
+      list_.push_front(page_id);
+      map_[page_id] = list_.begin();
+    }
+    void PopBack() {
+      map_.erase(list_.back());
+      list_.pop_back();
+    }
+    auto Erase(page_id_t page_id) -> bool {
+      auto it = map_.find(page_id);
+      if (it == map_.end()) {
+        return false;
+      }
+      list_.erase(it->second);
+      map_.erase(it);
+      return true;
+    }
+    auto Contains(page_id_t page_id) const -> bool { return map_.count(page_id) != 0; }
+    auto Size() const -> size_t { return list_.size(); }
+  };
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** Evict the least recently used evictable frame of the list, which is ordered most recent first. */
+  auto EvictFrom(std::list<frame_id_t> *list, frame_id_t *frame_id) -> bool;
+
+  /** Drop the frame from its list and forget it. */
+  void Untrack(frame_id_t frame_id);
+
+  /** Keep |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c. */
+  void TrimGhosts();
+
+  const size_t replacer_size_;
+  /** Accesses to a page in T1 within this many loads of its own load are correlated. */
+  const size_t correlated_loads_;
+  /** Adaptive target size of T1, p in the paper. */
+  size_t target_t1_{0};
+  /** Number of pages loaded so far. */
+  size_t load_clock_{0};
+
+  std::vector<FrameInfo> frames_;
+  std::list<frame_id_t> t1_;
+  std::list<frame_id_t> t2_;
+  GhostList b1_;
+  GhostList b2_;
+  size_t evictable_count_{0};
+
+  std::mutex latch_;
+};
+
+}  // namespace bustub
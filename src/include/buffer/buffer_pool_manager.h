@@ -14,12 +14,16 @@
 
 #include <list>
 #include <mutex>  // NOLINT
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -84,6 +88,99 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page and keep it pinned until the returned guard is dropped.
+   * @param page_id id of page to be fetched
+   * @return a guard on the page, empty if the page could not be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard { return {this, FetchPage(page_id)}; }
+
+  /**
+   * Fetch a page, read-latch it, and keep both until the returned guard is dropped.
+   * @param page_id id of page to be fetched
+   * @return a guard on the page, empty if the page could not be fetched
+   */
+  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard {
+    auto *page = FetchPage(page_id);
+    if (page != nullptr) {
+      page->RLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Fetch a page, write-latch it, and keep both until the returned guard is dropped.
+   * @param page_id id of page to be fetched
+   * @return a guard on the page, empty if the page could not be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard {
+    auto *page = FetchPage(page_id);
+    if (page != nullptr) {
+      page->WLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Create a new page, placed on disk close to another page if the disk manager can.
+   * @param[out] page_id id of created page
+   * @param near_page_id a page the new page is accessed together with, or INVALID_PAGE_ID
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPageNear(page_id_t *page_id, page_id_t near_page_id) -> Page * {
+    return near_page_id == INVALID_PAGE_ID ? NewPage(page_id) : NewPgNearImp(page_id, near_page_id);
+  }
+
+  /**
+   * Create a new page and keep it pinned until the returned guard is dropped.
+   * @param[out] page_id id of created page
+   * @param near_page_id a page the new page is accessed together with, or INVALID_PAGE_ID
+   * @return a guard on the page, empty if no new page could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id, page_id_t near_page_id = INVALID_PAGE_ID) -> BasicPageGuard {
+    return {this, NewPageNear(page_id, near_page_id)};
+  }
+
+  /**
+   * Start reading pages into the buffer pool in the background, without pinning them. Resident pages are skipped. A
+   * FetchPage of a page whose read is still in flight waits for it instead of reading the page again.
+   * @param page_ids ids of the pages that will be fetched soon
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) { PrefetchPgsImp(page_ids); }
+
+  /**
+   * Start writing back dirty pages in the background before they are chosen for eviction, so that misses do not
+   * have to. Buffer pools without a background writer ignore it.
+   */
+  virtual void RunBackgroundWriter() {}
+
+  /** Stop and join the background writer, if it is running. */
+  virtual void StopBackgroundWriter() {}
+
+  /**
+   * Set the side file that DumpResidentPages writes and WarmStart reads. While the background writer runs, it also
+   * dumps the resident pages every warm_start_dump_interval. Buffer pools without warm start ignore it.
+   * @param path path of the side file
+   */
+  virtual void SetWarmStartFile(const std::string &path) {}
+
+  /** Write the ids of the resident pages to the warm start file, from least to most recently used. */
+  virtual void DumpResidentPages() {}
+
+  /**
+   * Read the pages listed in the warm start file into free frames, with batched reads in page id order, and give
+   * them the recency order they had when they were dumped. Call it before the buffer pool is used.
+   * @return the number of pages read
+   */
+  virtual auto WarmStart() -> size_t { return 0; }
+
+  /**
+   * Take a snapshot of the dirty page table for a checkpoint. Before a page with logged changes is written out, the
+   * log is flushed up to the page LSN.
+   * @return every resident page with a logged change that is not on disk yet, and its recLSN
+   */
+  virtual auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> { return {}; }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
@@ -130,6 +227,14 @@ class BufferPoolManager {
    */
   virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
 
+  /**
+   * Creates a new page in the buffer pool, close to near_page_id on disk. The default implementation ignores the hint.
+   * @param[out] page_id id of created page
+   * @param near_page_id a page the new page should be close to
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * { return NewPgImp(page_id); }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +246,11 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Queue pages to be read in the background. Prefetching is only a hint, so by default it does nothing.
+   * @param page_ids ids of the pages to prefetch
+   */
+  virtual void PrefetchPgsImp(const std::vector<page_id_t> &page_ids) {}
 };
 }  // namespace bustub
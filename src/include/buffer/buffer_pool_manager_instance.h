@@ -12,14 +12,23 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_k_replacer.h"
+#include "buffer/concurrent_page_table.h"
+#include "buffer/frame_arena.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
-#include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -28,6 +37,20 @@ namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * Hits in FetchPage and all UnpinPage calls do not take latch_: they look the frame up in the concurrent page
+ * table, pin it with a compare-and-swap on its pin count, and then check that the frame still holds the requested
+ * page. Misses, new pages, deletes and flushes run under latch_. To reuse a frame, they first swing its pin count
+ * from 0 to FRAME_CLAIMED, which makes every concurrent optimistic pin fail until the frame is handed out again.
+ * Hits still record the access in the replacer, which has its own short critical section.
+ *
+ * Prefetches are served by PREFETCH_IO_THREADS background threads, started on the first prefetch. A prefetch claims
+ * a frame under latch_ and reads the page without it; the page id stays in prefetching_ until the page is published,
+ * and misses on it wait for the read to finish.
+ *
+ * The background writer, once started with RunBackgroundWriter, keeps the next bg_writer_lookahead_ victims of the
+ * replacer clean and evicts clean pages until bg_writer_free_target_ frames are free. It writes a page while holding
+ * a pin and a read latch on it, not latch_, so misses rarely have to write back a dirty victim themselves.
  */
 class BufferPoolManagerInstance : public BufferPoolManager {
  public:
@@ -37,9 +60,24 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRUK);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in the parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRUK);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
@@ -52,6 +90,24 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /** @brief Start the background writer thread. Does nothing if it is already running. */
+  void RunBackgroundWriter() override;
+
+  /** @brief Stop and join the background writer thread. */
+  void StopBackgroundWriter() override;
+
+  void SetWarmStartFile(const std::string &path) override;
+
+  void DumpResidentPages() override;
+
+  /**
+   * @brief Pages that another instance owns, that were freed since the dump, or that do not fit into the free frames,
+   * are skipped.
+   */
+  auto WarmStart() -> size_t override;
+
+  auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> override;
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -118,7 +174,15 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  auto NewPgImp(page_id_t *page_id) -> Page * override;
+  auto NewPgImp(page_id_t *page_id) -> Page * override { return NewPgNearImp(page_id, INVALID_PAGE_ID); }
+
+  /**
+   * @brief Create a new page like NewPgImp, asking the disk manager for a page id close to near_page_id.
+   * @param[out] page_id id of created page
+   * @param near_page_id a page the new page should be close to, or INVALID_PAGE_ID
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * override;
 
   /**
    * TODO(P1): Add implementation
@@ -129,13 +193,20 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * 2. Remove the frame from the replacer.
    * 3. Add the frame back to the free list.
    * 4. Reset the page's metadata (id, memory, dirty flag).
-   * 4. Call DeallocatePage() to imitate freeing the page on disk.
+   * 4. Call DeallocatePage() to free the page on disk, also if the page is not resident.
    *
    * @param page_id id of page to be deleted
    * @return False if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
+  /**
+   * @brief Queue pages for the background I/O threads. Page ids beyond what the threads can keep up with, about one
+   * pool worth, are dropped.
+   * @param page_ids ids of the pages to prefetch
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids) override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -145,40 +216,161 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   /**
    * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   *
+   * Page ids are handed out with a stride of num_instances_, so that every page id allocated by this
+   * instance maps back to it (page_id % num_instances_ == instance_index_). A disk manager that tracks free
+   * pages picks the page, preferring one close to near_page_id; otherwise the next id of the counter is used.
+   *
+   * @param near_page_id a page the new page should be close to, or INVALID_PAGE_ID
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage(page_id_t near_page_id = INVALID_PAGE_ID) -> page_id_t;
+
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions
+   * to validate input data and ensure that a parallel BPM is routing requests to the correct BPI.
+   * @param page_id the page id to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
 
   /**
    * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
 
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
+  /** Number of frames at the eviction end of the replacer that the background writer keeps clean. */
+  const size_t bg_writer_lookahead_;
+  /** The background writer evicts clean pages until this many frames are free. */
+  const size_t bg_writer_free_target_;
   /** The next page id to be allocated  */
   std::atomic<page_id_t> next_page_id_ = 0;
-  /** Bucket size for the extendible hash table */
-  const size_t bucket_size_ = 4;
 
-  /** Array of buffer pool pages. */
+  /** Data of the frames, one contiguous arena so huge pages can back it. */
+  std::unique_ptr<FrameArena> frame_arena_;
+  /** Array of buffer pool pages, the metadata of the frames. Each is cache-line aligned and points into the arena. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
-  LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. 哈希表*/
-  ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
+  LogManager *log_manager_;
+  /** Page table for keeping track of buffer pool pages. Modified only under latch_, read lock-free on hits. */
+  ConcurrentPageTable *page_table_;
   /** Replacer to find unpinned pages for replacement. LRU替换策略*/
-  LRUKReplacer *replacer_;
+  std::unique_ptr<Replacer> replacer_;
   /** List of free frames that don't have any pages on them. 空闲链表*/
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** This latch protects the free list, page table updates and all frame replacement. Hits do not take it. */
   std::mutex latch_;
+  /** Pages being read by a prefetch, protected by latch_. */
+  std::unordered_set<page_id_t> prefetching_;
+  /** Signalled with latch_ when a prefetched page is published. */
+  std::condition_variable prefetch_done_;
+
+  /** Pages waiting for an I/O thread, protected by prefetch_latch_. */
+  std::deque<page_id_t> prefetch_queue_;
+  bool stop_prefetch_{false};
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::once_flag prefetch_threads_started_;
+  std::vector<std::thread> prefetch_threads_;
+
+  /** Background writer state, protected by bg_writer_latch_. */
+  bool stop_bg_writer_{false};
+  std::thread bg_writer_thread_;
+  std::mutex bg_writer_latch_;
+  std::condition_variable bg_writer_cv_;
+  /** Set by misses that found no free frame, to run the background writer before its interval is up. */
+  std::atomic<bool> bg_writer_wakeup_{false};
+  /** Side file of DumpResidentPages and WarmStart, empty if unset. Protected by bg_writer_latch_. */
+  std::string warm_start_file_;
+
+  /** Pin count of a frame whose page is being replaced or deleted. Optimistic pins never succeed on it. */
+  static constexpr int FRAME_CLAIMED = -1;
+
+  /**
+   * @brief Pin the page if its frame is not claimed.
+   * @return the pin count before this pin, or FRAME_CLAIMED if the page was not pinned
+   */
+  static auto TryPin(Page *page) -> int;
+
+  /**
+   * @brief Find a page in the buffer pool without taking latch_.
+   * @param page_id id of the page to find
+   * @param[out] frame_id the frame holding the page, only valid while the caller keeps it pinned
+   * @return false if the page is not resident, or if the lookup raced with a replacement
+   */
+  auto FindFrameOptimistic(page_id_t page_id, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Claim a frame for a new page, from the free list first and from the replacer otherwise.
+   * Caller must hold latch_. The claimed frame's pin count is FRAME_CLAIMED, and its old page has been written back
+   * if dirty and removed from the page table.
+   * @param[out] frame_id the claimed frame
+   * @return false if every frame is pinned
+   */
+  auto ClaimFrame(frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Take victims from the replacer until one of them can be claimed. Caller must hold latch_.
+   * @param[out] frame_id the claimed frame
+   * @return false if the replacer ran out of victims
+   */
+  auto EvictUnpinned(frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Flush the log up to the page LSN before the page is written out (write-ahead logging). The caller clears
+   * the recLSN of the page once no change can slip past the write, so the next logged change sets it again.
+   */
+  void PrepareWriteBack(Page *page);
+
+  /**
+   * @brief Write a page out that the caller holds pinned and read latched. The dirty flag and the recLSN are cleared
+   * under the latch, so a change made after the write marks the page dirty again and sets a new recLSN.
+   */
+  void WriteBackLatched(Page *page);
+
+  /**
+   * @brief Drop the frame of a freed page that was fetched back in, before its id is handed out again. Caller must
+   * hold latch_ through lock.
+   * @return false if the frame is pinned, the id must not be reused then
+   */
+  auto DropFreedFrame(std::unique_lock<std::mutex> *lock, page_id_t page_id) -> bool;
+
+  /** @brief Take a claimed frame out of the page table and the replacer, and reset it onto the free list. */
+  void FreeFrame(frame_id_t frame_id);
+
+  /** @brief Pin a resident frame and take it out of the replacer. Caller must hold latch_. */
+  void PinResident(frame_id_t frame_id);
+
+  /** @brief Drop a pin of PinResident, the frame goes back to the replacer with its last pin. */
+  void UnpinResident(frame_id_t frame_id);
+
+  /** Wait until no prefetch is reading the page. Caller must hold latch_ through lock. */
+  void WaitForPrefetch(std::unique_lock<std::mutex> *lock, page_id_t page_id);
+
+  /** Main loop of the background I/O threads. */
+  void PrefetchWorker();
+
+  /** Read one page into a free or evicted frame, unless it is already resident or being read. */
+  void PrefetchPage(page_id_t page_id);
+
+  /** Main loop of the background writer. */
+  void BackgroundWriter();
+
+  /** Write back the dirty pages among the next bg_writer_lookahead_ victims of the replacer. Takes no latch_. */
+  void CleanEvictionCandidates();
+
+  /** Evict pages into the free list until it holds bg_writer_free_target_ frames. */
+  void RefillFreeList();
 
-  // TODO(student): You may add additional private members and helper functions
+  /** @return the resident pages from the next victim of the replacer to the pinned pages. Caller must hold latch_. */
+  auto ResidentPagesByRecency() -> std::vector<page_id_t>;
 };
 }  // namespace bustub
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.h
+//
+// Identification: src/include/buffer/clock_pro_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ClockProReplacer implements CLOCK-Pro (Jiang, Chen and Zhang, USENIX ATC '05), an approximation of LIRS built on a
+ * single clock.
+ *
+ * Resident pages are hot or cold. A newly loaded page is cold and starts a test period; if it is referenced again
+ * during the test period it becomes hot. A cold page evicted during its test period stays in the clock as a
+ * non-resident entry, and loading it again both makes it hot and grows the number of frames kept for cold pages.
+ * Three hands sweep the clock: the cold hand evicts, the hot hand demotes unreferenced hot pages, and the test hand
+ * expires non-resident entries.
+ *
+ * Like the ARC replacer, references within correlated_loads_ loads of a page's own load do not set its reference
+ * bit, so a table scan touching each page once per tuple does not turn its pages hot.
+ */
+class ClockProReplacer : public Replacer {
+ public:
+  /**
+   * @brief Create a new ClockProReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ClockProReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ClockProReplacer);
+
+  ~ClockProReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordLoad(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override { return Evict(frame_id); }
+
+  void Pin(frame_id_t frame_id) override { SetEvictable(frame_id, false); }
+
+  void Unpin(frame_id_t frame_id) override {
+    RecordAccess(frame_id);
+    SetEvictable(frame_id, true);
+  }
+
+  /** @return the current number of frames targeted for cold pages, for tests */
+  auto GetColdTarget() -> size_t {
+    std::lock_guard<std::mutex> guard(latch_);
+    return cold_target_;
+  }
+
+ private:
+  struct Entry {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** -1 for a non-resident entry. */
+    frame_id_t frame_id_{-1};
+    bool hot_{false};
+    bool referenced_{false};
+    bool in_test_{false};
+    bool evictable_{false};
+    /** Value of load_clock_ when the page was loaded. */
+    size_t loaded_at_{0};
+  };
+  using EntryIter = std::list<Entry>::iterator;
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** @return the entry after it on the clock */
+  auto Next(EntryIter it) -> EntryIter;
+
+  /** Remove an entry from the clock, moving any hand that points at it to the next entry. */
+  void Erase(EntryIter it);
+
+  /** Forget a resident entry without keeping a non-resident entry for it. */
+  void EraseResident(EntryIter it);
+
+  /** Run the hot hand until the hot pages fit in the frames not targeted for cold pages. */
+  void RunHandHot();
+
+  /** Run the test hand until one non-resident entry has expired. */
+  void RunHandTest();
+
+  const size_t replacer_size_;
+  /** References to a page within this many loads of its own load are correlated. */
+  const size_t correlated_loads_;
+  /** Number of frames targeted for cold pages, m_c in the paper. */
+  size_t cold_target_;
+  /** Number of pages loaded so far. */
+  size_t load_clock_{0};
+
+  /** Clock order; new entries are inserted just behind the hot hand. */
+  std::list<Entry> clock_;
+  EntryIter hand_cold_;
+  EntryIter hand_hot_;
+  EntryIter hand_test_;
+
+  /** Entry of each frame, clock_.end() if the frame is not tracked. */
+  std::vector<EntryIter> frame_entry_;
+  /** Non-resident entries by page id. */
+  std::unordered_map<page_id_t, EntryIter> non_resident_;
+  size_t hot_count_{0};
+  size_t evictable_count_{0};
+
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_page_table.h
+//
+// Identification: src/include/buffer/concurrent_page_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ConcurrentPageTable maps page ids to frame ids for the buffer pool.
+ *
+ * It is a fixed-capacity, linear-probing hash table whose slots are single 64-bit atomics holding a packed
+ * (page_id, frame_id) pair, so a lookup never takes a lock and never sees a torn entry.
+ *
+ * Insert and Remove must be serialized by the caller (the buffer pool latch). A lookup made while holding that
+ * latch is exact. A lookup made without it is only a hint: it may miss an entry that is being moved, or return a
+ * frame that is just being handed to another page, so lock-free callers must validate the frame afterwards.
+ */
+class ConcurrentPageTable {
+ public:
+  /**
+   * @brief Create a page table that holds at most max_entries mappings at a time.
+   * @param max_entries the maximum number of live entries, i.e. the number of frames in the buffer pool
+   */
+  explicit ConcurrentPageTable(size_t max_entries);
+
+  DISALLOW_COPY_AND_MOVE(ConcurrentPageTable);
+
+  ~ConcurrentPageTable() = default;
+
+  /**
+   * @brief Find the frame that holds the given page. Safe to call without the buffer pool latch.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame holding the page, if found
+   * @return true if the page was found
+   */
+  auto Find(page_id_t page_id, frame_id_t &frame_id) const -> bool;
+
+  /**
+   * @brief Insert or overwrite the mapping for the given page. Caller must hold the buffer pool latch.
+   * @param page_id the page to insert, must not be INVALID_PAGE_ID
+   * @param frame_id the frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Remove the mapping for the given page. Caller must hold the buffer pool latch.
+   * @param page_id the page to remove
+   * @return true if the page was found and removed
+   */
+  auto Remove(page_id_t page_id) -> bool;
+
+  /** @return the number of live entries. Caller must hold the buffer pool latch. */
+  auto Size() const -> size_t { return num_entries_; }
+
+ private:
+  /** A slot that was never used, ends every probe sequence. Uses INVALID_PAGE_ID as key, so it matches no page. */
+  static constexpr uint64_t EMPTY_SLOT = ~static_cast<uint64_t>(0);
+  /** A slot whose entry was removed. Probes continue past it; Insert may reuse it. */
+  static constexpr uint64_t TOMBSTONE_SLOT = EMPTY_SLOT - 1;
+
+  static auto Pack(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static auto KeyOf(uint64_t slot) -> page_id_t { return static_cast<page_id_t>(slot >> 32); }
+  static auto ValueOf(uint64_t slot) -> frame_id_t { return static_cast<frame_id_t>(slot & 0xFFFFFFFF); }
+
+  /** @return the home slot of the page. Fibonacci hashing, so strided page ids do not cluster. */
+  auto HomeSlot(page_id_t page_id) const -> size_t {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               (64 - capacity_bits_));
+  }
+
+  /** Clear all tombstones by re-inserting the live entries into an empty table. */
+  void Rehash();
+
+  size_t capacity_bits_;
+  size_t capacity_;
+  /** Live entries, maintained by the latch holder. */
+  size_t num_entries_{0};
+  /** Removed entries that still occupy a slot, maintained by the latch holder. */
+  size_t num_tombstones_{0};
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+}  // namespace bustub
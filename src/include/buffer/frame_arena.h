@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the data of every frame of a buffer pool in one zero-filled mapping, BUSTUB_PAGE_SIZE bytes per
+ * frame, so that the frame data is contiguous and not interleaved with the frames' metadata. Being page aligned, every
+ * frame meets the DIRECT_IO_ALIGNMENT that O_DIRECT reads and writes need.
+ *
+ * With huge pages requested, the arena is first mapped with MAP_HUGETLB. If the system has no huge pages reserved, it
+ * falls back to a regular mapping aligned to HUGE_PAGE_SIZE and advised with MADV_HUGEPAGE, so that transparent huge
+ * pages can back it.
+ */
+class FrameArena {
+ public:
+  /** Size of the huge pages the arena is aligned to. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * @brief Map the arena. Throws an Exception if the memory cannot be mapped at all.
+   * @param num_frames number of frames
+   * @param use_huge_pages true to back the arena with huge pages where the system allows it
+   */
+  FrameArena(size_t num_frames, bool use_huge_pages);
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  ~FrameArena();
+
+  /** @return the data of a frame */
+  auto GetFrame(size_t frame_id) -> char * { return data_ + frame_id * BUSTUB_PAGE_SIZE; }
+
+  /** @return true if the arena is mapped with MAP_HUGETLB, false if it is a regular mapping */
+  auto IsHugeTLB() const -> bool { return huge_tlb_; }
+
+ private:
+  /** Start of the arena. */
+  char *data_{nullptr};
+  /** Start and length of the whole mapping, which may be larger than the arena to align it. */
+  void *mapping_{nullptr};
+  size_t mapping_size_{0};
+  bool huge_tlb_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_heap_replacer.h
+//
+// Identification: src/include/buffer/lru_k_heap_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * HeapLRUKReplacer implements the same LRU-k policy as LRUKReplacer, with flat per-frame storage.
+ *
+ * Every frame owns a ring buffer of its last k access timestamps in one array indexed by frame id, so recording an
+ * access never allocates. Evictable frames sit in an indexed binary min-heap ordered by their eviction key:
+ * frames with fewer than k accesses (+inf backward k-distance) come first, ordered by their earliest access, and
+ * then frames ordered by their k-th most recent access. RecordAccess, SetEvictable, Evict and Remove are all
+ * O(log n) in the number of evictable frames.
+ */
+class HeapLRUKReplacer : public Replacer {
+ public:
+  /**
+   * @brief Create a new HeapLRUKReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   * @param k the number of accesses the backward k-distance is computed over
+   */
+  HeapLRUKReplacer(size_t num_frames, size_t k);
+
+  DISALLOW_COPY_AND_MOVE(HeapLRUKReplacer);
+
+  ~HeapLRUKReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> override;
+
+  // The legacy Replacer interface, expressed through the LRU-K one. Unpin starts a history for untracked frames.
+
+  auto Victim(frame_id_t *frame_id) -> bool override { return Evict(frame_id); }
+
+  void Pin(frame_id_t frame_id) override { SetEvictable(frame_id, false); }
+
+  void Unpin(frame_id_t frame_id) override {
+    RecordAccess(frame_id);
+    SetEvictable(frame_id, true);
+  }
+
+ private:
+  /** Heap position of a frame that is not in the heap. */
+  static constexpr size_t NOT_IN_HEAP = static_cast<size_t>(-1);
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** @return true if frame a should be evicted before frame b */
+  auto EvictsBefore(frame_id_t a, frame_id_t b) const -> bool;
+
+  /** @return the timestamp that orders the frame in the heap, see the class comment */
+  auto KeyTimestamp(frame_id_t frame_id) const -> size_t;
+
+  void HeapPush(frame_id_t frame_id);
+  void HeapErase(frame_id_t frame_id);
+  void SiftUp(size_t pos);
+  void SiftDown(size_t pos);
+  void HeapSwap(size_t a, size_t b);
+
+  /** Forget the frame's access history. */
+  void ResetFrame(frame_id_t frame_id);
+
+  const size_t replacer_size_;
+  const size_t k_;
+  size_t current_timestamp_{0};
+
+  /** Ring buffers of access timestamps: frame f uses history_[f * k_, (f + 1) * k_). */
+  std::vector<size_t> history_;
+  /** Number of accesses recorded per frame since it was last evicted or removed, 0 if untracked. */
+  std::vector<size_t> access_count_;
+  /** Position of each frame in heap_, NOT_IN_HEAP unless the frame is evictable. */
+  std::vector<size_t> heap_pos_;
+  /** Indexed min-heap over the evictable frames. */
+  std::vector<frame_id_t> heap_;
+
+  std::mutex latch_;
+};
+
+}  // namespace bustub
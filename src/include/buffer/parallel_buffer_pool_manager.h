@@ -0,0 +1,158 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager spreads pages over several BufferPoolManagerInstance shards, each with its own latch,
+ * page table and replacer. A page always lives in the shard `page_id % num_instances`, so requests for different
+ * pages mostly contend on different latches.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of every instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRUK);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return size of the buffer pool, summed over all instances */
+  auto GetPoolSize() -> size_t override;
+
+  /** @return the number of BufferPoolManagerInstances in this pool */
+  auto GetNumInstances() const -> size_t { return num_instances_; }
+
+  /**
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManagerInstance responsible for handling given page id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /** Start the background writer of every instance. */
+  void RunBackgroundWriter() override;
+
+  /** Stop the background writer of every instance. */
+  void StopBackgroundWriter() override;
+
+  /** Give every instance its own warm start file, path suffixed with the instance index. */
+  void SetWarmStartFile(const std::string &path) override;
+
+  /** Dump the resident pages of every instance. */
+  void DumpResidentPages() override;
+
+  /** Warm up every instance from its own file. */
+  auto WarmStart() -> size_t override;
+
+  /** The dirty page tables of all instances together. */
+  auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> override;
+
+ protected:
+  /**
+   * Fetch the requested page from the buffer pool.
+   * @param page_id id of page to be fetched
+   * @return the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * Unpin the target page from the buffer pool.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * Flushes the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * Creates a new page in the buffer pool.
+   *
+   * Instances are tried round-robin, starting from a different instance on every call, so that consecutive
+   * new pages are spread evenly across the shards. The call only fails if every instance is full.
+   *
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * Creates a new page in the buffer pool, close to near_page_id on disk.
+   *
+   * The instance owning near_page_id is tried first, since the pages it allocates are in the same residue class and
+   * can be adjacent on disk. If it is full, the other instances are tried like in NewPgImp.
+   *
+   * @param[out] page_id id of created page
+   * @param near_page_id a page the new page should be close to
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * override;
+
+  /**
+   * Deletes a page from the buffer pool.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * Flushes all the pages in the buffer pool to disk.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * Hands each page to the prefetch queue of the instance that owns it.
+   * @param page_ids ids of the pages to prefetch
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids) override;
+
+ private:
+  /** Number of BufferPoolManagerInstances. */
+  const size_t num_instances_;
+  /** Pool size of each BufferPoolManagerInstance. */
+  const size_t pool_size_;
+  /** The BufferPoolManagerInstances, indexed by page_id % num_instances_. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+  /** The instance NewPgImp should try first on its next call. */
+  std::atomic<size_t> next_instance_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_window.h
+//
+// Identification: src/include/buffer/read_ahead_window.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <future>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ReadAheadWindow keeps the pages after a scan's current page prefetching in the buffer pool, for page chains such
+ * as the pages of a table heap or the leaves of a B+ tree.
+ *
+ * Page ids in a chain are only known once the previous page is in memory, so the window follows the links from the
+ * last page it requested. That page's read was queued a full window earlier, so once the window is full the scan
+ * rarely waits for it. When the window starts over, each page of the chain is only requested right before it would be
+ * read, so a background task fills the window and the scan takes the pages over once the task is done.
+ */
+class ReadAheadWindow {
+ public:
+  /** Reads the id of the page after this one from a page of the chain. */
+  using NextPageFn = page_id_t (*)(Page *page);
+
+  /** A disabled window. */
+  ReadAheadWindow() = default;
+
+  /**
+   * @param bpm the buffer pool to prefetch into
+   * @param window number of pages to keep requested ahead of the current one, capped at a quarter of the pool so
+   * read-ahead cannot push out the pages the scan is about to use
+   * @param next_page_of reads the next page id from a page of the chain
+   */
+  ReadAheadWindow(BufferPoolManager *bpm, size_t window, NextPageFn next_page_of);
+
+  /**
+   * Called when the scan reaches a page. Requests pages until the window is full again.
+   * @param page_id the page the scan is on
+   * @param next_page_id the page after it, read by the caller who holds its latch
+   */
+  void Advance(page_id_t page_id, page_id_t next_page_id);
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  size_t window_{0};
+  NextPageFn next_page_of_{nullptr};
+  /** Pages after the current one that were requested, in chain order. */
+  std::deque<page_id_t> pages_;
+  /** The pages after pages_.back() requested by the background task filling the window, if one runs. */
+  std::shared_future<std::vector<page_id_t>> fill_;
+};
+
+}  // namespace bustub
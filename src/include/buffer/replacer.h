@@ -12,18 +12,104 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a BufferPoolManagerInstance can be created with. */
+enum class ReplacerType {
+  /** LRUKReplacer, list based LRU-K. */
+  LRUK,
+  /** HeapLRUKReplacer, LRU-K over per-frame ring buffers and an indexed min-heap. */
+  HEAP_LRUK,
+  /** TwoQReplacer, scan resistant 2Q. */
+  TWO_Q,
+  /** ARCReplacer, adaptive replacement cache. */
+  ARC,
+  /** ClockProReplacer, CLOCK-Pro. */
+  CLOCK_PRO,
+};
+
 /**
  * Replacer is an abstract class that tracks page usage.
+ *
+ * The buffer pool drives a replacer through the frame-level interface (RecordAccess, SetEvictable, Evict, Remove).
+ * Its default implementation maps onto the older Victim / Pin / Unpin interface, so replacers that only implement
+ * the latter still work, just without access history.
  */
 class Replacer {
  public:
   Replacer() = default;
   virtual ~Replacer() = default;
 
+  /**
+   * Create a replacer of the given type.
+   * @param type the replacement policy
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   * @param k the lookback constant k, only used by the LRU-K replacers
+   */
+  static auto Create(ReplacerType type, size_t num_frames, size_t k) -> std::unique_ptr<Replacer>;
+
+  /**
+   * Parse a replacement policy name: lru_k, heap_lru_k, 2q, arc or clock_pro.
+   * @param name the policy name
+   * @param[out] type the parsed policy
+   * @return false if the name is unknown
+   */
+  static auto ParseType(const std::string &name, ReplacerType *type) -> bool;
+
+  /**
+   * Evict the frame chosen by the replacement policy among the evictable frames, and drop its access history.
+   * @param[out] frame_id id of the evicted frame
+   * @return true if a frame was evicted, false if no frame is evictable
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool { return Victim(frame_id); }
+
+  /**
+   * Record that the frame was accessed now, starting its access history if it has none.
+   * @param frame_id id of the accessed frame
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Record that the frame was just filled with the given page, after the RecordAccess for that load. Policies that
+   * remember recently evicted pages (2Q, ARC, CLOCK-Pro) use it to recognize a page coming back; others ignore it.
+   * @param frame_id id of the frame
+   * @param page_id id of the page now held by the frame
+   */
+  virtual void RecordLoad(frame_id_t frame_id, page_id_t page_id) {}
+
+  /**
+   * Mark a frame as evictable or non-evictable. Size() counts the evictable frames.
+   * @param frame_id id of the frame
+   * @param set_evictable whether the frame may be evicted
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) {
+    if (set_evictable) {
+      Unpin(frame_id);
+    } else {
+      Pin(frame_id);
+    }
+  }
+
+  /**
+   * Drop an evictable frame and its access history, regardless of the replacement policy.
+   * @param frame_id id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * List the evictable frames that would be evicted first, without evicting them or touching their history. The
+   * background writer uses it to clean dirty pages before they become victims. Policies that cannot tell return none.
+   * @param max_count maximum number of frames to return
+   * @return up to max_count evictable frames, the next victim first
+   */
+  virtual auto EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> { return {}; }
+
   /**
    * Remove the victim frame as defined by the replacement policy.
    * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
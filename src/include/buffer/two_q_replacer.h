@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.h
+//
+// Identification: src/include/buffer/two_q_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQReplacer implements the full 2Q policy (Johnson and Shasha, VLDB '94).
+ *
+ * A newly loaded page enters A1in, a FIFO that absorbs correlated references. When it is evicted from A1in its page
+ * id is remembered in A1out, a FIFO of ghost entries. A page that is loaded again while still in A1out has proven
+ * it is reused and goes to Am, an LRU list. A one-time sequential scan therefore only cycles through A1in and never
+ * pushes the pages in Am out.
+ */
+class TwoQReplacer : public Replacer {
+ public:
+  /**
+   * @brief Create a new TwoQReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit TwoQReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQReplacer);
+
+  ~TwoQReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordLoad(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_count) -> std::vector<frame_id_t> override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override { return Evict(frame_id); }
+
+  void Pin(frame_id_t frame_id) override { SetEvictable(frame_id, false); }
+
+  void Unpin(frame_id_t frame_id) override {
+    RecordAccess(frame_id);
+    SetEvictable(frame_id, true);
+  }
+
+ private:
+  enum class Queue { NONE, A1IN, AM };
+
+  struct FrameInfo {
+    Queue queue_{Queue::NONE};
+    bool evictable_{false};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** Evict the oldest evictable frame of the list, which is ordered newest first. */
+  auto EvictFrom(std::list<frame_id_t> *list, frame_id_t *frame_id) -> bool;
+
+  /** Drop the frame from its queue and forget it. */
+  void Untrack(frame_id_t frame_id);
+
+  const size_t replacer_size_;
+  /** Target size of A1in, 25% of the frames. */
+  const size_t kin_;
+  /** Maximum number of A1out ghost entries, 50% of the frames. */
+  const size_t kout_;
+
+  std::vector<FrameInfo> frames_;
+  /** Newest first. */
+  std::list<frame_id_t> a1in_;
+  /** Most recently used first. */
+  std::list<frame_id_t> am_;
+  /** Page ids evicted from A1in, newest first. */
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_map_;
+  size_t evictable_count_{0};
+
+  std::mutex latch_;
+};
+
+}  // namespace bustub
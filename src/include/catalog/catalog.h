@@ -228,12 +228,21 @@ class Catalog {
     // TODO(chi): support both hash index and btree index
     auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap, sorted and loaded bottom-up
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
-    }
+    auto tuple = heap->Begin(txn);
+    index->BulkLoad(
+        [&](Tuple *key, RID *rid) {
+          if (tuple == heap->End()) {
+            return false;
+          }
+          *key = tuple->KeyFromTuple(schema, key_schema, key_attrs);
+          *rid = tuple->GetRid();
+          ++tuple;
+          return true;
+        },
+        txn);
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
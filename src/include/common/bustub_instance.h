@@ -22,9 +22,11 @@
 #include <utility>
 #include <vector>
 
+#include "buffer/replacer.h"
 #include "catalog/catalog.h"
 #include "common/config.h"
 #include "common/util/string_util.h"
+#include "concurrency/lock_manager.h"
 #include "libfort/lib/fort.hpp"
 #include "type/value.h"
 
@@ -34,7 +36,6 @@ class Transaction;
 class ExecutorContext;
 class DiskManager;
 class BufferPoolManager;
-class LockManager;
 class TransactionManager;
 class LogManager;
 class CheckpointManager;
@@ -211,9 +212,24 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  /**
+   * @param db_file_name the database file to open
+   * @param bpm_instances number of buffer pool instances; more than one creates a ParallelBufferPoolManager
+   * @param replacer_type the replacement policy of the buffer pool
+   * @param deadlock_policy how the lock manager resolves deadlocks
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t bpm_instances = 1,
+                          ReplacerType replacer_type = ReplacerType::LRUK,
+                          DeadlockPolicy deadlock_policy = DeadlockPolicy::DETECTION);
 
-  BustubInstance();
+  /**
+   * Create an in-memory BusTub instance.
+   * @param bpm_instances number of buffer pool instances; more than one creates a ParallelBufferPoolManager
+   * @param replacer_type the replacement policy of the buffer pool
+   * @param deadlock_policy how the lock manager resolves deadlocks
+   */
+  explicit BustubInstance(size_t bpm_instances = 1, ReplacerType replacer_type = ReplacerType::LRUK,
+                          DeadlockPolicy deadlock_policy = DeadlockPolicy::DETECTION);
 
   ~BustubInstance();
 
@@ -27,6 +27,36 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** Number of pages sequential scans and index iterators keep prefetching ahead of the current page, 0 disables it. */
+extern std::atomic<size_t> scan_prefetch_window;
+
+/** True if buffer pools created from now on should back their frames with huge pages where the system allows it. */
+extern std::atomic<bool> enable_huge_page_frames;
+
+/** A running background writer cleans the pages near the eviction end of its buffer pool every BG_WRITER_INTERVAL. */
+extern std::chrono::milliseconds bg_writer_interval;
+
+/** True if disk managers opened from now on should bypass the page cache with O_DIRECT where the file system allows. */
+extern std::atomic<bool> enable_direct_io;
+
+/** True if tablespaces should allocate new segment files in full when they create them. */
+extern std::atomic<bool> enable_segment_preallocation;
+
+/** A running background writer dumps the resident pages to the warm start file every WARM_START_DUMP_INTERVAL. */
+extern std::chrono::milliseconds warm_start_dump_interval;
+
+/** A transaction holding this many row locks on a table trades them for a table lock where it can, 0 disables it. */
+extern std::atomic<size_t> lock_escalation_threshold;
+
+/** A running version garbage collector drops the versions no snapshot can see every VERSION_GC_INTERVAL. */
+extern std::chrono::milliseconds version_gc_interval;
+
+/** A running epoch advancer starts a new epoch of optimistic commit timestamps every OCC_EPOCH_INTERVAL. */
+extern std::chrono::milliseconds occ_epoch_interval;
+
+/** Share of the slots of a page that bulk loading a B+ tree fills, the rest is left for later inserts. */
+extern std::atomic<double> bulk_load_fill_factor;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
@@ -36,11 +66,30 @@ static constexpr int BUFFER_POOL_SIZE = 10;
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int PREFETCH_IO_THREADS = 2;  // background I/O threads serving prefetches, per buffer pool instance
+static constexpr size_t BUSTUB_CACHE_LINE_SIZE = 64;  // frame metadata is aligned to this
+static constexpr size_t WARM_START_READ_PAGES = 64;   // most pages read at once when warming up a buffer pool
+static constexpr unsigned URING_QUEUE_DEPTH = 64;     // most requests DiskManagerUring keeps in flight
+static constexpr size_t RECOVERY_REDO_THREADS = 4;    // workers redoing the log, each owning a share of the pages
+static constexpr int DISK_IO_THREADS = 4;             // pread/pwrite threads of DiskManagerUring without io_uring
+static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;   // buffers and offsets of O_DIRECT I/O are aligned to this
+static constexpr size_t TABLESPACE_SEGMENT_PAGES = (1 << 30) / BUSTUB_PAGE_SIZE;  // pages per 1 GiB segment file
+static constexpr size_t FSM_SEARCH_WINDOW = 64;  // how far from its hint the free-space map looks for a free page
+static constexpr size_t LOCK_TABLE_BUCKETS = 1024;  // partitions of the row lock table, each with its own latch
+static constexpr size_t VERSION_STORE_BUCKETS = 256;  // partitions of the version store, each with its own latch
+static constexpr size_t OCC_WORD_BUCKETS = 256;       // partitions of the optimistic version words, each with a latch
+static constexpr size_t TXN_INLINE_TABLE_LOCKS = 4;   // table locks of one mode a transaction tracks inline
+static constexpr size_t TXN_INLINE_ROW_LOCKS = 16;    // row locks per table and mode a transaction tracks inline
+static constexpr size_t TXN_POOL_SIZE = 16;           // finished transactions each thread keeps for Begin to reuse
+static constexpr int BPLUSTREE_OPTIMISTIC_RESTARTS = 8;  // optimistic descents of a B+ tree operation before it crabs
+static constexpr size_t EXTERNAL_SORT_RUN_BYTES = 64 << 20;  // bytes an external sort sorts in memory per run
+static constexpr size_t EXTERNAL_SORT_FAN_IN = 16;           // runs an external sort merges at once
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
 using txn_id_t = int32_t;      // transaction id type
 using lsn_t = int32_t;         // log sequence number type
+using timestamp_t = int64_t;   // commit timestamp type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
@@ -14,9 +14,11 @@
 
 #include <algorithm>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -30,8 +32,36 @@ namespace bustub {
 
 class TransactionManager;
 
+/** How a LockManager keeps transactions that wait for each other's locks from waiting forever. */
+enum class DeadlockPolicy {
+  /** Wait freely, a background thread looks for cycles in the waits-for graph and aborts the youngest transaction. */
+  DETECTION,
+  /** An older transaction aborts the younger ones in its way, a younger one waits for older ones. */
+  WOUND_WAIT,
+  /** An older transaction waits for younger ones, a younger one aborts itself instead of waiting for an older one. */
+  WAIT_DIE,
+};
+
 /**
  * LockManager handles transactions asking for locks on records.
+ *
+ * Table locks are few, their queues hang off one map under table_lock_map_latch_. The row lock table is split into
+ * LOCK_TABLE_BUCKETS cache-line aligned buckets by the hash of (oid, rid), each with its own map and latch, so that
+ * row locks on different rows rarely meet on a latch. A bucket latch is only held to find the queue of a row, or to
+ * drop it once the last request is gone; waiting happens on the latch and condition variable of the queue.
+ *
+ * The LockRequest objects of a transaction come from its LockRequestPool and go back there on unlock.
+ *
+ * Once a transaction holds lock_escalation_threshold row locks on a table, LockRow escalates them: the intention lock
+ * on the table becomes the weakest of S, SIX or X that covers them (SIX keeps the X row locks), and the row locks it
+ * covers are released. Escalation never waits. If another transaction holds a lock on the table in the way, the row
+ * locks are kept, and the next attempt comes once as many row locks more are held. Row locks the table lock covers
+ * are granted without a request from then on, and unlocking them does nothing.
+ *
+ * Under DETECTION a deadlock lasts until the next round of the cycle detection thread. WOUND_WAIT and WAIT_DIE decide
+ * whenever a request has to wait, using the transaction id as its timestamp, so that waits only ever go from older to
+ * younger transactions (or from younger to older ones) and can never close a cycle. An aborted transaction restarts
+ * with a new id, so it is not the oldest one when it comes back.
  */
 class LockManager {
  public:
@@ -74,19 +104,37 @@ class LockManager {
   };
 
   /**
-   * Creates a new lock manager configured for the deadlock detection policy.
+   * Creates a new lock manager configured for the given deadlock policy.
+   * @param deadlock_policy how deadlocks are resolved, only DETECTION runs the cycle detection thread
    */
-  LockManager() {
-    enable_cycle_detection_ = true;
-    cycle_detection_thread_ = new std::thread(&LockManager::RunCycleDetection, this);
+  explicit LockManager(DeadlockPolicy deadlock_policy = DeadlockPolicy::DETECTION) : deadlock_policy_(deadlock_policy) {
+    enable_cycle_detection_ = deadlock_policy == DeadlockPolicy::DETECTION;
+    if (enable_cycle_detection_) {
+      cycle_detection_thread_ = new std::thread(&LockManager::RunCycleDetection, this);
+    }
   }
 
   ~LockManager() {
     enable_cycle_detection_ = false;
-    cycle_detection_thread_->join();
-    delete cycle_detection_thread_;
+    if (cycle_detection_thread_ != nullptr) {
+      cycle_detection_thread_->join();
+      delete cycle_detection_thread_;
+    }
   }
 
+  /** @return the number of times row locks were escalated to a table lock */
+  auto GetNumEscalations() const -> size_t { return num_escalations_; }
+
+  /** @return the deadlock policy of this lock manager */
+  auto GetDeadlockPolicy() const -> DeadlockPolicy { return deadlock_policy_; }
+
+  /**
+   * Parse the name of a deadlock policy: detection, wound_wait or wait_die.
+   * @param[out] policy the policy, if the name is known
+   * @return false if the name is unknown
+   */
+  static auto ParseDeadlockPolicy(const std::string &name, DeadlockPolicy *policy) -> bool;
+
   /**
    * [LOCK_NOTE]
    *
@@ -304,16 +352,127 @@ class LockManager {
   /** Coordination */
   std::mutex table_lock_map_latch_;
 
-  /** Structure that holds lock requests for a given RID */
-  std::unordered_map<RID, std::shared_ptr<LockRequestQueue>> row_lock_map_;
-  /** Coordination */
-  std::mutex row_lock_map_latch_;
+  /** A partition of the row lock table, alone on its cache lines. */
+  struct alignas(BUSTUB_CACHE_LINE_SIZE) RowLockBucket {
+    /** Structure that holds lock requests for the RIDs of this bucket */
+    std::unordered_map<RID, std::shared_ptr<LockRequestQueue>> row_lock_map_;
+    /** Coordination */
+    std::mutex latch_;
+  };
+
+  /** @return the bucket of the row lock table that holds the queue of rid */
+  auto BucketOf(const table_oid_t &oid, const RID &rid) -> RowLockBucket &;
+
+  /** Abort txn if its isolation level and state do not allow it to take a lock in lock_mode. */
+  static void CheckLockAllowed(Transaction *txn, LockMode lock_mode);
+
+  /**
+   * Enqueue a request of txn, or upgrade the one it has, and wait until it is granted.
+   * @param lock holds the latch of queue
+   * @param rid the row, nullptr for a table lock
+   * @return false if txn was aborted while waiting
+   */
+  auto Acquire(Transaction *txn, LockMode lock_mode, const std::shared_ptr<LockRequestQueue> &queue,
+               std::unique_lock<std::mutex> *lock, const table_oid_t &oid, const RID *rid) -> bool;
+
+  /**
+   * Apply the deadlock policy to a request that cannot be granted yet: abort txn under WAIT_DIE if an older
+   * transaction is in its way, abort the younger transactions in its way under WOUND_WAIT.
+   * @param[out] wounded the transactions aborted by this call
+   */
+  void PreventDeadlock(Transaction *txn, const LockRequestQueue &queue, const LockRequest *request,
+                       std::vector<txn_id_t> *wounded);
+
+  /** Wake up txn_id if it waits for a lock, so that it sees it was aborted. No queue latch may be held. */
+  void WakeUp(txn_id_t txn_id);
+
+  /** @return the edges of the waits-for graph, from every waiting request to the requests in its way */
+  auto CollectWaitsFor() -> std::vector<std::pair<txn_id_t, txn_id_t>>;
+
+  /**
+   * Depth first search for a cycle through txn_id, over waits_for_ in ascending transaction id order.
+   * @param[out] newest the newest transaction in the cycle, if one was found
+   */
+  auto FindCycle(txn_id_t txn_id, std::vector<txn_id_t> *path, std::unordered_set<txn_id_t> *visited,
+                 txn_id_t *newest) -> bool;
+
+  /**
+   * Remove the granted request of txn from queue, and wake up the waiters.
+   * @param rid the row, nullptr for a table lock
+   * @param update_state false to keep txn from shrinking, when the lock is given up for a table lock
+   */
+  void Release(Transaction *txn, LockRequestQueue *queue, const RID *rid, bool update_state);
+
+  /**
+   * Release the row lock of txn on rid, and drop the queue of the row once it is empty.
+   * @return false if nobody locked the row
+   */
+  auto ReleaseRow(Transaction *txn, const table_oid_t &oid, const RID &rid, bool update_state) -> bool;
+
+  /** Escalate the row locks of txn on table oid to a table lock, if it holds enough of them and nobody is in the way. */
+  void TryEscalate(Transaction *txn, const table_oid_t &oid);
+
+  /** @return true if request is compatible with every request ahead of it in the queue */
+  static auto IsGrantable(const LockRequestQueue &queue, const LockRequest *request) -> bool;
+
+  static auto AreCompatible(LockMode held, LockMode requested) -> bool;
+
+  static auto CanUpgrade(LockMode from, LockMode to) -> bool;
+
+  /** Add a granted request to the lock sets of txn, or remove it. */
+  static void UpdateLockSet(Transaction *txn, const LockRequest *request, bool is_row, bool insert);
+
+  /** Set txn to ABORTED and throw a TransactionAbortException. */
+  [[noreturn]] static void AbortTransaction(Transaction *txn, AbortReason reason);
+
+  /** @return the lock request pool of txn, created on its first lock */
+  static auto PoolOf(Transaction *txn) -> LockRequestPool *;
+
+  /** The row lock table, LOCK_TABLE_BUCKETS buckets. */
+  std::unique_ptr<RowLockBucket[]> row_lock_buckets_{new RowLockBucket[LOCK_TABLE_BUCKETS]};
+
+  const DeadlockPolicy deadlock_policy_;
+  std::atomic<size_t> num_escalations_{0};
+  /** The queue every waiting transaction waits on, to wake up the ones aborted by someone else. */
+  std::unordered_map<txn_id_t, std::shared_ptr<LockRequestQueue>> waiting_on_;
+  std::mutex waiting_on_latch_;
 
   std::atomic<bool> enable_cycle_detection_;
-  std::thread *cycle_detection_thread_;
-  /** Waits-for graph representation. */
+  std::thread *cycle_detection_thread_{nullptr};
+  /** Waits-for graph representation, the transactions each one waits for in ascending order. */
   std::unordered_map<txn_id_t, std::vector<txn_id_t>> waits_for_;
   std::mutex waits_for_latch_;
 };
 
+/**
+ * The lock requests of one transaction. Freed requests are kept on a free list for the next lock, and the storage
+ * only goes back to the allocator with the transaction.
+ */
+class LockRequestPool {
+ public:
+  template <typename... Args>
+  auto New(Args &&...args) -> LockManager::LockRequest * {
+    const std::lock_guard<std::mutex> guard(latch_);
+    if (free_list_.empty()) {
+      // a deque never moves its elements
+      return &requests_.emplace_back(std::forward<Args>(args)...);
+    }
+    LockManager::LockRequest *request = free_list_.back();
+    free_list_.pop_back();
+    *request = LockManager::LockRequest(std::forward<Args>(args)...);
+    return request;
+  }
+
+  void Delete(LockManager::LockRequest *request) {
+    const std::lock_guard<std::mutex> guard(latch_);
+    free_list_.push_back(request);
+  }
+
+ private:
+  std::deque<LockManager::LockRequest> requests_;
+  std::vector<LockManager::LockRequest *> free_list_;
+  /** A transaction usually locks from one thread, but its locks may be released from another. */
+  std::mutex latch_;
+};
+
 }  // namespace bustub
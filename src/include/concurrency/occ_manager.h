@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// occ_manager.h
+//
+// Identification: src/include/concurrency/occ_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+class Transaction;
+
+/**
+ * OccManager keeps the version words of the tuples for OPTIMISTIC transactions, which run Silo-style optimistic
+ * concurrency control instead of taking locks.
+ *
+ * A version word holds the commit timestamp (TID) of the last write to the tuple, and a lock bit. A TID is the epoch
+ * in its upper 32 bits and a sequence number in the lower ones. While a transaction that inserted a tuple runs, the
+ * word is marked absent and holds the id of the inserter instead, so that other optimistic transactions do not see
+ * the tuple yet.
+ *
+ * An optimistic transaction records the word of every tuple it reads in its read set and buffers its updates and
+ * deletes. To commit, it locks the words of the tuples it writes in RID order, validates that none of the words it
+ * read changed or is locked by somebody else, applies its writes to the table heaps, and releases the locks by
+ * storing its TID in the words. The TID is larger than every TID the transaction saw and than the last one of its
+ * thread, and in the current epoch, which a background thread advances every occ_epoch_interval.
+ *
+ * Writes of other transactions bump the words as well, so that optimistic readers notice them.
+ *
+ * Lookups of existing words take no latch, they walk the chain of their bucket and only count themselves as its
+ * readers. Once no running optimistic transaction began before
+ * the last access to an unlocked word, Reclaim unlinks it, and deletes it when no lookup is in the bucket anymore.
+ * Every new epoch reclaims words.
+ */
+class OccManager {
+ public:
+  /** The word is locked by a committing writer. */
+  static constexpr uint64_t LOCK_BIT = 1;
+  /** The tuple was inserted by a running transaction, whose id is in the rest of the word. */
+  static constexpr uint64_t ABSENT_BIT = 2;
+  static constexpr int WORD_SHIFT = 2;
+  /** The word was reclaimed, whoever finds it looks the tuple up again. No live word has every bit set. */
+  static constexpr uint64_t RECLAIMED_WORD = ~uint64_t{0};
+
+  OccManager() = default;
+
+  /** Stops the epoch advancer. */
+  ~OccManager() { StopEpochAdvancer(); }
+
+  DISALLOW_COPY_AND_MOVE(OccManager);
+
+  /** Record that an optimistic transaction begins, the words it may read are kept until it ends. */
+  void Register(Transaction *txn);
+
+  /** Record that an optimistic transaction ended. */
+  void Unregister(Transaction *txn);
+
+  /** @return the version word of rid, created on the first access */
+  auto LoadWord(const RID &rid) -> uint64_t;
+
+  /** Mark a tuple txn just inserted as absent for the other transactions. */
+  void MarkAbsent(const RID &rid, txn_id_t txn_id);
+
+  /** Bump the TID of a tuple a transaction changes without validation, the lock bit stays. */
+  void BumpWord(const RID &rid);
+
+  /** @return true if a transaction that read word would see the tuple */
+  static auto IsVisible(uint64_t word, txn_id_t txn_id) -> bool {
+    return (word & ABSENT_BIT) == 0 || static_cast<txn_id_t>(word >> WORD_SHIFT) == txn_id;
+  }
+
+  /**
+   * Lock the words of the tuples txn writes, validate its read set and hand out its TID.
+   * @param txn the committing transaction
+   * @param write_rids the tuples txn writes, sorted and without duplicates
+   * @param[out] tid the TID of txn
+   * @return false if validation failed, the words are unlocked then
+   */
+  auto LockAndValidate(Transaction *txn, const std::vector<RID> &write_rids, uint64_t *tid) -> bool;
+
+  /** Store tid in the words of write_rids and unlock them. */
+  void Publish(const std::vector<RID> &write_rids, uint64_t tid);
+
+  /** Unlock the words of write_rids, leaving the TIDs as they were. */
+  void Unlock(const std::vector<RID> &write_rids);
+
+  /** @return the current epoch */
+  auto GetEpoch() const -> uint64_t { return epoch_; }
+
+  /** Move to the next epoch, and reclaim the words no running transaction may need. */
+  void AdvanceEpoch();
+
+  /**
+   * Unlink the unlocked words last accessed before the oldest running optimistic transaction began.
+   * @return the number of words unlinked
+   */
+  auto Reclaim() -> size_t;
+
+  /** @return the number of words in the chains */
+  auto GetNumWords() -> size_t;
+
+  /** @brief Start a thread that advances the epoch every occ_epoch_interval. */
+  void RunEpochAdvancer();
+
+  /** @brief Stop and join the epoch advancer thread. */
+  void StopEpochAdvancer();
+
+ private:
+  struct WordNode {
+    explicit WordNode(const RID &rid, uint64_t epoch) : rid_(rid), access_epoch_(epoch) {}
+
+    const RID rid_;
+    std::atomic<uint64_t> word_{0};
+    /** The epoch of the last access to the word. */
+    std::atomic<uint64_t> access_epoch_;
+    std::atomic<WordNode *> next_{nullptr};
+  };
+
+  struct alignas(BUSTUB_CACHE_LINE_SIZE) WordBucket {
+    ~WordBucket();
+
+    /** The words of the bucket, newest first. */
+    std::atomic<WordNode *> head_{nullptr};
+    /** Lookups walking the chain. The nodes Reclaim unlinked are deleted once there are none. */
+    std::atomic<int> readers_{0};
+    /** Taken by inserts and Reclaim, which change the chain. */
+    std::mutex latch_;
+    /** Unlinked nodes a lookup may still be on, protected by latch_. */
+    std::vector<WordNode *> retired_;
+  };
+
+  /** Counts a lookup as a reader of its bucket, the nodes it finds stay valid until the guard goes away. */
+  class BucketReadGuard {
+   public:
+    explicit BucketReadGuard(WordBucket *bucket) : bucket_(bucket) { bucket_->readers_.fetch_add(1); }
+    ~BucketReadGuard() { bucket_->readers_.fetch_sub(1); }
+    DISALLOW_COPY_AND_MOVE(BucketReadGuard);
+
+   private:
+    WordBucket *bucket_;
+  };
+
+  auto BucketOf(const RID &rid) -> WordBucket & { return buckets_[std::hash<RID>()(rid) % OCC_WORD_BUCKETS]; }
+
+  /** @return the word of rid in bucket, nullptr if it has none. The caller holds a BucketReadGuard. */
+  auto FindWord(WordBucket *bucket, const RID &rid) -> std::atomic<uint64_t> *;
+
+  /** @return the word of rid in bucket, inserted if it has none. The caller holds a BucketReadGuard. */
+  auto FindOrInsertWord(WordBucket *bucket, const RID &rid) -> std::atomic<uint64_t> *;
+
+  /** Main loop of the epoch advancer thread. */
+  void EpochAdvancer();
+
+  std::unique_ptr<WordBucket[]> buckets_{new WordBucket[OCC_WORD_BUCKETS]};
+
+  std::atomic<uint64_t> epoch_{1};
+
+  /** The epochs the running optimistic transactions began in, protected by active_latch_. */
+  std::multiset<uint64_t> active_epochs_;
+  std::mutex active_latch_;
+
+  /** Epoch advancer state, protected by epoch_latch_. */
+  bool stop_epoch_advancer_{false};
+  std::thread epoch_thread_;
+  std::mutex epoch_latch_;
+  std::condition_variable epoch_cv_;
+};
+
+}  // namespace bustub
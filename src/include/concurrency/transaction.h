@@ -15,18 +15,25 @@
 #include <atomic>
 #include <deque>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>  // NOLINT
-#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/logger.h"
+#include "container/small_set.h"
 #include "storage/page/page.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
+class LockRequestPool;
+class OccManager;
+class VersionStore;
+
 /**
  * Transaction states for 2PL:
  *
@@ -41,13 +48,16 @@ namespace bustub {
  * GROWING  -> COMMITTED     ABORTED
  *    |_________________________^
  *
+ * An OPTIMISTIC transaction is GROWING while it reads and buffers its writes, and SHRINKING while it applies them at
+ * commit.
  **/
 enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 
 /**
- * Transaction isolation level.
+ * Transaction isolation level. A SNAPSHOT_ISOLATION transaction is read-only and reads the tables as of the moment it
+ * began, without taking locks. An OPTIMISTIC transaction is serializable through validation at commit, see OccManager.
  */
-enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED };
+enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED, SNAPSHOT_ISOLATION, OPTIMISTIC };
 
 /**
  * Type of write operation.
@@ -59,6 +69,11 @@ class Catalog;
 using table_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/** The table locks of one mode a transaction holds. */
+using TableLockSet = SmallSet<table_oid_t, TXN_INLINE_TABLE_LOCKS>;
+/** The row locks of one mode a transaction holds, by table. */
+using RowLockSet = SmallMap<table_oid_t, SmallSet<RID, TXN_INLINE_ROW_LOCKS>, TXN_INLINE_TABLE_LOCKS>;
+
 /**
  * WriteRecord tracks information related to a write.
  */
@@ -111,7 +126,8 @@ enum class AbortReason {
   ATTEMPTED_INTENTION_LOCK_ON_ROW,
   TABLE_UNLOCKED_BEFORE_UNLOCKING_ROWS,
   INCOMPATIBLE_UPGRADE,
-  ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD
+  ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD,
+  LOCK_EXCLUSIVE_ON_SNAPSHOT_ISOLATION
 };
 
 /**
@@ -147,6 +163,8 @@ class TransactionAbortException : public std::exception {
         return "Transaction " + std::to_string(txn_id_) + " aborted because attempted lock upgrade is incompatible\n";
       case AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD:
         return "Transaction " + std::to_string(txn_id_) + " aborted because attempted to unlock but no lock held \n";
+      case AbortReason::LOCK_EXCLUSIVE_ON_SNAPSHOT_ISOLATION:
+        return "Transaction " + std::to_string(txn_id_) + " aborted on write lock on SNAPSHOT_ISOLATION\n";
     }
     // Todo: Should fail with unreachable.
     return "";
@@ -155,6 +173,9 @@ class TransactionAbortException : public std::exception {
 
 /**
  * Transaction tracks information related to a transaction.
+ *
+ * The lock sets keep the first few locks inline, so that a short transaction does not allocate for its bookkeeping,
+ * and TransactionManager::Begin reuses the transactions handed back to TransactionManager::Recycle.
  */
 class Transaction {
  public:
@@ -162,27 +183,45 @@ class Transaction {
       : isolation_level_(isolation_level),
         thread_id_(std::this_thread::get_id()),
         txn_id_(txn_id),
-        prev_lsn_(INVALID_LSN),
-        shared_lock_set_{new std::unordered_set<RID>},
-        exclusive_lock_set_{new std::unordered_set<RID>},
-        s_table_lock_set_{new std::unordered_set<table_oid_t>},
-        x_table_lock_set_{new std::unordered_set<table_oid_t>},
-        is_table_lock_set_{new std::unordered_set<table_oid_t>},
-        ix_table_lock_set_{new std::unordered_set<table_oid_t>},
-        six_table_lock_set_{new std::unordered_set<table_oid_t>},
-        s_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>},
-        x_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>} {
-    // Initialize the sets that will be tracked.
-    table_write_set_ = std::make_shared<std::deque<TableWriteRecord>>();
-    index_write_set_ = std::make_shared<std::deque<IndexWriteRecord>>();
-    page_set_ = std::make_shared<std::deque<bustub::Page *>>();
-    deleted_page_set_ = std::make_shared<std::unordered_set<page_id_t>>();
-  }
+        prev_lsn_(INVALID_LSN) {}
 
   ~Transaction() = default;
 
   DISALLOW_COPY(Transaction);
 
+  /**
+   * Reinitialize a finished transaction for reuse. The sets are emptied, but keep the memory they allocated.
+   * @param txn_id the id of the new transaction
+   * @param isolation_level the isolation level of the new transaction
+   */
+  void Reset(txn_id_t txn_id, IsolationLevel isolation_level) {
+    state_ = TransactionState::GROWING;
+    isolation_level_ = isolation_level;
+    thread_id_ = std::this_thread::get_id();
+    txn_id_ = txn_id;
+    prev_lsn_ = INVALID_LSN;
+    table_write_set_.clear();
+    index_write_set_.clear();
+    page_set_.clear();
+    deleted_page_set_.clear();
+    for (auto *lock_set : {&shared_lock_set_, &exclusive_lock_set_}) {
+      lock_set->clear();
+    }
+    for (auto *lock_set : {&s_table_lock_set_, &x_table_lock_set_, &is_table_lock_set_, &ix_table_lock_set_,
+                           &six_table_lock_set_, &escalated_table_set_}) {
+      lock_set->clear();
+    }
+    s_row_lock_set_.clear();
+    x_row_lock_set_.clear();
+    read_ts_ = 0;
+    version_store_ = nullptr;
+    keeps_versions_.reset();
+    occ_manager_ = nullptr;
+    occ_epoch_ = 0;
+    occ_read_set_.clear();
+    occ_write_set_.clear();
+  }
+
   /** @return the id of the thread running the transaction */
   inline auto GetThreadId() const -> std::thread::id { return thread_id_; }
 
@@ -193,20 +232,20 @@ class Transaction {
   inline auto GetIsolationLevel() const -> IsolationLevel { return isolation_level_; }
 
   /** @return the list of table write records of this transaction */
-  inline auto GetWriteSet() -> std::shared_ptr<std::deque<TableWriteRecord>> { return table_write_set_; }
+  inline auto GetWriteSet() -> std::vector<TableWriteRecord> * { return &table_write_set_; }
 
   /** @return the list of index write records of this transaction */
-  inline auto GetIndexWriteSet() -> std::shared_ptr<std::deque<IndexWriteRecord>> { return index_write_set_; }
+  inline auto GetIndexWriteSet() -> std::vector<IndexWriteRecord> * { return &index_write_set_; }
 
   /** @return the page set */
-  inline auto GetPageSet() -> std::shared_ptr<std::deque<Page *>> { return page_set_; }
+  inline auto GetPageSet() -> std::deque<Page *> * { return &page_set_; }
 
   /**
    * Adds a tuple write record into the table write set.
    * @param write_record write record to be added
    */
   inline void AppendTableWriteRecord(const TableWriteRecord &write_record) {
-    table_write_set_->push_back(write_record);
+    table_write_set_.push_back(write_record);
   }
 
   /**
@@ -214,91 +253,87 @@ class Transaction {
    * @param write_record write record to be added
    */
   inline void AppendIndexWriteRecord(const IndexWriteRecord &write_record) {
-    index_write_set_->push_back(write_record);
+    index_write_set_.push_back(write_record);
   }
 
   /**
    * Adds a page into the page set.
    * @param page page to be added
    */
-  inline void AddIntoPageSet(Page *page) { page_set_->push_back(page); }
+  inline void AddIntoPageSet(Page *page) { page_set_.push_back(page); }
 
   /** @return the deleted page set */
-  inline auto GetDeletedPageSet() -> std::shared_ptr<std::unordered_set<page_id_t>> { return deleted_page_set_; }
+  inline auto GetDeletedPageSet() -> std::unordered_set<page_id_t> * { return &deleted_page_set_; }
 
   /**
    * Adds a page to the deleted page set.
    * @param page_id id of the page to be marked as deleted
    */
-  inline void AddIntoDeletedPageSet(page_id_t page_id) { deleted_page_set_->insert(page_id); }
+  inline void AddIntoDeletedPageSet(page_id_t page_id) { deleted_page_set_.insert(page_id); }
 
   /** @return the set of resources under a shared lock */
-  inline auto GetSharedLockSet() -> std::shared_ptr<std::unordered_set<RID>> { return shared_lock_set_; }
+  inline auto GetSharedLockSet() -> SmallSet<RID, TXN_INLINE_ROW_LOCKS> * { return &shared_lock_set_; }
 
   /** @return the set of rows under a shared lock */
-  inline auto GetSharedRowLockSet() -> std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> {
-    return s_row_lock_set_;
-  }
+  inline auto GetSharedRowLockSet() -> RowLockSet * { return &s_row_lock_set_; }
 
   /** @return the set of resources under an exclusive lock */
-  inline auto GetExclusiveLockSet() -> std::shared_ptr<std::unordered_set<RID>> { return exclusive_lock_set_; }
+  inline auto GetExclusiveLockSet() -> SmallSet<RID, TXN_INLINE_ROW_LOCKS> * { return &exclusive_lock_set_; }
 
   /** @return the set of rows in under an exclusive lock */
-  inline auto GetExclusiveRowLockSet() -> std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> {
-    return x_row_lock_set_;
-  }
+  inline auto GetExclusiveRowLockSet() -> RowLockSet * { return &x_row_lock_set_; }
 
   /** @return the set of resources under a shared lock */
-  inline auto GetSharedTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> { return s_table_lock_set_; }
-  inline auto GetExclusiveTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return x_table_lock_set_;
-  }
-  inline auto GetIntentionSharedTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return is_table_lock_set_;
-  }
-  inline auto GetIntentionExclusiveTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return ix_table_lock_set_;
-  }
-  inline auto GetSharedIntentionExclusiveTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return six_table_lock_set_;
+  inline auto GetSharedTableLockSet() -> TableLockSet * { return &s_table_lock_set_; }
+  inline auto GetExclusiveTableLockSet() -> TableLockSet * { return &x_table_lock_set_; }
+  inline auto GetIntentionSharedTableLockSet() -> TableLockSet * { return &is_table_lock_set_; }
+  inline auto GetIntentionExclusiveTableLockSet() -> TableLockSet * { return &ix_table_lock_set_; }
+  inline auto GetSharedIntentionExclusiveTableLockSet() -> TableLockSet * { return &six_table_lock_set_; }
+
+  /** @return the tables on which the row locks of this transaction were escalated to the table lock */
+  inline auto GetEscalatedTableSet() -> TableLockSet * { return &escalated_table_set_; }
+
+  /** @return true if the row locks of this transaction on table oid were escalated to the table lock */
+  auto IsTableEscalated(const table_oid_t &oid) -> bool {
+    return escalated_table_set_.count(oid) != 0;
   }
 
   /** @return true if rid (belong to table oid) is shared locked by this transaction */
   auto IsRowSharedLocked(const table_oid_t &oid, const RID &rid) -> bool {
-    auto row_lock_set = s_row_lock_set_->find(oid);
-    if (row_lock_set == s_row_lock_set_->end()) {
+    auto row_lock_set = s_row_lock_set_.find(oid);
+    if (row_lock_set == s_row_lock_set_.end()) {
       return false;
     }
-    return row_lock_set->second.find(rid) != row_lock_set->second.end();
+    return row_lock_set->second.count(rid) != 0;
   }
 
   /** @return true if rid (belong to table oid) is exclusive locked by this transaction */
   auto IsRowExclusiveLocked(const table_oid_t &oid, const RID &rid) -> bool {
-    auto row_lock_set = x_row_lock_set_->find(oid);
-    if (row_lock_set == x_row_lock_set_->end()) {
+    auto row_lock_set = x_row_lock_set_.find(oid);
+    if (row_lock_set == x_row_lock_set_.end()) {
       return false;
     }
-    return row_lock_set->second.find(rid) != row_lock_set->second.end();
+    return row_lock_set->second.count(rid) != 0;
   }
 
   auto IsTableIntentionSharedLocked(const table_oid_t &oid) -> bool {
-    return is_table_lock_set_->find(oid) != is_table_lock_set_->end();
+    return is_table_lock_set_.count(oid) != 0;
   }
 
   auto IsTableSharedLocked(const table_oid_t &oid) -> bool {
-    return s_table_lock_set_->find(oid) != s_table_lock_set_->end();
+    return s_table_lock_set_.count(oid) != 0;
   }
 
   auto IsTableIntentionExclusiveLocked(const table_oid_t &oid) -> bool {
-    return ix_table_lock_set_->find(oid) != ix_table_lock_set_->end();
+    return ix_table_lock_set_.count(oid) != 0;
   }
 
   auto IsTableExclusiveLocked(const table_oid_t &oid) -> bool {
-    return x_table_lock_set_->find(oid) != x_table_lock_set_->end();
+    return x_table_lock_set_.count(oid) != 0;
   }
 
   auto IsTableSharedIntentionExclusiveLocked(const table_oid_t &oid) -> bool {
-    return six_table_lock_set_->find(oid) != six_table_lock_set_->end();
+    return six_table_lock_set_.count(oid) != 0;
   }
 
   /** @return the current state of the transaction */
@@ -314,6 +349,21 @@ class Transaction {
    */
   inline void SetState(TransactionState state) { state_ = state; }
 
+  /**
+   * Set the state to ABORTED, unless the transaction is committing or aborted already. The lock manager aborts other
+   * transactions with this, they notice at their next lock.
+   * @return true if this call aborted the transaction
+   */
+  inline auto MarkAborted() -> bool {
+    TransactionState state = state_;
+    while (state == TransactionState::GROWING || state == TransactionState::SHRINKING) {
+      if (state_.compare_exchange_weak(state, TransactionState::ABORTED)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   /** @return the previous LSN */
   inline auto GetPrevLSN() -> lsn_t { return prev_lsn_; }
 
@@ -323,9 +373,54 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /**
+   * @return the pool the lock manager allocates the lock requests of this transaction from, nullptr before the first
+   * request
+   */
+  inline auto GetLockRequestPool() -> LockRequestPool * { return lock_request_pool_.get(); }
+
+  /** Set the lock request pool, it lives as long as the transaction. */
+  inline void SetLockRequestPool(std::shared_ptr<LockRequestPool> pool) { lock_request_pool_ = std::move(pool); }
+
+  /** @return the commit timestamp of the last transaction whose writes a snapshot transaction sees */
+  inline auto GetReadTs() const -> timestamp_t { return read_ts_; }
+
+  /** Set the read timestamp, when a snapshot transaction begins. */
+  inline void SetReadTs(timestamp_t read_ts) { read_ts_ = read_ts; }
+
+  /** @return the store the table heaps keep the older versions of the tuples this transaction writes or reads in */
+  inline auto GetVersionStore() -> VersionStore * { return version_store_; }
+
+  /** Set the version store, nullptr if the transaction neither keeps nor reads older versions. */
+  inline void SetVersionStore(VersionStore *version_store) { version_store_ = version_store; }
+
+  /** @return whether the writes of the transaction keep undo records, nullopt before the version store decided it */
+  inline auto KeepsVersions() const -> std::optional<bool> { return keeps_versions_; }
+
+  /** Set whether the writes of the transaction keep undo records, at its first write. */
+  inline void SetKeepsVersions(bool keeps_versions) { keeps_versions_ = keeps_versions; }
+
+  /** @return the manager of the version words optimistic transactions validate against */
+  inline auto GetOccManager() -> OccManager * { return occ_manager_; }
+
+  /** Set the manager of the version words, nullptr if the transaction neither validates nor bumps them. */
+  inline void SetOccManager(OccManager *occ_manager) { occ_manager_ = occ_manager; }
+
+  /** @return the epoch an optimistic transaction began in */
+  inline auto GetOccEpoch() const -> uint64_t { return occ_epoch_; }
+
+  /** Set the epoch an optimistic transaction began in. */
+  inline void SetOccEpoch(uint64_t epoch) { occ_epoch_ = epoch; }
+
+  /** @return the tuples an optimistic transaction read, and their version words when it did */
+  inline auto GetOccReadSet() -> std::vector<std::pair<RID, uint64_t>> * { return &occ_read_set_; }
+
+  /** @return the updates and deletes an optimistic transaction buffers until it commits, with the new tuples */
+  inline auto GetOccWriteSet() -> std::vector<TableWriteRecord> * { return &occ_write_set_; }
+
  private:
-  /** The current transaction state. */
-  TransactionState state_{TransactionState::GROWING};
+  /** The current transaction state, other transactions may abort this one. */
+  std::atomic<TransactionState> state_{TransactionState::GROWING};
   /** The isolation level of the transaction. */
   IsolationLevel isolation_level_;
   /** The thread ID, used in single-threaded transactions. */
@@ -334,34 +429,51 @@ class Transaction {
   txn_id_t txn_id_;
 
   /** The undo set of table tuples. */
-  std::shared_ptr<std::deque<TableWriteRecord>> table_write_set_;
+  std::vector<TableWriteRecord> table_write_set_;
   /** The undo set of indexes. */
-  std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
+  std::vector<IndexWriteRecord> index_write_set_;
   /** The LSN of the last record written by the transaction. */
   lsn_t prev_lsn_;
 
   std::mutex latch_;
 
   /** Concurrent index: the pages that were latched during index operation. */
-  std::shared_ptr<std::deque<Page *>> page_set_;
+  std::deque<Page *> page_set_;
   /** Concurrent index: the page IDs that were deleted during index operation.*/
-  std::shared_ptr<std::unordered_set<page_id_t>> deleted_page_set_;
+  std::unordered_set<page_id_t> deleted_page_set_;
 
   /** LockManager: the set of shared-locked tuples held by this transaction. */
-  std::shared_ptr<std::unordered_set<RID>> shared_lock_set_;
+  SmallSet<RID, TXN_INLINE_ROW_LOCKS> shared_lock_set_;
   /** LockManager: the set of exclusive-locked tuples held by this transaction. */
-  std::shared_ptr<std::unordered_set<RID>> exclusive_lock_set_;
+  SmallSet<RID, TXN_INLINE_ROW_LOCKS> exclusive_lock_set_;
 
   /** LockManager: the set of table locks held by this transaction. */
-  std::shared_ptr<std::unordered_set<table_oid_t>> s_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> x_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> is_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> ix_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> six_table_lock_set_;
+  TableLockSet s_table_lock_set_;
+  TableLockSet x_table_lock_set_;
+  TableLockSet is_table_lock_set_;
+  TableLockSet ix_table_lock_set_;
+  TableLockSet six_table_lock_set_;
 
   /** LockManager: the set of row locks held by this transaction. */
-  std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> s_row_lock_set_;
-  std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> x_row_lock_set_;
+  RowLockSet s_row_lock_set_;
+  RowLockSet x_row_lock_set_;
+  /** LockManager: the tables whose row locks were given up for the table lock. */
+  TableLockSet escalated_table_set_;
+
+  /** LockManager: the lock requests of this transaction are allocated from here. */
+  std::shared_ptr<LockRequestPool> lock_request_pool_;
+
+  /** MVCC: the snapshot a SNAPSHOT_ISOLATION transaction reads. */
+  timestamp_t read_ts_{0};
+  /** MVCC: the undo records of the writes, and the older versions snapshots read. */
+  VersionStore *version_store_{nullptr};
+  std::optional<bool> keeps_versions_;
+
+  /** OCC: the version words, the read set and the buffered writes. */
+  OccManager *occ_manager_{nullptr};
+  uint64_t occ_epoch_{0};
+  std::vector<std::pair<RID, uint64_t>> occ_read_set_;
+  std::vector<TableWriteRecord> occ_write_set_;
 };
 
 }  // namespace bustub
@@ -13,13 +13,22 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>               // NOLINT
+#include <set>
 #include <shared_mutex>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
+#include "concurrency/occ_manager.h"
 #include "concurrency/transaction.h"
+#include "concurrency/version_store.h"
 #include "recovery/log_manager.h"
 
 namespace bustub {
@@ -27,17 +36,25 @@ class LockManager;
 
 /**
  * TransactionManager keeps track of all the transactions running in the system.
+ *
+ * It also hands out the commit timestamps of the version store. A commit stamps the versions its writes left behind
+ * with the next timestamp, and a SNAPSHOT_ISOLATION transaction reads as of the last timestamp handed out when it
+ * began. A writer that ran while no snapshot did left no versions, and takes no timestamp. The versions older than
+ * every snapshot are dropped at commit if no snapshot was running, otherwise by the garbage collector once the
+ * snapshots are gone.
  */
 class TransactionManager {
  public:
   explicit TransactionManager(LockManager *lock_manager, LogManager *log_manager = nullptr)
       : lock_manager_(lock_manager), log_manager_(log_manager) {}
 
-  ~TransactionManager() = default;
+  /** Stops the garbage collector. */
+  ~TransactionManager() { StopGarbageCollector(); }
 
   /**
    * Begins a new transaction.
-   * @param txn an optional transaction object to be initialized, otherwise a new transaction is created.
+   * @param txn an optional transaction object to be initialized, otherwise one recycled on this thread is reused, or a
+   * new transaction is created.
    * @param isolation_level an optional isolation level of the transaction.
    * @return an initialized transaction
    */
@@ -45,10 +62,11 @@ class TransactionManager {
       -> Transaction *;
 
   /**
-   * Commits a transaction.
+   * Commits a transaction. An OPTIMISTIC transaction is validated first, and aborted if that fails.
    * @param txn the transaction to commit
+   * @return false if the transaction was aborted instead
    */
-  void Commit(Transaction *txn);
+  auto Commit(Transaction *txn) -> bool;
 
   /**
    * Aborts a transaction
@@ -56,11 +74,21 @@ class TransactionManager {
    */
   void Abort(Transaction *txn);
 
+  /**
+   * Hand back a committed or aborted transaction instead of deleting it. Begin reuses it on this thread, with the
+   * memory its sets allocated, and deletes it if the thread keeps TXN_POOL_SIZE transactions already.
+   * @param txn the finished transaction, created by Begin
+   */
+  static void Recycle(Transaction *txn);
+
   /**
    * Global list of running transactions
    */
 
-  /** The transaction map is a global list of all the running transactions in the system. */
+  /**
+   * The transaction map is a global list of all the running transactions in the system. Committing or aborting a
+   * transaction takes it out.
+   */
   static std::unordered_map<txn_id_t, Transaction *> txn_map;
   static std::shared_mutex txn_map_mutex;
 
@@ -77,6 +105,37 @@ class TransactionManager {
     return res;
   }
 
+  /**
+   * Take a snapshot of the active transaction table for a fuzzy checkpoint. The last lsn of a transaction that is
+   * running concurrently may be slightly stale.
+   * @return the id and the last lsn of every transaction that has begun and not yet committed or aborted
+   */
+  auto GetActiveTransactionTable() -> std::vector<std::pair<txn_id_t, lsn_t>>;
+
+  /** @return the lsn of the oldest BEGIN record of an active transaction, INVALID_LSN if there is none */
+  auto GetOldestBeginLSN() -> lsn_t;
+
+  /** @return the read timestamp of the oldest snapshot that is running or may still begin */
+  auto GetWatermark() -> timestamp_t;
+
+  /**
+   * Drop the versions no snapshot can see anymore.
+   * @return the number of versions dropped
+   */
+  auto CollectGarbage() -> size_t { return version_store_.CollectGarbage(GetWatermark()); }
+
+  /** @brief Start a thread that collects garbage every version_gc_interval. */
+  void RunGarbageCollector();
+
+  /** @brief Stop and join the garbage collector thread. */
+  void StopGarbageCollector();
+
+  /** @return the store of the older versions of the tuples */
+  auto GetVersionStore() -> VersionStore * { return &version_store_; }
+
+  /** @return the manager of the version words of the optimistic transactions */
+  auto GetOccManager() -> OccManager * { return &occ_manager_; }
+
   /** Prevents all transactions from performing operations, used for checkpointing. */
   void BlockAllTransactions();
 
@@ -91,34 +150,34 @@ class TransactionManager {
   void ReleaseLocks(Transaction *txn) {
     /** Drop all row locks */
     txn->LockTxn();
-    std::unordered_map<table_oid_t, std::unordered_set<RID>> row_lock_set;
+    RowLockSet row_lock_set;
     for (const auto &s_row_lock_set : *txn->GetSharedRowLockSet()) {
       for (auto rid : s_row_lock_set.second) {
-        row_lock_set[s_row_lock_set.first].emplace(rid);
+        row_lock_set[s_row_lock_set.first].insert(rid);
       }
     }
     for (const auto &x_row_lock_set : *txn->GetExclusiveRowLockSet()) {
       for (auto rid : x_row_lock_set.second) {
-        row_lock_set[x_row_lock_set.first].emplace(rid);
+        row_lock_set[x_row_lock_set.first].insert(rid);
       }
     }
 
     /** Drop all table locks */
-    std::unordered_set<table_oid_t> table_lock_set;
+    TableLockSet table_lock_set;
     for (auto oid : *txn->GetSharedTableLockSet()) {
-      table_lock_set.emplace(oid);
+      table_lock_set.insert(oid);
     }
     for (table_oid_t oid : *(txn->GetIntentionSharedTableLockSet())) {
-      table_lock_set.emplace(oid);
+      table_lock_set.insert(oid);
     }
     for (auto oid : *txn->GetExclusiveTableLockSet()) {
-      table_lock_set.emplace(oid);
+      table_lock_set.insert(oid);
     }
     for (auto oid : *txn->GetIntentionExclusiveTableLockSet()) {
-      table_lock_set.emplace(oid);
+      table_lock_set.insert(oid);
     }
     for (auto oid : *txn->GetSharedIntentionExclusiveTableLockSet()) {
-      table_lock_set.emplace(oid);
+      table_lock_set.insert(oid);
     }
     txn->UnlockTxn();
 
@@ -140,6 +199,40 @@ class TransactionManager {
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
+
+  /** Main loop of the garbage collector thread. */
+  void GarbageCollector();
+
+  /** Take a committed or aborted transaction out of the running ones. */
+  void Unregister(Transaction *txn);
+
+  /**
+   * Validate an optimistic transaction and apply its buffered writes.
+   * @return false if validation or a write failed, the transaction is to be aborted then
+   */
+  auto ValidateAndWrite(Transaction *txn) -> bool;
+
+  /** The running transactions and the lsn of their BEGIN record, unlike txn_map only the ones still running. */
+  std::unordered_map<txn_id_t, std::pair<Transaction *, lsn_t>> active_txns_;
+  /** The read timestamps of the running snapshot transactions, protected by active_txns_latch_. */
+  std::multiset<timestamp_t> snapshots_;
+  std::mutex active_txns_latch_;
+
+  VersionStore version_store_;
+  /** The commit timestamp handed out last. A commit stamps its versions and publishes it under commit_latch_. */
+  std::atomic<timestamp_t> last_commit_ts_{0};
+  std::mutex commit_latch_;
+
+  OccManager occ_manager_;
+
+  /** The transactions this thread handed back for reuse. */
+  static thread_local std::vector<std::unique_ptr<Transaction>> txn_pool;
+
+  /** Garbage collector state, protected by gc_latch_. */
+  bool stop_gc_{false};
+  std::thread gc_thread_;
+  std::mutex gc_latch_;
+  std::condition_variable gc_cv_;
 };
 
 }  // namespace bustub
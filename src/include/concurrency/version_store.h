@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.h
+//
+// Identification: src/include/concurrency/version_store.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <limits>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+class Transaction;
+
+/**
+ * VersionStore keeps the older versions of the tuples in the table heaps, so that a snapshot transaction can read a
+ * table as of the moment it began while writers keep changing it in place.
+ *
+ * The table heap holds the newest version of every tuple. Before a write changes a tuple, the table heap records what
+ * the tuple looked like in an undo record, and chains the undo records of each RID from oldest to newest. When the
+ * writer commits, the transaction manager stamps its undo records with the commit timestamp. A reader with read
+ * timestamp T starts from the tuple in the table heap and applies, newest first, every undo record of a write that
+ * has not committed or committed after T.
+ *
+ * Once no snapshot is older than a commit, the undo records it stamped and the older ones are of no use to anybody,
+ * and CollectGarbage drops them.
+ *
+ * Undo records are only of use to snapshots, so a writer that starts writing while no snapshot runs keeps none. A
+ * snapshot that begins waits for those writers to end first, and the writers that start in the meantime keep them.
+ *
+ * The chains are kept in VERSION_STORE_BUCKETS partitions, each with its own latch.
+ */
+class VersionStore {
+ public:
+  /** The commit timestamp of an undo record whose writer has not committed yet, newer than every snapshot. */
+  static constexpr timestamp_t UNCOMMITTED_TS = std::numeric_limits<timestamp_t>::max();
+
+  VersionStore() = default;
+
+  ~VersionStore() = default;
+
+  /**
+   * Decide, at the first write of writer, whether its writes keep undo records. They do if a snapshot is running,
+   * otherwise writer counts as a writer without versions until EndWriter.
+   * @return true if the writes of writer keep undo records
+   */
+  auto KeepsVersions(Transaction *writer) -> bool;
+
+  /** Called when writer ends, after its writes were committed or rolled back. */
+  void EndWriter(Transaction *writer);
+
+  /** Called when a snapshot begins, before it takes its read timestamp. Waits for the writers without versions. */
+  void BeginSnapshot();
+
+  /** Called when a snapshot ends. */
+  void EndSnapshot() { num_snapshots_--; }
+
+  /**
+   * Record the version of a tuple before writer changes it.
+   * @param rid the tuple
+   * @param writer the transaction making the change
+   * @param exists false if the slot held no tuple before, i.e. writer inserts it
+   * @param before the tuple before the change, if it exists
+   */
+  void AddUndo(const RID &rid, txn_id_t writer, bool exists, const Tuple &before);
+
+  /** Stamp the undo records writer added to the chain of rid with its commit timestamp. */
+  void Commit(const RID &rid, txn_id_t writer, timestamp_t commit_ts);
+
+  /** Drop the newest undo record writer added to the chain of rid, after the table heap rolled back the change. */
+  void Rollback(const RID &rid, txn_id_t writer);
+
+  /**
+   * Turn the newest version of a tuple into the one a snapshot sees.
+   * @param rid the tuple
+   * @param read_ts the read timestamp of the snapshot
+   * @param[in,out] exists whether the tuple exists in the table heap, and then whether the snapshot sees one
+   * @param[in,out] tuple the tuple in the table heap, and then the one the snapshot sees
+   */
+  void Resolve(const RID &rid, timestamp_t read_ts, bool *exists, Tuple *tuple);
+
+  /**
+   * Drop the undo records no snapshot needs anymore.
+   * @param watermark the read timestamp of the oldest snapshot that is running or may still begin
+   * @return the number of undo records dropped
+   */
+  auto CollectGarbage(timestamp_t watermark) -> size_t;
+
+  /** Drop the undo records of rid no snapshot needs anymore, see CollectGarbage. */
+  auto CollectGarbage(const RID &rid, timestamp_t watermark) -> size_t;
+
+  /** @return the number of undo records in the store */
+  auto GetNumVersions() -> size_t;
+
+ private:
+  /** The version of a tuple before a write, and the commit timestamp of the write. */
+  struct UndoRecord {
+    txn_id_t writer_;
+    timestamp_t commit_ts_;
+    bool exists_;
+    Tuple before_;
+  };
+
+  /** The undo records of a RID, oldest first. */
+  using VersionChain = std::vector<UndoRecord>;
+
+  struct alignas(BUSTUB_CACHE_LINE_SIZE) VersionBucket {
+    std::unordered_map<RID, VersionChain> chains_;
+    std::mutex latch_;
+  };
+
+  /** @return the bucket that holds the chain of rid */
+  auto BucketOf(const RID &rid) -> VersionBucket & {
+    return buckets_[std::hash<RID>()(rid) % VERSION_STORE_BUCKETS];
+  }
+
+  /** Drop the undo records of chain no snapshot needs anymore, the bucket latch is held. */
+  static auto Prune(VersionChain *chain, timestamp_t watermark) -> size_t;
+
+  /** Count a writer without versions out, and wake up the snapshots waiting for the last one. */
+  void ReleaseUnversionedWriter();
+
+  std::unique_ptr<VersionBucket[]> buckets_{new VersionBucket[VERSION_STORE_BUCKETS]};
+
+  /**
+   * The snapshots that are running or waiting to begin, and the writers that keep no undo records. Each side counts
+   * itself in before it looks at the other, so a writer and a snapshot that start together cannot both miss the other.
+   */
+  std::atomic<int> num_snapshots_{0};
+  std::atomic<int> num_unversioned_writers_{0};
+  /** Snapshots wait on writers_cv_ for the writers without versions to end. */
+  std::mutex writers_latch_;
+  std::condition_variable writers_cv_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// small_set.h
+//
+// Identification: src/include/container/small_set.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * SmallTable is the storage of SmallSet and SmallMap, which hold the few keys a transaction usually tracks without
+ * allocating.
+ *
+ * The first N entries live inline in the object and are found by a linear search. Once there are more, the entries
+ * move to a vector on the heap with a hash index from key to position, and stay there until the table is cleared,
+ * which keeps the heap memory for the next use. Either way the entries are contiguous and the iterators are plain
+ * pointers. Erasing moves the last entry into the gap, which invalidates the iterators.
+ *
+ * @tparam Key key type
+ * @tparam Entry entry type, the key itself or a key and value pair
+ * @tparam KeyOf function object returning the key of an entry
+ * @tparam N number of entries kept inline
+ * @tparam Hash hash function of the index, once the entries spill to the heap
+ */
+template <typename Key, typename Entry, typename KeyOf, size_t N, typename Hash>
+class SmallTable {
+ public:
+  using iterator = Entry *;
+  using const_iterator = const Entry *;
+
+  // the standard container names, for range-based for loops and code written against the standard sets and maps
+  auto begin() -> iterator { return Data(); }                    // NOLINT
+  auto end() -> iterator { return Data() + size_; }              // NOLINT
+  auto begin() const -> const_iterator { return Data(); }        // NOLINT
+  auto end() const -> const_iterator { return Data() + size_; }  // NOLINT
+  auto size() const -> size_t { return size_; }                  // NOLINT
+  auto empty() const -> bool { return size_ == 0; }              // NOLINT
+
+  auto find(const Key &key) -> iterator { return Data() + IndexOf(key); }               // NOLINT
+  auto find(const Key &key) const -> const_iterator { return Data() + IndexOf(key); }   // NOLINT
+  auto count(const Key &key) const -> size_t { return IndexOf(key) == size_ ? 0 : 1; }  // NOLINT
+
+  /** @return true if the entries moved to the heap */
+  auto IsSpilled() const -> bool { return spilled_; }
+
+  /**
+   * Erase the entry of key, moving the last entry into its place.
+   * @return the number of entries erased
+   */
+  auto erase(const Key &key) -> size_t {  // NOLINT
+    const size_t index = IndexOf(key);
+    if (index == size_) {
+      return 0;
+    }
+    Entry *data = Data();
+    if (spilled_) {
+      index_.erase(key);
+    }
+    if (index != size_ - 1) {
+      data[index] = std::move(data[size_ - 1]);
+      if (spilled_) {
+        index_[KeyOf()(data[index])] = index;
+      }
+    }
+    size_--;
+    if (spilled_) {
+      heap_.pop_back();
+    } else {
+      inline_[size_] = Entry{};
+    }
+    return 1;
+  }
+
+  /** Erase all the entries, the heap memory is kept. */
+  void clear() {  // NOLINT
+    if (spilled_) {
+      heap_.clear();
+      index_.clear();
+      spilled_ = false;
+    } else {
+      for (size_t i = 0; i < size_; i++) {
+        inline_[i] = Entry{};
+      }
+    }
+    size_ = 0;
+  }
+
+ protected:
+  /** Append the entry of a key that is not in the table yet. */
+  auto Append(Entry &&entry) -> iterator {
+    if (!spilled_ && size_ == N) {
+      for (size_t i = 0; i < N; i++) {
+        index_.emplace(KeyOf()(inline_[i]), i);
+        heap_.push_back(std::move(inline_[i]));
+        inline_[i] = Entry{};
+      }
+      spilled_ = true;
+    }
+    if (spilled_) {
+      index_.emplace(KeyOf()(entry), size_);
+      heap_.push_back(std::move(entry));
+    } else {
+      inline_[size_] = std::move(entry);
+    }
+    return Data() + size_++;
+  }
+
+ private:
+  auto Data() -> Entry * { return spilled_ ? heap_.data() : inline_.data(); }
+  auto Data() const -> const Entry * { return spilled_ ? heap_.data() : inline_.data(); }
+
+  /** @return the position of the entry of key, size_ if there is none */
+  auto IndexOf(const Key &key) const -> size_t {
+    if (spilled_) {
+      auto it = index_.find(key);
+      return it == index_.end() ? size_ : it->second;
+    }
+    for (size_t i = 0; i < size_; i++) {
+      if (KeyOf()(inline_[i]) == key) {
+        return i;
+      }
+    }
+    return size_;
+  }
+
+  std::array<Entry, N> inline_{};
+  std::vector<Entry> heap_;
+  std::unordered_map<Key, size_t, Hash> index_;
+  size_t size_{0};
+  bool spilled_{false};
+};
+
+template <typename Key>
+struct SmallSetKeyOf {
+  auto operator()(const Key &key) const -> const Key & { return key; }
+};
+
+template <typename Key, typename Value>
+struct SmallMapKeyOf {
+  auto operator()(const std::pair<Key, Value> &entry) const -> const Key & { return entry.first; }
+};
+
+/**
+ * A set that keeps its first N keys inline, see SmallTable.
+ */
+template <typename Key, size_t N, typename Hash = std::hash<Key>>
+class SmallSet : public SmallTable<Key, Key, SmallSetKeyOf<Key>, N, Hash> {
+ public:
+  /**
+   * Insert a key, unless it is in the set already.
+   * @return the key in the set, and true if it was inserted
+   */
+  auto insert(const Key &key) -> std::pair<Key *, bool> {  // NOLINT
+    auto it = this->find(key);
+    if (it != this->end()) {
+      return {it, false};
+    }
+    return {this->Append(Key(key)), true};
+  }
+};
+
+/**
+ * A map that keeps its first N entries inline, see SmallTable.
+ */
+template <typename Key, typename Value, size_t N, typename Hash = std::hash<Key>>
+class SmallMap : public SmallTable<Key, std::pair<Key, Value>, SmallMapKeyOf<Key, Value>, N, Hash> {
+ public:
+  /** @return the value of key, default constructed if key was not in the map */
+  auto operator[](const Key &key) -> Value & {
+    auto it = this->find(key);
+    if (it != this->end()) {
+      return it->second;
+    }
+    return this->Append({key, Value{}})->second;
+  }
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <thread>  // NOLINT
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
@@ -19,7 +21,13 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager takes fuzzy checkpoints, which never block the running transactions.
+ *
+ * A checkpoint logs a BEGINCHECKPOINT record and snapshots the active transaction table and the dirty page table,
+ * which go into the ENDCHECKPOINT record. Once that is on disk, the master record is pointed at the oldest log record
+ * recovery still needs: the smallest recLSN of the dirty pages, the BEGIN of the oldest active transaction, or the
+ * checkpoint itself. The dirty pages are then written out one at a time in the background, so the next checkpoint
+ * can move the master record further.
  */
 class CheckpointManager {
  public:
@@ -29,15 +37,21 @@ class CheckpointManager {
         log_manager_(log_manager),
         buffer_pool_manager_(buffer_pool_manager) {}
 
-  ~CheckpointManager() = default;
+  ~CheckpointManager() { EndCheckpoint(); }
 
+  /** Take a checkpoint and start flushing the pages that were dirty at the checkpoint in the background. */
   void BeginCheckpoint();
+
+  /** Wait until the pages that were dirty at the last checkpoint are flushed. */
   void EndCheckpoint();
 
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+
+  /** Flushes the dirty pages of the last checkpoint. */
+  std::thread flush_thread_;
 };
 
 }  // namespace bustub
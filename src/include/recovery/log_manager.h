@@ -13,9 +13,14 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
-#include <future>              // NOLINT
+#include <deque>
+#include <future>  // NOLINT
 #include <mutex>               // NOLINT
+#include <shared_mutex>
+#include <thread>  // NOLINT
+#include <utility>
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,16 +30,23 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * The log is double-buffered. Appenders reserve space in the active log buffer with a fetch-add on its offset and
+ * copy their records in concurrently, while the previous buffer is being written out. A flush swaps the two buffers
+ * and writes everything appended so far with one WriteLog, so a committing transaction that waits in Flush shares
+ * that write with every other transaction that committed in the meantime (group commit).
  */
 class LogManager {
  public:
   explicit LogManager(DiskManager *disk_manager)
       : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+    flushed_bytes_ = disk_manager_->GetLogFileSize();
     log_buffer_ = new char[LOG_BUFFER_SIZE];
     flush_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogManager() {
+    StopFlushThread();
     delete[] log_buffer_;
     delete[] flush_buffer_;
     log_buffer_ = nullptr;
@@ -46,13 +58,40 @@ class LogManager {
 
   auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
 
+  /**
+   * Wait until the log records up to and including lsn are on disk. With the flush thread running, the flush
+   * thread is woken up and does the write; otherwise the caller writes the log buffer itself.
+   * @param lsn the last log record that must be persistent
+   */
+  void Flush(lsn_t lsn);
+
+  /**
+   * Point the master record at the log, so that recovery reads it from the write that holds lsn on. The log must be
+   * persistent up to lsn. Offsets of the writes before it are forgotten.
+   * @param lsn the oldest log record recovery needs
+   */
+  void SetRecoveryStart(lsn_t lsn);
+
+  /**
+   * Continue the LSNs of an existing log, before anything is appended. Recovery calls it with the LSN after the last
+   * record it read.
+   */
+  void SetNextLSN(lsn_t lsn);
+
   inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
   inline auto GetLogBuffer() -> char * { return log_buffer_; }
 
  private:
-  // TODO(students): you may add your own member variables
+  /**
+   * Swap the log buffer with the flush buffer and write out what was appended, unless the log buffer still has
+   * room for room more bytes. The default room only skips empty flushes.
+   */
+  void FlushLogBuffer(size_t room = LOG_BUFFER_SIZE);
+
+  /** Serialize a log record, whose lsn is set, in the layout described in log_record.h. */
+  static void SerializeLogRecord(const LogRecord &log_record, char *data);
 
   /** The atomic counter which records the next log sequence number. */
   std::atomic<lsn_t> next_lsn_;
@@ -61,14 +100,35 @@ class LogManager {
 
   char *log_buffer_;
   char *flush_buffer_;
-
+  /** Bytes reserved in log_buffer_, including failed reservations past its end. */
+  std::atomic<size_t> log_offset_{0};
+  /** Bytes of log_buffer_ handed out, the failed reservations are not counted. */
+  std::atomic<size_t> log_size_{0};
+  /** Appenders hold it shared while they fill their reservation, a flush holds it exclusively to swap the buffers. */
+  std::shared_mutex buffer_latch_;
+  /** Serializes the flushes, which write flush_buffer_. */
+  std::mutex flush_latch_;
+
+  /** Size of the log file, protected by flush_latch_. */
+  int64_t flushed_bytes_;
+  /** The lsn of the first record in log_buffer_, protected by flush_latch_. */
+  lsn_t buffer_first_lsn_{0};
+  /** The first lsn and the log file offset of every write since the last SetRecoveryStart, under flush_latch_. */
+  std::deque<std::pair<lsn_t, int64_t>> write_offsets_;
+
+  /** Protects flush_requested_ and stop_, and goes with cv_ and flushed_cv_. */
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
 
+  /** Wakes up the flush thread. */
   std::condition_variable cv_;
+  /** Wakes up the transactions waiting in Flush. */
+  std::condition_variable flushed_cv_;
+  bool flush_requested_{false};
+  bool stop_{false};
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
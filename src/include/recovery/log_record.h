@@ -14,6 +14,8 @@
 
 #include <cassert>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,6 +34,12 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** Start of a fuzzy checkpoint. */
+  BEGINCHECKPOINT,
+  /** End of a fuzzy checkpoint, with the active transaction table and the dirty page table. */
+  ENDCHECKPOINT,
+  /** Compensation log record, the change recovery made to undo a record of an unfinished transaction. */
+  CLR,
 };
 
 /**
@@ -57,6 +65,16 @@ enum class LogRecordType {
  *--------------------------
  * | HEADER | prev_page_id |
  *--------------------------
+ * For end checkpoint type log record, whose prevLSN is the lsn of its begin checkpoint record. A large checkpoint
+ * is spread over several of them.
+ *---------------------------------------------------------------------------------------------
+ * | HEADER | num_txns | (txn_id, last_lsn) ... | num_pages | (page_id, rec_lsn) ... |
+ *---------------------------------------------------------------------------------------------
+ * For compensation log record, whose body is that of the insert, delete or update record that undid a change. Undo
+ * continues at undo_next_lsn, the record before the undone one.
+ *--------------------------------------------------------------
+ * | HEADER | undo_next_lsn | LogType of the body | body ... |
+ *--------------------------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -110,6 +128,29 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for ENDCHECKPOINT type
+  LogRecord(lsn_t begin_checkpoint_lsn, std::vector<std::pair<txn_id_t, lsn_t>> active_txns,
+            std::vector<std::pair<page_id_t, lsn_t>> dirty_pages)
+      : prev_lsn_(begin_checkpoint_lsn),
+        log_record_type_(LogRecordType::ENDCHECKPOINT),
+        active_txns_(std::move(active_txns)),
+        dirty_pages_(std::move(dirty_pages)) {
+    size_ = HEADER_SIZE + 2 * sizeof(int32_t) + active_txns_.size() * (sizeof(txn_id_t) + sizeof(lsn_t)) +
+            dirty_pages_.size() * (sizeof(page_id_t) + sizeof(lsn_t));
+  }
+
+  // constructor for CLR type, around a record of the change that undid another one
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, const LogRecord &compensation, lsn_t undo_next_lsn)
+      : LogRecord(compensation) {
+    assert(compensation.log_record_type_ != LogRecordType::CLR);
+    txn_id_ = txn_id;
+    prev_lsn_ = prev_lsn;
+    log_record_type_ = LogRecordType::CLR;
+    clr_type_ = compensation.log_record_type_;
+    undo_next_lsn_ = undo_next_lsn;
+    size_ = compensation.size_ + sizeof(lsn_t) + sizeof(LogRecordType);
+  }
+
   ~LogRecord() = default;
 
   inline auto GetDeleteTuple() -> Tuple & { return delete_tuple_; }
@@ -128,6 +169,10 @@ class LogRecord {
 
   inline auto GetNewPageRecord() -> page_id_t { return prev_page_id_; }
 
+  inline auto GetActiveTxns() -> std::vector<std::pair<txn_id_t, lsn_t>> & { return active_txns_; }
+
+  inline auto GetDirtyPages() -> std::vector<std::pair<page_id_t, lsn_t>> & { return dirty_pages_; }
+
   inline auto GetSize() -> int32_t { return size_; }
 
   inline auto GetLSN() -> lsn_t { return lsn_; }
@@ -138,6 +183,13 @@ class LogRecord {
 
   inline auto GetLogRecordType() -> LogRecordType & { return log_record_type_; }
 
+  /** @return the type of the change a record makes to its page, that of the body for a CLR */
+  inline auto GetPageRecordType() const -> LogRecordType {
+    return log_record_type_ == LogRecordType::CLR ? clr_type_ : log_record_type_;
+  }
+
+  inline auto GetUndoNextLSN() -> lsn_t { return undo_next_lsn_; }
+
   // For debug purpose
   inline auto ToString() const -> std::string {
     std::ostringstream os;
@@ -176,6 +228,14 @@ class LogRecord {
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // case5: for end checkpoint, the transactions running and the pages dirty at the checkpoint
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
+
+  // case6: for compensation log record, the type of its body and the next record to undo
+  LogRecordType clr_type_{LogRecordType::INVALID};
+  lsn_t undo_next_lsn_{INVALID_LSN};
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
@@ -13,22 +13,45 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * Recovery reads the log from the offset in the master record of the last checkpoint, the start of the log if there
+ * is none, in LOG_BUFFER_SIZE chunks. Redo first runs the analysis over it: the active transactions, where each record
+ * is in the log, and the dirty page table of the last checkpoint. Records before the checkpoint are only redone on
+ * the pages of that dirty page table, from their recLSN on. In the second pass, the records that change pages are
+ * partitioned by page id over num_redo_threads workers. Every page belongs to one worker, which applies the records
+ * of the page in log order, so the workers never wait for each other. Undo then rolls back the transactions that
+ * neither committed nor aborted, newest record first.
+ *
+ * With a log manager, undo logs each change it makes in a CLR and stamps the page with its LSN, and ends every rolled
+ * back transaction with an ABORT record. A crash during or after recovery then redoes the CLRs, and the undo of the
+ * next recovery picks up at the undo-next LSN of the last one instead of undoing the same records again. Without a
+ * log manager nothing is logged, which only suits a log that is not used again.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager = nullptr,
+              size_t num_redo_threads = RECOVERY_REDO_THREADS)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        num_redo_threads_(num_redo_threads),
+        offset_(0) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
@@ -39,18 +62,68 @@ class LogRecovery {
 
   void Redo();
   void Undo();
-  auto DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool;
+
+  /**
+   * Deserialize a log record.
+   * @param data the serialized record
+   * @param size number of bytes available at data
+   * @param[out] log_record the record
+   * @return false if data does not hold a complete record
+   */
+  auto DeserializeLogRecord(const char *data, size_t size, LogRecord *log_record) -> bool;
+
+  /** @return the largest lsn in the log, INVALID_LSN if the log is empty */
+  auto GetMaxLSN() const -> lsn_t { return max_lsn_; }
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** The records one redo worker still has to apply, in batches of one log chunk. */
+  struct RedoQueue {
+    std::deque<std::vector<LogRecord>> batches_;
+    bool done_{false};
+    std::mutex latch_;
+    std::condition_variable cv_;
+  };
+
+  /** Most batches queued for a worker before the reader waits for it. */
+  static constexpr size_t MAX_QUEUED_BATCHES = 4;
+
+  /** The analysis pass, from start_offset to the end of the log. */
+  void Analyze(int64_t start_offset);
+
+  /** @return false if the last checkpoint shows that the change of a record on page_id is on disk */
+  auto NeedsRedo(const LogRecord &log_record, page_id_t page_id) const -> bool;
+
+  /** Main loop of a redo worker. */
+  void RedoLoop(RedoQueue *queue, size_t worker);
+
+  /** Redo a record on its page, unless the page already has it. */
+  void RedoLogRecord(LogRecord *log_record);
+
+  /** Point the previous page of a NEWPAGE record at the new page. */
+  void RedoNewPageLink(const LogRecord &log_record);
+
+  /** Undo a record of a transaction that did not finish, and log the change in a CLR. */
+  void UndoLogRecord(LogRecord *log_record);
+
+  /** @return the page a record changes, INVALID_PAGE_ID for BEGIN/COMMIT/ABORT */
+  static auto PageOf(const LogRecord &log_record) -> page_id_t;
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  const size_t num_redo_threads_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
   /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  std::unordered_map<lsn_t, int64_t> lsn_mapping_;
+  lsn_t max_lsn_{INVALID_LSN};
+  /** The BEGINCHECKPOINT lsn of the last complete checkpoint, and the dirty pages with their recLSN at that time. */
+  lsn_t checkpoint_lsn_{INVALID_LSN};
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_;
 
-  int offset_ __attribute__((__unused__));  // NOLINT
+  /** Offset in the log file of the next chunk to read. */
+  int64_t offset_;
   char *log_buffer_;
 };
 
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
@@ -58,6 +59,54 @@ class DiskManager {
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Read consecutive pages from the database file with a single read. Pages past the end of the file read as zeros.
+   * @param first_page_id id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] data output buffer of num_pages * BUSTUB_PAGE_SIZE bytes
+   */
+  virtual void ReadPages(page_id_t first_page_id, size_t num_pages, char *data);
+
+  /**
+   * Start reading a page. The default implementation reads synchronously and returns a ready future.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the future is ready
+   * @return a future that becomes ready once page_data holds the page
+   */
+  virtual auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void>;
+
+  /**
+   * Start writing a page. The default implementation writes synchronously and returns a ready future.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay valid and unchanged until the future is ready
+   * @return a future that becomes ready once the page is written
+   */
+  virtual auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void>;
+
+  /**
+   * Allocate a page on disk, reusing a freed one if possible. The default implementation keeps no record of the pages
+   * in use and leaves the allocation to the caller.
+   * @param near_page_id a page the new page should be close to, or INVALID_PAGE_ID
+   * @param stride the allocated page id is congruent to remainder modulo stride
+   * @param remainder see stride
+   * @return the allocated page id, or INVALID_PAGE_ID if the caller should pick one itself
+   */
+  virtual auto AllocatePage(page_id_t near_page_id, uint32_t stride, uint32_t remainder) -> page_id_t {
+    return INVALID_PAGE_ID;
+  }
+
+  /**
+   * Free a page on disk, so that AllocatePage can hand it out again.
+   * @param page_id id of the page
+   */
+  virtual void DeallocatePage(page_id_t page_id) {}
+
+  /** @return false if the page is known to be free, true if it is in use or the disk manager keeps no record */
+  virtual auto IsAllocated(page_id_t page_id) -> bool { return true; }
+
+  /** Write out the record of the pages in use, if the disk manager keeps one and defers writing it. */
+  virtual void FlushAllocations() {}
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -72,7 +121,20 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, int64_t offset) -> bool;
+
+  /** @return the size of the log file in bytes */
+  auto GetLogFileSize() -> int64_t { return std::max<int64_t>(GetFileSize(log_name_), 0); }
+
+  /**
+   * Record the log file offset recovery starts reading at, in the master record next to the log file. The master
+   * record is replaced atomically, so a crash leaves either the old or the new offset.
+   * @param offset offset of the first log record recovery needs
+   */
+  void WriteCheckpointOffset(int64_t offset);
+
+  /** @return the offset recorded by WriteCheckpointOffset, 0 if there is no master record */
+  auto ReadCheckpointOffset() -> int64_t;
 
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
@@ -93,7 +155,7 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
+  auto GetFileSize(const std::string &file_name) -> int64_t;
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
@@ -52,6 +52,8 @@ class DiskManagerMemory : public DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data) override;
 
+  void ReadPages(page_id_t first_page_id, size_t num_pages, char *data) override;
+
  private:
   char *memory_;
 };
@@ -106,6 +108,12 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
   }
 
+  void ReadPages(page_id_t first_page_id, size_t num_pages, char *data) override {
+    for (size_t i = 0; i < num_pages; i++) {
+      ReadPage(first_page_id + static_cast<page_id_t>(i), data + i * BUSTUB_PAGE_SIZE);
+    }
+  }
+
  private:
   std::mutex mutex_;
   using Page = std::array<char, BUSTUB_PAGE_SIZE>;
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.h
+//
+// Identification: src/include/storage/disk/disk_manager_uring.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/free_space_map.h"
+#include "storage/disk/tablespace.h"
+
+struct io_uring;
+
+namespace bustub {
+
+/**
+ * DiskManagerUring does the page I/O of DiskManager asynchronously, with many requests in flight at once. The pages
+ * live in a Tablespace of segment files. The log still goes through DiskManager.
+ *
+ * Requests are queued, and one I/O thread submits everything queued since its last round to an io_uring with a single
+ * io_uring_submit, up to URING_QUEUE_DEPTH requests in flight, then reaps the completions. If BusTub was built
+ * without liburing, or the kernel refuses to set up a ring, DISK_IO_THREADS threads serve the queue with pread and
+ * pwrite instead. The synchronous calls of DiskManager wait for their request, and throw if it failed.
+ *
+ * With enable_direct_io set, the segments are opened with O_DIRECT, so pages move between the disk and the buffer pool
+ * frames without a copy in the page cache. Buffer pool frames are aligned to DIRECT_IO_ALIGNMENT already, other
+ * buffers go through an aligned bounce buffer. File systems that reject O_DIRECT get buffered I/O.
+ *
+ * A FreeSpaceMap records which pages are in use, so that AllocatePage hands out pages freed by DeallocatePage again.
+ * Its changes are written out by FlushAllocations, and before the first write of a newly allocated page.
+ */
+class DiskManagerUring : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param use_io_uring false to always use the thread pool
+   * @param segment_pages number of pages per segment file
+   */
+  explicit DiskManagerUring(const std::string &db_file, bool use_io_uring = true,
+                            size_t segment_pages = TABLESPACE_SEGMENT_PAGES);
+
+  /** Wait for every queued request, then stop the I/O threads. */
+  ~DiskManagerUring() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override { WritePageAsync(page_id, page_data).get(); }
+
+  void ReadPage(page_id_t page_id, char *page_data) override { ReadPageAsync(page_id, page_data).get(); }
+
+  void ReadPages(page_id_t first_page_id, size_t num_pages, char *data) override;
+
+  auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> override;
+
+  auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> override;
+
+  auto AllocatePage(page_id_t near_page_id, uint32_t stride, uint32_t remainder) -> page_id_t override {
+    return free_space_map_.Allocate(near_page_id, stride, remainder);
+  }
+
+  void DeallocatePage(page_id_t page_id) override { free_space_map_.Deallocate(page_id); }
+
+  auto IsAllocated(page_id_t page_id) -> bool override { return free_space_map_.IsAllocated(page_id); }
+
+  void FlushAllocations() override { free_space_map_.Flush(); }
+
+  /** @return true if requests go through io_uring, false if the thread pool serves them */
+  auto IsUsingIoUring() const -> bool { return ring_ != nullptr; }
+
+  /** @return true if the segments are opened with O_DIRECT */
+  auto IsDirectIO() const -> bool { return tablespace_.IsDirectIO(); }
+
+ private:
+  /**
+   * One read or write of size bytes at offset. Pages past the end of the file read as zeros. A short transfer is
+   * resubmitted for the rest, and a failed one fails the future of the request.
+   */
+  struct IORequest {
+    bool is_write_;
+    int fd_;
+    size_t offset_;
+    size_t size_;
+    /** Bytes transferred so far. */
+    size_t transferred_{0};
+    /** The buffer the I/O goes to, the bounce buffer if there is one. */
+    char *data_;
+    /** Aligned copy of an unaligned caller buffer under O_DIRECT, and the caller buffer a read is copied back to. */
+    std::unique_ptr<char, void (*)(void *)> bounce_{nullptr, std::free};
+    char *caller_data_{nullptr};
+    std::promise<void> done_;
+  };
+
+  /** Queue a request for pages within one segment and wake up an I/O thread. */
+  auto Submit(bool is_write, page_id_t first_page_id, size_t num_pages, char *data) -> std::future<void>;
+
+  /**
+   * Finish a request. A read that reached the end of the file before transferred_ got to size_ is filled up with
+   * zeros.
+   * @param error 0, or -errno of the failure that is handed to the caller
+   */
+  static void Complete(IORequest *request, int error);
+
+  /** Main loop of the io_uring thread. */
+  void RingLoop();
+
+  /** Main loop of the thread pool threads. */
+  void WorkerLoop();
+
+  /** The database file, separate from the stream DiskManager keeps for it, and the segments after it. */
+  Tablespace tablespace_;
+  /** The pages in use, kept in the file named like the database file with ".fsm" appended. */
+  FreeSpaceMap free_space_map_;
+  /** The ring, nullptr when the thread pool serves the requests. */
+  io_uring *ring_{nullptr};
+
+  /** Requests not yet submitted, protected by queue_latch_. */
+  std::deque<std::unique_ptr<IORequest>> queue_;
+  bool stop_{false};
+  std::mutex queue_latch_;
+  std::condition_variable queue_cv_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace bustub
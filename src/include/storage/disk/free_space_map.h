@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap records which page ids of a database are in use, one bit per page, so that deleted pages are handed
+ * out again instead of growing the database file.
+ *
+ * The bitmap lives in map pages of its own file, BUSTUB_PAGE_SIZE * 8 page ids per map page. Changes only mark their
+ * map page dirty, and Flush writes the dirty ones out. The disk manager calls FlushAllocation before it writes a page,
+ * so the allocation of every page whose data is on disk is on disk too, and such a page id is never handed out twice
+ * across a restart. A page freed since the last flush is only lost to a crash, it stays in use.
+ *
+ * Allocation takes, in this order: the free page closest to a hint within FSM_SEARCH_WINDOW pages, the lowest free
+ * page, and the page after the highest allocated one. Only page ids of one residue class are considered, so that
+ * every instance of a parallel buffer pool gets ids that route back to it.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * @brief Open the map, or create it if the file does not exist. Throws an Exception if it cannot be opened.
+   * @param fsm_file the file of the map
+   * @param num_existing_pages pages [0, num_existing_pages) are marked in use when the map is created, for databases
+   * that were written before they had a map
+   */
+  FreeSpaceMap(const std::string &fsm_file, size_t num_existing_pages);
+
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  ~FreeSpaceMap();
+
+  /**
+   * @brief Allocate a free page and mark it in use.
+   * @param near_page_id prefer a page close to this one, INVALID_PAGE_ID for no preference
+   * @param stride only page ids with page_id % stride == remainder qualify
+   * @param remainder see stride
+   * @return the allocated page id
+   */
+  auto Allocate(page_id_t near_page_id, uint32_t stride, uint32_t remainder) -> page_id_t;
+
+  /** Mark a page free. Freeing a page that is not in use does nothing. */
+  void Deallocate(page_id_t page_id);
+
+  /** @return true if the page is in use */
+  auto IsAllocated(page_id_t page_id) -> bool;
+
+  /** Write the map pages changed since they were last written. */
+  void Flush();
+
+  /** Flush the map if the page was allocated since it was last written. Called before the page itself is written. */
+  void FlushAllocation(page_id_t page_id);
+
+ private:
+  /** Number of page ids one map page covers. */
+  static constexpr size_t PAGES_PER_MAP_PAGE = BUSTUB_PAGE_SIZE * 8;
+  static constexpr size_t WORDS_PER_MAP_PAGE = BUSTUB_PAGE_SIZE / sizeof(uint64_t);
+
+  auto TestBit(size_t page_id) const -> bool {
+    return page_id / 64 < bits_.size() && (bits_[page_id / 64] & (uint64_t{1} << (page_id % 64))) != 0;
+  }
+
+  /** Set or clear the bit of a page, growing the map if needed, and mark its map page dirty. */
+  void SetBit(size_t page_id, bool allocated);
+
+  /** Write the dirty map pages, with latch_ held. */
+  void FlushLatched();
+
+  /** @return the free page of the residue class closest to near_page_id within the window, or INVALID_PAGE_ID */
+  auto FindNear(page_id_t near_page_id, uint32_t stride, uint32_t remainder) const -> page_id_t;
+
+  /** @return the lowest free page of the residue class below end_, or INVALID_PAGE_ID. Moves lowest_free_ up. */
+  auto FindLowest(uint32_t stride, uint32_t remainder) -> page_id_t;
+
+  int fd_;
+  std::mutex latch_;
+  /** The map pages back to back, bit i of the map is page id i. Protected by latch_. */
+  std::vector<uint64_t> bits_;
+  /** One past the highest page id in use. Protected by latch_. */
+  size_t end_{0};
+  /** No page below it is free, FindLowest starts there. Protected by latch_. */
+  size_t lowest_free_{0};
+  /** The map pages changed since they were last written. Protected by latch_. */
+  std::vector<bool> dirty_;
+  /** The pages allocated since the map was last written. Protected by latch_. */
+  std::unordered_set<page_id_t> unflushed_;
+  /** Size of unflushed_, so that writing a page whose allocation is on disk already takes no latch. */
+  std::atomic<size_t> num_unflushed_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tablespace.h
+//
+// Identification: src/include/storage/disk/tablespace.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Tablespace spreads the pages of a database over segment files of segment_pages pages each. Segment 0 is the
+ * database file itself, segment n > 0 is the file named like it with ".n" appended, so a database that fits into one
+ * segment keeps its single-file layout.
+ *
+ * Segments are opened on first access and created if missing. With enable_segment_preallocation set, a new segment
+ * is allocated in full with fallocate, so that its pages are laid out contiguously on disk.
+ */
+class Tablespace {
+ public:
+  /**
+   * @brief Open segment 0. Throws an Exception if it cannot be opened.
+   * @param db_file the database file, the first segment
+   * @param direct_io true to open the segments with O_DIRECT, if the file system supports it
+   * @param segment_pages number of pages per segment
+   */
+  Tablespace(std::string db_file, bool direct_io, size_t segment_pages = TABLESPACE_SEGMENT_PAGES);
+
+  DISALLOW_COPY_AND_MOVE(Tablespace);
+
+  ~Tablespace();
+
+  /** @return the descriptor of the segment holding page_id, opening the segment if needed */
+  auto SegmentOf(page_id_t page_id) -> int;
+
+  /** @return the offset of page_id within its segment */
+  auto OffsetOf(page_id_t page_id) const -> int64_t {
+    return static_cast<int64_t>(static_cast<size_t>(page_id) % segment_pages_) * BUSTUB_PAGE_SIZE;
+  }
+
+  /** @return the number of pages from page_id to the end of its segment */
+  auto PagesLeftInSegment(page_id_t page_id) const -> size_t {
+    return segment_pages_ - static_cast<size_t>(page_id) % segment_pages_;
+  }
+
+  /** @return the file name of a segment */
+  auto SegmentFileName(size_t segment) const -> std::string;
+
+  /** @return true if the segments are opened with O_DIRECT */
+  auto IsDirectIO() const -> bool { return direct_io_; }
+
+  /** @return the number of pages up to the end of the last segment file, preallocated space included */
+  auto NumPages() const -> size_t;
+
+ private:
+  /** Open or create a segment file. Throws an Exception if it cannot. */
+  auto OpenSegment(size_t segment) -> int;
+
+  const std::string db_file_;
+  const size_t segment_pages_;
+  /** Whether O_DIRECT is used, decided when segment 0 is opened in the constructor. */
+  bool direct_io_;
+  /** Descriptors of the segments, -1 for segments not opened yet. */
+  std::vector<int> fds_;
+  std::shared_mutex latch_;
+};
+
+}  // namespace bustub
@@ -10,14 +10,18 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page_guard.h"
 
 #include "common/rwlatch.h"
 
@@ -27,6 +31,9 @@ namespace bustub {
 
 enum class Operation { SEARCH, INSERT, DELETE };
 
+/** Outcome of an optimistic attempt: done, try again, or go crabbing since the operation changes more than a leaf. */
+enum class OptimisticResult { SUCCESS, RESTART, FALL_BACK };
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
@@ -36,6 +43,18 @@ enum class Operation { SEARCH, INSERT, DELETE };
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * The tree is a B-link tree: every page links to its right sibling and keeps a high key, the separator of that
+ * sibling. A split moves the upper half of a page to a new right sibling under the latch of the page alone, and
+ * inserts the separator into the parent only after releasing it. Until then, a search that lands on the page finds
+ * its key at or above the high key and moves right. So an insert holds one latch at a time on its way up, and
+ * inserts into neighboring key ranges do not wait on each other for the ancestors.
+ *
+ * Lookups and inserts first descend optimistically: they pin the pages on the way down without latching them, and
+ * check with the page versions that no writer latched a page while they read it. Only the leaf is latched. An insert
+ * that would split the leaf descends again with latches. Removes merge pages, which B-link searches cannot move
+ * past, so a remove holds root_page_id_latch_ exclusively and crabs down, while the latching lookups and inserts
+ * share it.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -52,6 +71,15 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
+  /**
+   * Load key-value pairs in key order. An empty tree is built bottom-up: the leaves are filled left to right up to
+   * bulk_load_fill_factor and placed next to each other, then each level of internal pages is built over the one
+   * below. A tree that has keys already gets the pairs inserted one by one. Repeated keys are skipped. If next or
+   * building the tree throws, the pages built so far are deleted and the tree stays empty.
+   * @param next called for the next pair, returns false when there are no more
+   */
+  void BulkLoad(const std::function<bool(KeyType *, ValueType *)> &next, Transaction *transaction = nullptr);
+
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
@@ -94,11 +122,30 @@ class BPlusTree {
 
   auto InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+  /**
+   * Insert the separator of a new child into its parent.
+   * @param parent_page_id the parent of the left sibling of the child when it split, the parent is there or to the
+   * right of it
+   */
+  void InsertIntoParent(page_id_t parent_page_id, const KeyType &key, page_id_t child_page_id);
+
+  // build a level of internal pages of fill children over the level below, given by the first keys and page ids,
+  // and add the new pages to built_pages
+  auto BulkLoadInternalLevel(const std::vector<std::pair<KeyType, page_id_t>> &children, int fill,
+                             std::vector<page_id_t> *built_pages) -> std::vector<std::pair<KeyType, page_id_t>>;
+
+  // bring the last node of a bulk-loaded level up to its min size, from its left sibling or by merging into it, a
+  // merged node is taken off level and built_pages
+  template <typename N>
+  void BulkLoadBalanceLast(BasicPageGuard *prev_guard, BasicPageGuard *cur_guard,
+                           std::vector<std::pair<KeyType, page_id_t>> *level, std::vector<page_id_t> *built_pages);
+
+  // grow the tree by a level above the split root old_node, which is latched
+  void InsertNewRoot(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node);
 
+  // move the upper half of node into a new right sibling, which stays pinned and latched by new_page
   template <typename N>
-  auto Split(N *node) -> N *;
+  auto Split(N *node, WritePageGuard *new_page) -> N *;
 
   template <typename N>
   auto CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr) -> bool;
@@ -112,14 +159,40 @@ class BPlusTree {
                     int index, bool from_prev);
 
   auto AdjustRoot(BPlusTreePage *node) -> bool;
+
+  // free a page that is no longer in the tree, or keep it in pending_deletes_ while it is pinned
+  void DeleteUnlinkedPage(page_id_t page_id);
+
+  // free the pages of pending_deletes_ that are no longer pinned
+  void RetryPendingDeletes();
+
+  // true if key belongs to a right sibling of node, which split since its parent pointed to it
+  auto IsBeyondHighKey(const BPlusTreePage *node, const KeyType &key) const -> bool;
+
+  /**
+   * Descend to the leaf of key without latching.
+   * @param[out] leaf the leaf, pinned but not latched, nullptr if the tree is empty
+   * @param[out] version the version of the leaf when its parent pointed to it
+   * @return false if a writer got in the way, nothing is pinned then
+   */
+  auto FindLeafOptimistic(const KeyType &key, Page **leaf, uint64_t *version) -> bool;
+
+  auto GetValueOptimistic(const KeyType &key, std::vector<ValueType> *result, bool *found) -> OptimisticResult;
+
+  auto InsertOptimistic(const KeyType &key, const ValueType &value, bool *inserted) -> OptimisticResult;
+
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  /** Atomic because the optimistic descents read it without the root latch. */
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  /** Shared by the latching lookups and inserts, removes and starting a new tree hold it exclusively. */
   ReaderWriterLatch root_page_id_latch_;
+  /** Unlinked pages that were pinned when they were deleted, protected by root_page_id_latch_ held exclusively. */
+  std::vector<page_id_t> pending_deletes_;
 };
 
 }  // namespace bustub
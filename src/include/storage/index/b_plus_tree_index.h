@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -35,6 +36,14 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Build the index over existing entries, like those of a table. The entries are put in key order with an external
+   * sort, which spills to the buffer pool, and loaded bottom-up with BPlusTree::BulkLoad. Of the entries with the same
+   * key, the index keeps the first one next returned.
+   * @param next called for the key and RID of the next entry, returns false when there are no more
+   */
+  void BulkLoad(const std::function<bool(Tuple *, RID *)> &next, Transaction *transaction);
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -46,6 +55,8 @@ class BPlusTreeIndex : public Index {
   KeyComparator comparator_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
+  // for the runs of the external sort of BulkLoad
+  BufferPoolManager *buffer_pool_manager_;
 };
 
 /** We only support index table with one integer key for now in BusTub. Hardcode everything here. */
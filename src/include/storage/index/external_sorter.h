@@ -0,0 +1,278 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.h
+//
+// Identification: src/include/storage/index/external_sorter.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/exception.h"
+
+namespace bustub {
+
+/**
+ * ExternalSorter sorts more entries than fit in memory, for building an index bottom-up.
+ *
+ * Entries are collected in memory until they fill a run of run_bytes. The run is then sorted and written to new pages
+ * of the buffer pool, next to each other on disk, from where it is evicted like any other page. Sort merges the runs
+ * fan_in at a time until at most fan_in are left, and Next streams the entries out of a merge of those. A merge reads
+ * a run a page at a time, and deletes the pages it has read. If all the entries fit in a single run, nothing is
+ * written and they are sorted in memory.
+ *
+ * @tparam Entry entry type, trivially copyable since the runs are copied to the pages byte by byte
+ * @tparam Less function object ordering the entries
+ */
+template <typename Entry, typename Less>
+class ExternalSorter {
+  static_assert(std::is_trivially_copyable_v<Entry>, "runs are copied to the pages byte by byte");
+  static constexpr size_t ENTRIES_PER_PAGE = BUSTUB_PAGE_SIZE / sizeof(Entry);
+
+ public:
+  ExternalSorter(BufferPoolManager *bpm, Less less, size_t run_bytes = EXTERNAL_SORT_RUN_BYTES,
+                 size_t fan_in = EXTERNAL_SORT_FAN_IN)
+      : bpm_(bpm),
+        less_(std::move(less)),
+        run_size_(std::max<size_t>(run_bytes / sizeof(Entry), 1)),
+        fan_in_(std::max<size_t>(fan_in, 2)) {}
+
+  ExternalSorter(const ExternalSorter &) = delete;
+  auto operator=(const ExternalSorter &) -> ExternalSorter & = delete;
+
+  /** Delete the pages of the runs that were not read, also when a merge threw. */
+  ~ExternalSorter() {
+    for (auto &run : runs_) {
+      DeleteRun(run, 0);
+    }
+    for (auto &run : merged_) {
+      DeleteRun(run, 0);
+    }
+    for (auto &reader : readers_) {
+      DeleteRun(reader.run_, reader.next_page_);
+    }
+  }
+
+  /** Add an entry, before Sort. */
+  void Add(const Entry &entry) {
+    buffer_.push_back(entry);
+    size_++;
+    if (buffer_.size() == run_size_) {
+      WriteRun();
+    }
+  }
+
+  /** Sort the entries added so far, Next returns them in order from then on. */
+  void Sort() {
+    if (runs_.empty()) {
+      std::sort(buffer_.begin(), buffer_.end(), less_);
+      return;
+    }
+    if (!buffer_.empty()) {
+      WriteRun();
+    }
+    buffer_ = std::vector<Entry>();
+    while (runs_.size() > fan_in_) {
+      for (size_t i = 0; i < runs_.size(); i += fan_in_) {
+        OpenMerge(runs_.begin() + i, runs_.begin() + std::min(i + fan_in_, runs_.size()));
+        merged_.emplace_back();
+        Entry entry;
+        while (NextMerged(&entry)) {
+          Append(&merged_.back(), entry);
+        }
+        Flush(&merged_.back());
+      }
+      runs_ = std::move(merged_);
+      merged_.clear();
+    }
+    OpenMerge(runs_.begin(), runs_.end());
+    runs_.clear();
+  }
+
+  /**
+   * @param[out] entry the next entry in order
+   * @return false if all the entries were returned
+   */
+  auto Next(Entry *entry) -> bool {
+    if (readers_.empty()) {
+      if (next_ == buffer_.size()) {
+        return false;
+      }
+      *entry = buffer_[next_++];
+      return true;
+    }
+    return NextMerged(entry);
+  }
+
+  /** @return the number of entries added */
+  auto Size() const -> size_t { return size_; }
+
+ private:
+  /** A sorted run, the pages are full except for the last one. */
+  struct Run {
+    std::vector<page_id_t> pages_;
+    size_t size_{0};
+    /** The entries of the last page, until it is full. */
+    std::vector<Entry> tail_;
+  };
+
+  /** Reads a run for a merge, a page at a time. */
+  struct RunReader {
+    Run run_;
+    size_t next_page_{0};
+    std::vector<Entry> page_;
+    size_t next_{0};
+  };
+
+  /** The top of a merge, the smallest entry is on top. */
+  struct HeapItem {
+    Entry entry_;
+    size_t reader_;
+  };
+
+  /** Sort the entries in memory and write them out as a new run. */
+  void WriteRun() {
+    std::sort(buffer_.begin(), buffer_.end(), less_);
+    runs_.emplace_back();
+    for (const auto &entry : buffer_) {
+      Append(&runs_.back(), entry);
+    }
+    Flush(&runs_.back());
+    buffer_.clear();
+  }
+
+  void Append(Run *run, const Entry &entry) {
+    run->tail_.push_back(entry);
+    run->size_++;
+    if (run->tail_.size() == ENTRIES_PER_PAGE) {
+      Flush(run);
+    }
+  }
+
+  /** Write the tail of a run to a new page, placed after the last one of the run. */
+  void Flush(Run *run) {
+    if (run->tail_.empty()) {
+      return;
+    }
+    page_id_t page_id;
+    const page_id_t last_page_id = run->pages_.empty() ? INVALID_PAGE_ID : run->pages_.back();
+    BasicPageGuard guard = bpm_->NewPageGuarded(&page_id, last_page_id);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
+    }
+    std::memcpy(guard.GetDataMut(), run->tail_.data(), run->tail_.size() * sizeof(Entry));
+    run->pages_.push_back(page_id);
+    run->tail_.clear();
+  }
+
+  /** Delete the pages of a run from the first one not read yet. */
+  void DeleteRun(const Run &run, size_t first_page) {
+    for (size_t i = first_page; i < run.pages_.size(); i++) {
+      bpm_->DeletePage(run.pages_[i]);
+    }
+  }
+
+  /** Start merging the runs in [first, last), which are handed over to the readers. */
+  template <typename It>
+  void OpenMerge(It first, It last) {
+    readers_.clear();
+    heap_ = decltype(heap_)(HeapGreater{&less_});
+    for (auto it = first; it != last; ++it) {
+      readers_.emplace_back();
+      readers_.back().run_ = std::move(*it);
+      it->pages_.clear();
+      Entry entry;
+      if (ReadNext(&readers_.back(), &entry)) {
+        heap_.push({entry, readers_.size() - 1});
+      }
+    }
+  }
+
+  /** @return false if the merge is done */
+  auto NextMerged(Entry *entry) -> bool {
+    if (heap_.empty()) {
+      readers_.clear();
+      return false;
+    }
+    const HeapItem top = heap_.top();
+    heap_.pop();
+    *entry = top.entry_;
+    Entry next;
+    if (ReadNext(&readers_[top.reader_], &next)) {
+      heap_.push({next, top.reader_});
+    }
+    return true;
+  }
+
+  /** Read the next entry of a run, loading and deleting its next page when the current one is used up. */
+  auto ReadNext(RunReader *reader, Entry *entry) -> bool {
+    if (reader->next_ == reader->page_.size()) {
+      if (reader->next_page_ == reader->run_.pages_.size()) {
+        return false;
+      }
+      const page_id_t page_id = reader->run_.pages_[reader->next_page_];
+      if (reader->next_page_ + 1 < reader->run_.pages_.size()) {
+        bpm_->PrefetchPages({reader->run_.pages_[reader->next_page_ + 1]});
+      }
+      const size_t count = std::min(ENTRIES_PER_PAGE, reader->run_.size_ - reader->next_page_ * ENTRIES_PER_PAGE);
+      reader->page_.resize(count);
+      {
+        ReadPageGuard guard = bpm_->FetchPageRead(page_id);
+        if (!guard.IsValid()) {
+          throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot fetch a page of a sorted run");
+        }
+        std::memcpy(reader->page_.data(), guard.GetData(), count * sizeof(Entry));
+      }
+      // a page counts as read once it is deleted, the destructor deletes it otherwise
+      bpm_->DeletePage(page_id);
+      reader->next_page_++;
+      reader->next_ = 0;
+    }
+    *entry = reader->page_[reader->next_++];
+    return true;
+  }
+
+  /** Orders the heap items so that the smallest entry is on top. */
+  struct HeapGreater {
+    const Less *less_;
+    auto operator()(const HeapItem &lhs, const HeapItem &rhs) const -> bool {
+      return (*less_)(rhs.entry_, lhs.entry_);
+    }
+  };
+
+  BufferPoolManager *bpm_;
+  Less less_;
+  /** Entries per run. */
+  const size_t run_size_;
+  const size_t fan_in_;
+  size_t size_{0};
+
+  /** The entries of the run being collected, and all of them if there is a single run. */
+  std::vector<Entry> buffer_;
+  /** Position of Next in buffer_, if there is a single run. */
+  size_t next_{0};
+  /** The runs written so far. */
+  std::vector<Run> runs_;
+  /** The runs a pass of Sort merged runs_ into so far. */
+  std::vector<Run> merged_;
+
+  /** The merge in progress. */
+  std::vector<RunReader> readers_;
+  std::priority_queue<HeapItem, std::vector<HeapItem>, HeapGreater> heap_{HeapGreater{&less_}};
+};
+
+}  // namespace bustub
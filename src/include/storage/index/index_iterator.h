@@ -13,6 +13,7 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/read_ahead_window.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -25,6 +26,7 @@ class IndexIterator {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
   // you may define your own constructor based on your member variables
+  /** The iterator keeps scan_prefetch_window leaves after the current one prefetching. */
   IndexIterator(BufferPoolManager *bpm, Page *page, int index = 0);
   ~IndexIterator();
 
@@ -44,6 +46,7 @@ class IndexIterator {
   Page *page_;
   LeafPage *leaf_ = nullptr;
   int index_ = 0;
+  ReadAheadWindow read_ahead_;
 };
 
 }  // namespace bustub
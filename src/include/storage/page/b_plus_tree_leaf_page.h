@@ -18,7 +18,7 @@
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
+#define LEAF_PAGE_HEADER_SIZE (28 + sizeof(KeyType))
 #define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
 
 /**
@@ -31,13 +31,16 @@ namespace bustub {
  * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 28 bytes plus the key in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ----------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | HighKey
+ *  ----------------------------------------------------------------
+ *
+ *  The high key bounds the keys of the page from above while it has a next
+ *  page, a key at or above it belongs to a page further right.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -46,8 +49,8 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   // method to set default values
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
   // helper methods
-  auto GetNextPageId() const -> page_id_t;
-  void SetNextPageId(page_id_t next_page_id);
+  auto GetHighKey() const -> KeyType;
+  void SetHighKey(const KeyType &key);
   auto KeyAt(int index) const -> KeyType;
   auto GetItem(int index) -> const MappingType &;
   auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
@@ -61,7 +64,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
-  page_id_t next_page_id_;
+  KeyType high_key_;
   // Flexible array member for page data.
   MappingType array_[1];
   void CopyNFrom(MappingType *items, int size);
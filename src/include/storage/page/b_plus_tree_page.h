@@ -33,11 +33,11 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 28 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | NextPageId (4) |
  * ----------------------------------------------------------------------------
  */
 class BPlusTreePage {
@@ -61,6 +61,10 @@ class BPlusTreePage {
   auto GetPageId() const -> page_id_t;
   void SetPageId(page_id_t page_id);
 
+  // the right sibling at the same level, INVALID_PAGE_ID for the rightmost page
+  auto GetNextPageId() const -> page_id_t;
+  void SetNextPageId(page_id_t next_page_id);
+
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
  private:
@@ -71,6 +75,7 @@ class BPlusTreePage {
   int max_size_;
   page_id_t parent_page_id_;
   page_id_t page_id_;
+  page_id_t next_page_id_;
 };
 
 }  // namespace bustub
@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -24,14 +26,23 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The metadata of a page is aligned to a cache line, so that pinning one frame of the buffer pool does not contend with
+ * its neighbors. The data of buffer pool frames lives in the pool's FrameArena.
  */
-class Page {
+class alignas(BUSTUB_CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor for a page outside the buffer pool, which owns its zeroed data. */
+  Page() : owned_data_(new char[BUSTUB_PAGE_SIZE]{}), data_(owned_data_.get()) {}
+
+  /**
+   * Constructor for a buffer pool frame.
+   * @param data BUSTUB_PAGE_SIZE bytes of zeroed memory that outlive the page
+   */
+  explicit Page(char *data) : data_(data) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -49,22 +60,59 @@ class Page {
   inline auto IsDirty() -> bool { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_++;
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_++;
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Try to acquire the page read latch without blocking. */
+  inline auto TryRLatch() -> bool { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * @return the version of the page, which taking and releasing the write latch each move up by one, so that it is odd
+   * while a writer holds the latch
+   */
+  inline auto GetVersion() const -> uint64_t { return version_; }
+
+  /** @return true if no writer latched the page since GetVersion returned version, so what was read in between holds */
+  inline auto ValidateVersion(uint64_t version) const -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
-  /** Sets the page LSN. */
-  inline void SetLSN(lsn_t lsn) { memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t)); }
+  /** Sets the page LSN. The first LSN set since the page was last written out becomes its recLSN. */
+  inline void SetLSN(lsn_t lsn) {
+    memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t));
+    MarkRecLSN(lsn);
+  }
+
+  /**
+   * Makes lsn the recLSN of the page, unless it has one already. A logged change calls it under the write latch before
+   * its record is appended, with the next LSN of the log. A checkpoint taken before the record gets its LSN then still
+   * finds the page in the dirty page table.
+   */
+  inline void MarkRecLSN(lsn_t lsn) {
+    lsn_t expected = INVALID_LSN;
+    rec_lsn_.compare_exchange_strong(expected, lsn);
+  }
+
+  /** @return the LSN of the oldest log record whose change may not be on disk yet, INVALID_LSN if there is none. */
+  inline auto GetRecLSN() -> lsn_t { return rec_lsn_; }
 
  protected:
   static_assert(sizeof(page_id_t) == 4);
@@ -78,16 +126,22 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
 
+  /** Data of a page that is not a buffer pool frame. */
+  std::unique_ptr<char[]> owned_data_;
   /** The actual data that is stored within a page. */
-  char data_[BUSTUB_PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  char *data_;
+  /** The ID of this page. Atomic because the buffer pool validates it after pinning without holding its latch. */
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /** The pin count of this page. Negative while the buffer pool is replacing the page in this frame. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
+  /** The recLSN of the page, reset by the buffer pool when it writes the page out. */
+  std::atomic<lsn_t> rec_lsn_{INVALID_LSN};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Version for optimistic readers that take no latch, see GetVersion. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
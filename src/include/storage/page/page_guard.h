@@ -0,0 +1,208 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns one pin on a page and unpins it when dropped or destroyed. It is move-only, so the pin has
+ * exactly one owner, and it is just two pointers and a flag, so guards can be passed around by value.
+ *
+ * The page is unpinned as dirty if it was accessed through AsMut or GetDataMut, or if SetDirty was called.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * @brief Take over a pin the caller already holds.
+   * @param bpm the buffer pool the page was pinned in
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  /** Take over the pin of that, which becomes empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Drop the pin this guard holds, then take over the pin of that, which becomes empty. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now and leave the guard empty. Does nothing on an empty guard. */
+  void Drop();
+
+  /**
+   * @brief Latch the page for reading and move the pin into a ReadPageGuard. This guard becomes empty.
+   * @return the read guard, empty if this guard was empty
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  /**
+   * @brief Latch the page for writing and move the pin into a WritePageGuard. This guard becomes empty.
+   * @return the write guard, empty if this guard was empty
+   */
+  auto UpgradeWrite() -> WritePageGuard;
+
+  /** @return false if the guard holds no page, e.g. because the buffer pool had no frame for it */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  auto PageId() -> page_id_t { return page_->GetPageId(); }
+
+  auto GetData() -> const char * { return page_->GetData(); }
+
+  /** @return the page data, marking the page dirty */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /**
+   * @return the page viewed as T, without marking it dirty. T is either laid over the page data, like the B+ tree
+   * pages, or a subclass of Page, like TablePage.
+   */
+  template <class T>
+  auto As() -> T * {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+  /** @return the page viewed as T like As, marking the page dirty */
+  template <class T>
+  auto AsMut() -> T * {
+    is_dirty_ = true;
+    return As<T>();
+  }
+
+  /** Unpin the page as dirty. */
+  void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch of a page, and releases both when dropped or destroyed.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * @brief Take over a pin and a read latch the caller already holds.
+   * @param bpm the buffer pool the page was pinned in
+   * @param page the pinned and read-latched page, nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Release the page this guard holds, then take over the pin and latch of that. */
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now and leave the guard empty. Does nothing on an empty guard. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() -> T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch of a page, and releases both when dropped or destroyed.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * @brief Take over a pin and a write latch the caller already holds.
+   * @param bpm the buffer pool the page was pinned in
+   * @param page the pinned and write-latched page, nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Release the page this guard holds, then take over the pin and latch of that. */
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now and leave the guard empty. Does nothing on an empty guard. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  template <class T>
+  auto As() -> T * {
+    return guard_.As<T>();
+  }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
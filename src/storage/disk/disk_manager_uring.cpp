@@ -0,0 +1,253 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.cpp
+//
+// Identification: src/storage/disk/disk_manager_uring.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_uring.h"
+
+#include <unistd.h>
+#ifdef BUSTUB_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskManagerUring::DiskManagerUring(const std::string &db_file, bool use_io_uring, size_t segment_pages)
+    : DiskManager(db_file),
+      tablespace_(db_file, enable_direct_io, segment_pages),
+      free_space_map_(db_file + ".fsm", tablespace_.NumPages()) {
+#ifdef BUSTUB_HAVE_LIBURING
+  if (use_io_uring) {
+    ring_ = new io_uring;
+    if (io_uring_queue_init(URING_QUEUE_DEPTH, ring_, 0) == 0) {
+      threads_.emplace_back(&DiskManagerUring::RingLoop, this);
+      return;
+    }
+    // e.g. an old kernel, or io_uring disabled by seccomp
+    LOG_WARN("io_uring is not available, falling back to a thread pool");
+    delete ring_;
+    ring_ = nullptr;
+  }
+#endif
+
+  for (int i = 0; i < DISK_IO_THREADS; i++) {
+    threads_.emplace_back(&DiskManagerUring::WorkerLoop, this);
+  }
+}
+
+DiskManagerUring::~DiskManagerUring() {
+  {
+    const std::lock_guard<std::mutex> guard(queue_latch_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+#ifdef BUSTUB_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    io_uring_queue_exit(ring_);
+    delete ring_;
+  }
+#endif
+}
+
+void DiskManagerUring::ReadPages(page_id_t first_page_id, size_t num_pages, char *data) {
+  // one request per segment the run touches, all in flight together
+  std::vector<std::future<void>> reads;
+  while (num_pages > 0) {
+    const size_t segment_pages = std::min(num_pages, tablespace_.PagesLeftInSegment(first_page_id));
+    reads.push_back(Submit(false, first_page_id, segment_pages, data));
+    first_page_id += static_cast<page_id_t>(segment_pages);
+    data += segment_pages * BUSTUB_PAGE_SIZE;
+    num_pages -= segment_pages;
+  }
+  for (auto &read : reads) {
+    read.get();
+  }
+}
+
+auto DiskManagerUring::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> {
+  return Submit(false, page_id, 1, page_data);
+}
+
+auto DiskManagerUring::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> {
+  free_space_map_.FlushAllocation(page_id);
+  // the request only reads from the buffer of a write
+  return Submit(true, page_id, 1, const_cast<char *>(page_data));  // NOLINT
+}
+
+auto DiskManagerUring::Submit(bool is_write, page_id_t first_page_id, size_t num_pages, char *data)
+    -> std::future<void> {
+  const size_t size = num_pages * BUSTUB_PAGE_SIZE;
+  auto request = std::make_unique<IORequest>();
+  request->is_write_ = is_write;
+  request->fd_ = tablespace_.SegmentOf(first_page_id);
+  request->offset_ = tablespace_.OffsetOf(first_page_id);
+  request->size_ = size;
+  request->data_ = data;
+  if (tablespace_.IsDirectIO() && reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT != 0) {
+    request->bounce_.reset(static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, size)));
+    if (request->bounce_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a bounce buffer");
+    }
+    if (is_write) {
+      memcpy(request->bounce_.get(), data, size);
+    } else {
+      request->caller_data_ = data;
+    }
+    request->data_ = request->bounce_.get();
+  }
+  auto done = request->done_.get_future();
+  {
+    const std::lock_guard<std::mutex> guard(queue_latch_);
+    if (is_write) {
+      num_writes_ += 1;
+    }
+    queue_.push_back(std::move(request));
+  }
+  queue_cv_.notify_one();
+  return done;
+}
+
+void DiskManagerUring::Complete(IORequest *request, int error) {
+  if (error != 0) {
+    const std::string message =
+        std::string(request->is_write_ ? "I/O error writing pages: " : "I/O error reading pages: ") + strerror(-error);
+    LOG_WARN("%s", message.c_str());
+    request->done_.set_exception(std::make_exception_ptr(Exception(message)));
+    return;
+  }
+  if (request->transferred_ < request->size_) {
+    // the read went past the end of the file
+    memset(request->data_ + request->transferred_, 0, request->size_ - request->transferred_);
+  }
+  if (request->caller_data_ != nullptr) {
+    memcpy(request->caller_data_, request->data_, request->size_);
+  }
+  request->done_.set_value();
+}
+
+void DiskManagerUring::WorkerLoop() {
+  while (true) {
+    std::unique_ptr<IORequest> request;
+    {
+      std::unique_lock<std::mutex> lock(queue_latch_);
+      queue_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      request = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    int error = 0;
+    while (request->transferred_ < request->size_) {
+      const size_t done = request->transferred_;
+      const auto offset = static_cast<off_t>(request->offset_ + done);
+      const ssize_t result = request->is_write_
+                                 ? pwrite(request->fd_, request->data_ + done, request->size_ - done, offset)
+                                 : pread(request->fd_, request->data_ + done, request->size_ - done, offset);
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result < 0) {
+        error = -errno;
+        break;
+      }
+      if (result == 0) {
+        // a read stops at the end of the file, a write that makes no progress has failed
+        error = request->is_write_ ? -EIO : 0;
+        break;
+      }
+      request->transferred_ += static_cast<size_t>(result);
+    }
+    Complete(request.get(), error);
+  }
+}
+
+void DiskManagerUring::RingLoop() {
+#ifdef BUSTUB_HAVE_LIBURING
+  // with requests in flight, look for newly queued ones this often
+  __kernel_timespec poll_interval{0, 200 * 1000};
+  size_t in_flight = 0;
+  // short or interrupted transfers, which go out again with the next round
+  std::vector<std::unique_ptr<IORequest>> resubmit;
+  while (true) {
+    std::vector<std::unique_ptr<IORequest>> batch = std::move(resubmit);
+    resubmit.clear();
+    {
+      std::unique_lock<std::mutex> lock(queue_latch_);
+      if (in_flight == 0 && batch.empty()) {
+        queue_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+      }
+      while (!queue_.empty() && in_flight + batch.size() < URING_QUEUE_DEPTH) {
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+    }
+
+    // everything queued since the last round goes to the kernel with one system call
+    for (auto &request : batch) {
+      io_uring_sqe *sqe = io_uring_get_sqe(ring_);
+      const size_t done = request->transferred_;
+      if (request->is_write_) {
+        io_uring_prep_write(sqe, request->fd_, request->data_ + done, request->size_ - done, request->offset_ + done);
+      } else {
+        io_uring_prep_read(sqe, request->fd_, request->data_ + done, request->size_ - done, request->offset_ + done);
+      }
+      io_uring_sqe_set_data(sqe, request.release());
+    }
+    if (!batch.empty()) {
+      io_uring_submit(ring_);
+      in_flight += batch.size();
+    }
+
+    io_uring_cqe *cqe;
+    if (io_uring_wait_cqe_timeout(ring_, &cqe, &poll_interval) != 0) {
+      continue;
+    }
+    do {
+      std::unique_ptr<IORequest> request(static_cast<IORequest *>(io_uring_cqe_get_data(cqe)));
+      const int result = cqe->res;
+      io_uring_cqe_seen(ring_, cqe);
+      in_flight--;
+      if (result == -EINTR || result == -EAGAIN) {
+        resubmit.push_back(std::move(request));
+      } else if (result < 0) {
+        Complete(request.get(), result);
+      } else if (result == 0) {
+        // a read stops at the end of the file, a write that makes no progress has failed
+        Complete(request.get(), request->is_write_ ? -EIO : 0);
+      } else {
+        request->transferred_ += static_cast<size_t>(result);
+        if (request->transferred_ < request->size_) {
+          resubmit.push_back(std::move(request));
+        } else {
+          Complete(request.get(), 0);
+        }
+      }
+    } while (io_uring_peek_cqe(ring_, &cqe) == 0);
+  }
+#endif
+}
+
+}  // namespace bustub
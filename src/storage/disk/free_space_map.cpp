@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+FreeSpaceMap::FreeSpaceMap(const std::string &fsm_file, size_t num_existing_pages) {
+  fd_ = open(fsm_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw Exception("can't open free space map file");
+  }
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0) {
+    close(fd_);
+    throw Exception("can't open free space map file");
+  }
+
+  if (stat_buf.st_size == 0) {
+    // a new map, take over the pages the database already has
+    for (size_t page_id = 0; page_id < num_existing_pages; page_id++) {
+      SetBit(page_id, true);
+    }
+    FlushLatched();
+    return;
+  }
+
+  const size_t num_map_pages = (static_cast<size_t>(stat_buf.st_size) + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE;
+  bits_.resize(num_map_pages * WORDS_PER_MAP_PAGE);
+  dirty_.resize(num_map_pages);
+  if (pread(fd_, bits_.data(), stat_buf.st_size, 0) != stat_buf.st_size) {
+    close(fd_);
+    throw Exception("can't read free space map file");
+  }
+  for (size_t word = bits_.size(); word > 0; word--) {
+    if (bits_[word - 1] != 0) {
+      end_ = (word - 1) * 64 + (64 - __builtin_clzll(bits_[word - 1]));
+      break;
+    }
+  }
+}
+
+FreeSpaceMap::~FreeSpaceMap() {
+  Flush();
+  close(fd_);
+}
+
+auto FreeSpaceMap::Allocate(page_id_t near_page_id, uint32_t stride, uint32_t remainder) -> page_id_t {
+  BUSTUB_ASSERT(stride > 0 && remainder < stride, "invalid residue class");
+  const std::lock_guard<std::mutex> guard(latch_);
+  page_id_t page_id = INVALID_PAGE_ID;
+  if (near_page_id != INVALID_PAGE_ID) {
+    page_id = FindNear(near_page_id, stride, remainder);
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = FindLowest(stride, remainder);
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    // extend the database with the first page of the class after the highest page in use
+    page_id = static_cast<page_id_t>(end_ + (remainder + stride - end_ % stride) % stride);
+  }
+  SetBit(page_id, true);
+  unflushed_.insert(page_id);
+  num_unflushed_ = unflushed_.size();
+  return page_id;
+}
+
+void FreeSpaceMap::Deallocate(page_id_t page_id) {
+  BUSTUB_ASSERT(page_id >= 0, "invalid page id");
+  const std::lock_guard<std::mutex> guard(latch_);
+  if (!TestBit(page_id)) {
+    LOG_DEBUG("freeing page %d, which is not in use", page_id);
+    return;
+  }
+  SetBit(page_id, false);
+  unflushed_.erase(page_id);
+  num_unflushed_ = unflushed_.size();
+  lowest_free_ = std::min(lowest_free_, static_cast<size_t>(page_id));
+}
+
+auto FreeSpaceMap::IsAllocated(page_id_t page_id) -> bool {
+  const std::lock_guard<std::mutex> guard(latch_);
+  return page_id >= 0 && TestBit(page_id);
+}
+
+void FreeSpaceMap::Flush() {
+  const std::lock_guard<std::mutex> guard(latch_);
+  FlushLatched();
+}
+
+void FreeSpaceMap::FlushAllocation(page_id_t page_id) {
+  if (num_unflushed_ == 0) {
+    return;
+  }
+  const std::lock_guard<std::mutex> guard(latch_);
+  if (unflushed_.count(page_id) != 0) {
+    FlushLatched();
+  }
+}
+
+void FreeSpaceMap::FlushLatched() {
+  for (size_t map_page = 0; map_page < dirty_.size(); map_page++) {
+    if (!dirty_[map_page]) {
+      continue;
+    }
+    const auto offset = static_cast<off_t>(map_page * BUSTUB_PAGE_SIZE);
+    if (pwrite(fd_, &bits_[map_page * WORDS_PER_MAP_PAGE], BUSTUB_PAGE_SIZE, offset) != BUSTUB_PAGE_SIZE) {
+      // the map page stays dirty, and the next flush tries again
+      LOG_DEBUG("I/O error while writing the free space map");
+      return;
+    }
+    dirty_[map_page] = false;
+  }
+  unflushed_.clear();
+  num_unflushed_ = 0;
+}
+
+void FreeSpaceMap::SetBit(size_t page_id, bool allocated) {
+  const size_t map_page = page_id / PAGES_PER_MAP_PAGE;
+  if (bits_.size() < (map_page + 1) * WORDS_PER_MAP_PAGE) {
+    bits_.resize((map_page + 1) * WORDS_PER_MAP_PAGE);
+    dirty_.resize(map_page + 1);
+  }
+  const uint64_t mask = uint64_t{1} << (page_id % 64);
+  if (allocated) {
+    bits_[page_id / 64] |= mask;
+    end_ = std::max(end_, page_id + 1);
+  } else {
+    bits_[page_id / 64] &= ~mask;
+  }
+  dirty_[map_page] = true;
+}
+
+auto FreeSpaceMap::FindNear(page_id_t near_page_id, uint32_t stride, uint32_t remainder) const -> page_id_t {
+  // the closest pages of the class at or above and below the hint
+  const auto near = static_cast<int64_t>(near_page_id);
+  int64_t up = near + (remainder + stride - near % stride) % stride;
+  int64_t down = up - stride;
+  const auto window = static_cast<int64_t>(FSM_SEARCH_WINDOW);
+  while (up - near <= window || near - down <= window) {
+    const bool take_up = up - near <= near - down;
+    const int64_t candidate = take_up ? up : down;
+    if (std::abs(candidate - near) > window) {
+      break;
+    }
+    if (candidate >= 0 && static_cast<size_t>(candidate) < end_ && !TestBit(candidate)) {
+      return static_cast<page_id_t>(candidate);
+    }
+    if (take_up) {
+      up += stride;
+    } else {
+      down -= stride;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+auto FreeSpaceMap::FindLowest(uint32_t stride, uint32_t remainder) -> page_id_t {
+  bool found_free = false;
+  for (size_t word = lowest_free_ / 64; word * 64 < end_; word++) {
+    if (bits_[word] == ~uint64_t{0}) {
+      continue;
+    }
+    if (!found_free) {
+      // the first free page of any class, the words before it need no look next time
+      lowest_free_ = std::max(lowest_free_, word * 64 + __builtin_ctzll(~bits_[word]));
+      found_free = true;
+    }
+    for (size_t page_id = word * 64; page_id < (word + 1) * 64 && page_id < end_; page_id++) {
+      if (page_id % stride == remainder && !TestBit(page_id)) {
+        return static_cast<page_id_t>(page_id);
+      }
+    }
+  }
+  if (!found_free) {
+    lowest_free_ = end_;
+  }
+  return INVALID_PAGE_ID;
+}
+
+}  // namespace bustub
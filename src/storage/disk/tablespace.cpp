@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tablespace.cpp
+//
+// Identification: src/storage/disk/tablespace.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/tablespace.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <mutex>  // NOLINT
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+Tablespace::Tablespace(std::string db_file, bool direct_io, size_t segment_pages)
+    : db_file_(std::move(db_file)), segment_pages_(segment_pages), direct_io_(direct_io) {
+  BUSTUB_ASSERT(segment_pages_ > 0, "a segment holds at least one page");
+  fds_.push_back(OpenSegment(0));
+}
+
+Tablespace::~Tablespace() {
+  for (int fd : fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+auto Tablespace::SegmentOf(page_id_t page_id) -> int {
+  BUSTUB_ASSERT(page_id >= 0, "invalid page id");
+  const size_t segment = static_cast<size_t>(page_id) / segment_pages_;
+  {
+    std::shared_lock<std::shared_mutex> lock(latch_);
+    if (segment < fds_.size() && fds_[segment] >= 0) {
+      return fds_[segment];
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(latch_);
+  if (segment >= fds_.size()) {
+    fds_.resize(segment + 1, -1);
+  }
+  if (fds_[segment] < 0) {
+    fds_[segment] = OpenSegment(segment);
+  }
+  return fds_[segment];
+}
+
+auto Tablespace::SegmentFileName(size_t segment) const -> std::string {
+  return segment == 0 ? db_file_ : db_file_ + "." + std::to_string(segment);
+}
+
+auto Tablespace::NumPages() const -> size_t {
+  size_t num_pages = 0;
+  struct stat stat_buf;
+  for (size_t segment = 0; stat(SegmentFileName(segment).c_str(), &stat_buf) == 0; segment++) {
+    num_pages = segment * segment_pages_ + (static_cast<size_t>(stat_buf.st_size) + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE;
+  }
+  return num_pages;
+}
+
+auto Tablespace::OpenSegment(size_t segment) -> int {
+  const std::string file_name = SegmentFileName(segment);
+  int fd = -1;
+  if (direct_io_) {
+    fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (fd < 0 && errno == EINVAL) {
+      // e.g. tmpfs. Aligned buffers keep working for a later segment that falls back on its own.
+      LOG_WARN("the file system does not support O_DIRECT, falling back to buffered I/O");
+      if (segment == 0) {
+        direct_io_ = false;
+      }
+    }
+  }
+  if (fd < 0) {
+    fd = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (fd < 0) {
+    throw Exception("can't open db file");
+  }
+
+  struct stat stat_buf;
+  if (enable_segment_preallocation && fstat(fd, &stat_buf) == 0 && stat_buf.st_size == 0) {
+    // only advice for the layout, pages past the end of a segment read as zeros either way
+    const auto segment_size = static_cast<off_t>(segment_pages_ * BUSTUB_PAGE_SIZE);
+    if (posix_fallocate(fd, 0, segment_size) != 0) {
+      LOG_WARN("cannot preallocate segment %s", file_name.c_str());
+    }
+  }
+  return fd;
+}
+
+}  // namespace bustub
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <string>
 
 #include "common/exception.h"
@@ -37,19 +38,28 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
+  for (int attempt = 0; attempt < BPLUSTREE_OPTIMISTIC_RESTARTS; attempt++) {
+    bool found;
+    if (GetValueOptimistic(key, result, &found) == OptimisticResult::SUCCESS) {
+      return found;
+    }
+  }
+
   /*
    * 查数据时，加读锁
    *
    *
    * */
   root_page_id_latch_.RLock();
-  auto buffer_leaf_page = FindLeaf(key, Operation::SEARCH, transaction);
-  auto bplus_leaf_page = reinterpret_cast<LeafPage *>(buffer_leaf_page->GetData());
+  if (IsEmpty()) {
+    root_page_id_latch_.RUnlock();
+    return false;
+  }
+  ReadPageGuard leaf_guard(buffer_pool_manager_, FindLeaf(key, Operation::SEARCH, transaction));
   ValueType v;
-  bool is_existed = bplus_leaf_page->Lookup(key, &v, comparator_);
+  bool is_existed = leaf_guard.As<LeafPage>()->Lookup(key, &v, comparator_);
   /*缓冲池解标记,查数据是不会弄脏数据的，只有写数据了才会dirty*/
-  buffer_leaf_page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(buffer_leaf_page->GetPageId(), false);
+  leaf_guard.Drop();
   if (!is_existed) {
     return false;
   }
@@ -69,142 +79,346 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  root_page_id_latch_.WLock();
-  transaction->AddIntoPageSet(nullptr);
-  if (IsEmpty()) {
-    StartNewTree(key, value);
-    ReleaseLatchFromQueue(transaction);
-    return true;
+  for (int attempt = 0; attempt < BPLUSTREE_OPTIMISTIC_RESTARTS; attempt++) {
+    bool inserted;
+    const OptimisticResult result = InsertOptimistic(key, value, &inserted);
+    if (result == OptimisticResult::SUCCESS) {
+      return inserted;
+    }
+    if (result == OptimisticResult::FALL_BACK) {
+      break;
+    }
+  }
+
+  root_page_id_latch_.RLock();
+  while (IsEmpty()) {
+    root_page_id_latch_.RUnlock();
+    root_page_id_latch_.WLock();
+    if (IsEmpty()) {
+      StartNewTree(key, value);
+      root_page_id_latch_.WUnlock();
+      return true;
+    }
+    root_page_id_latch_.WUnlock();
+    root_page_id_latch_.RLock();
   }
-  return InsertIntoLeaf(key, value, transaction);
+  const bool inserted = InsertIntoLeaf(key, value, transaction);
+  root_page_id_latch_.RUnlock();
+  return inserted;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
-  auto buffer_page = buffer_pool_manager_->NewPage(&root_page_id_);
-  if (buffer_page == nullptr) {
+  page_id_t root_page_id;
+  BasicPageGuard root_guard = buffer_pool_manager_->NewPageGuarded(&root_page_id);
+  if (!root_guard.IsValid()) {
     throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
   }
-  auto bplus_page = reinterpret_cast<LeafPage *>(buffer_page->GetData());
-  bplus_page->Init(root_page_id_, INVALID_PAGE_ID, leaf_max_size_);
+  auto bplus_page = root_guard.AsMut<LeafPage>();
+  bplus_page->Init(root_page_id, INVALID_PAGE_ID, leaf_max_size_);
   bplus_page->Insert(key, value, comparator_);
-  buffer_pool_manager_->UnpinPage(buffer_page->GetPageId(), true);
+  // optimistic descents follow the root as soon as it is set
+  root_page_id_ = root_page_id;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  auto buffer_page = FindLeaf(key, Operation::INSERT, transaction);
-  auto bplus_page = reinterpret_cast<LeafPage *>(buffer_page->GetData());
+  WritePageGuard leaf_guard(buffer_pool_manager_, FindLeaf(key, Operation::INSERT, transaction));
+  auto bplus_page = leaf_guard.As<LeafPage>();
 
   auto before_insert_size = bplus_page->GetSize();
   auto new_size = bplus_page->Insert(key, value, comparator_);
   /*查看叶子节点满没满*/
   /*1. 重复key*/
   if (new_size == before_insert_size) {
-    ReleaseLatchFromQueue(transaction);
-    buffer_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(buffer_page->GetPageId(), false);
     return false;
   }
+  leaf_guard.SetDirty();
   /*2. 没满，则直接插入*/
   if (new_size < leaf_max_size_) {
-    ReleaseLatchFromQueue(transaction);
-    buffer_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(buffer_page->GetPageId(), true);
     return true;
   }
   /*3. 满了，则先分裂*/
-  auto right_brother_bplus_page = Split(bplus_page);
-  /*forgot:先处理链表关联关系*/
-  right_brother_bplus_page->SetNextPageId(bplus_page->GetNextPageId());
-  bplus_page->SetNextPageId(right_brother_bplus_page->GetPageId());
+  WritePageGuard right_brother_guard;
+  auto right_brother_bplus_page = Split(bplus_page, &right_brother_guard);
 
   auto risen_key = right_brother_bplus_page->KeyAt(0);
-  InsertIntoParent(bplus_page, risen_key, right_brother_bplus_page, transaction);
-
-  ReleaseLatchFromQueue(transaction);
-  buffer_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(buffer_page->GetPageId(), true);
-  buffer_pool_manager_->UnpinPage(right_brother_bplus_page->GetPageId(), true);
+  if (bplus_page->IsRootPage()) {
+    InsertNewRoot(bplus_page, risen_key, right_brother_bplus_page);
+    return true;
+  }
+  // searches reach the new leaf through the right link until the parent learns of it, so the leaf is released first
+  const page_id_t parent_page_id = bplus_page->GetParentPageId();
+  const page_id_t right_brother_page_id = right_brother_bplus_page->GetPageId();
+  right_brother_guard.Drop();
+  leaf_guard.Drop();
+  InsertIntoParent(parent_page_id, risen_key, right_brother_page_id);
   return true;
 }
+
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {
-  if (old_node->IsRootPage()) {
-    auto page = buffer_pool_manager_->NewPage(&root_page_id_);
+void BPLUSTREE_TYPE::InsertNewRoot(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node) {
+  page_id_t root_page_id;
+  BasicPageGuard root_guard = buffer_pool_manager_->NewPageGuarded(&root_page_id, old_node->GetPageId());
 
-    if (page == nullptr) {
-      throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
-    }
+  if (!root_guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
+  }
 
-    auto *new_root = reinterpret_cast<InternalPage *>(page->GetData());
-    new_root->Init(root_page_id_, INVALID_PAGE_ID, internal_max_size_);
+  auto *new_root = root_guard.AsMut<InternalPage>();
+  new_root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
 
-    new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+  new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
 
-    old_node->SetParentPageId(new_root->GetPageId());
-    new_node->SetParentPageId(new_root->GetPageId());
+  old_node->SetParentPageId(new_root->GetPageId());
+  new_node->SetParentPageId(new_root->GetPageId());
+  // optimistic descents follow the root as soon as it is set, the new root is not latched
+  root_page_id_ = root_page_id;
 
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  root_guard.Drop();
 
-    UpdateRootPageId(0);
+  UpdateRootPageId(0);
+}
 
-    ReleaseLatchFromQueue(transaction);
-    return;
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(page_id_t parent_page_id, const KeyType &key, page_id_t child_page_id) {
+  WritePageGuard parent_guard = buffer_pool_manager_->FetchPageWrite(parent_page_id);
+  // the parent may have split since, moving the key range of the child to a right sibling
+  while (IsBeyondHighKey(parent_guard.As<BPlusTreePage>(), key)) {
+    WritePageGuard next_guard = buffer_pool_manager_->FetchPageWrite(parent_guard.As<BPlusTreePage>()->GetNextPageId());
+    parent_guard = std::move(next_guard);
+  }
+  auto *parent_node = parent_guard.AsMut<InternalPage>();
+  {
+    // the child got the parent of its left sibling, which may be stale by now
+    WritePageGuard child_guard = buffer_pool_manager_->FetchPageWrite(child_page_id);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(parent_node->GetPageId());
   }
-  auto parent_page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-  auto *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
 
   if (parent_node->GetSize() < internal_max_size_) {
-    parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-    ReleaseLatchFromQueue(transaction);
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
+    parent_node->Insert(key, child_page_id, comparator_);
     return;
   }
   auto *mem = new char[INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * (parent_node->GetSize() + 1)];
   auto *copy_parent_node = reinterpret_cast<InternalPage *>(mem);
-  std::memcpy(mem, parent_page->GetData(), INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * (parent_node->GetSize()));
-  copy_parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-  auto parent_new_sibling_node = Split(copy_parent_node);
+  std::memcpy(mem, parent_guard.GetData(), INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * (parent_node->GetSize()));
+  copy_parent_node->Insert(key, child_page_id, comparator_);
+  WritePageGuard parent_new_sibling_guard;
+  auto parent_new_sibling_node = Split(copy_parent_node, &parent_new_sibling_guard);
   KeyType new_key = parent_new_sibling_node->KeyAt(0);
-  std::memcpy(parent_page->GetData(), mem,
+  std::memcpy(parent_guard.GetDataMut(), mem,
               INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * copy_parent_node->GetMinSize());
-  InsertIntoParent(parent_node, new_key, parent_new_sibling_node, transaction);
-  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-  buffer_pool_manager_->UnpinPage(parent_new_sibling_node->GetPageId(), true);
   delete[] mem;
+
+  if (parent_node->IsRootPage()) {
+    InsertNewRoot(parent_node, new_key, parent_new_sibling_node);
+    return;
+  }
+  const page_id_t grandparent_page_id = parent_node->GetParentPageId();
+  const page_id_t parent_new_sibling_page_id = parent_new_sibling_node->GetPageId();
+  parent_new_sibling_guard.Drop();
+  parent_guard.Drop();
+  InsertIntoParent(grandparent_page_id, new_key, parent_new_sibling_page_id);
 }
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-auto BPLUSTREE_TYPE::Split(N *node) -> N * {
+auto BPLUSTREE_TYPE::Split(N *node, WritePageGuard *new_page) -> N * {
   page_id_t page_id;
-  auto page = buffer_pool_manager_->NewPage(&page_id);
+  // the new sibling is scanned right after node, so place it next to node on disk
+  BasicPageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&page_id, node->GetPageId());
 
-  if (page == nullptr) {
+  if (!new_guard.IsValid()) {
     throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
   }
+  // the moved children point to the new node before it is complete, an insert splitting one of them waits here
+  *new_page = new_guard.UpgradeWrite();
 
-  N *new_node = reinterpret_cast<N *>(page->GetData());
+  N *new_node = new_page->AsMut<N>();
   new_node->SetPageType(node->GetPageType());
 
   if (node->IsLeafPage()) {
     auto *leaf = reinterpret_cast<LeafPage *>(node);
     auto *new_leaf = reinterpret_cast<LeafPage *>(new_node);
 
-    new_leaf->Init(page->GetPageId(), node->GetParentPageId(), leaf_max_size_);
+    new_leaf->Init(page_id, node->GetParentPageId(), leaf_max_size_);
     leaf->MoveHalfTo(new_leaf);
   } else {
     auto *internal = reinterpret_cast<InternalPage *>(node);
     auto *new_internal = reinterpret_cast<InternalPage *>(new_node);
 
-    new_internal->Init(page->GetPageId(), node->GetParentPageId(), internal_max_size_);
+    new_internal->Init(page_id, node->GetParentPageId(), internal_max_size_);
     internal->MoveHalfTo(new_internal, buffer_pool_manager_);
   }
 
+  // the new node takes over the upper part of the key range of node, right of it on the same level
+  new_node->SetNextPageId(node->GetNextPageId());
+  new_node->SetHighKey(node->GetHighKey());
+  node->SetNextPageId(page_id);
+  node->SetHighKey(new_node->KeyAt(0));
+
   return new_node;
 }
 
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoad(const std::function<bool(KeyType *, ValueType *)> &next, Transaction *transaction) {
+  KeyType key;
+  ValueType value;
+  root_page_id_latch_.WLock();
+  if (!IsEmpty()) {
+    root_page_id_latch_.WUnlock();
+    while (next(&key, &value)) {
+      Insert(key, value, transaction);
+    }
+    return;
+  }
+
+  // a leaf splits when it fills up and an internal page when it overflows, the fill factor leaves room below that
+  const double fill_factor = bulk_load_fill_factor;
+  const int leaf_fill = std::clamp(static_cast<int>((leaf_max_size_ - 1) * fill_factor),
+                                   std::max(leaf_max_size_ / 2, 1), leaf_max_size_ - 1);
+  const int internal_fill = std::clamp(static_cast<int>(internal_max_size_ * fill_factor),
+                                       std::max((internal_max_size_ + 1) / 2, 2), internal_max_size_);
+
+  // every page built so far, nothing outside the tree points to them until the root is set
+  std::vector<page_id_t> built_pages;
+  try {
+    std::vector<std::pair<KeyType, page_id_t>> level;
+    {
+      BasicPageGuard prev_guard;
+      BasicPageGuard cur_guard;
+      LeafPage *leaf = nullptr;
+      while (next(&key, &value)) {
+        if (leaf != nullptr && comparator_(key, leaf->KeyAt(leaf->GetSize() - 1)) == 0) {
+          continue;
+        }
+        if (leaf == nullptr || leaf->GetSize() == leaf_fill) {
+          page_id_t page_id;
+          // the leaves are scanned left to right, so each is placed right after the one before it
+          BasicPageGuard new_guard = buffer_pool_manager_->NewPageGuarded(
+              &page_id, leaf == nullptr ? INVALID_PAGE_ID : leaf->GetPageId());
+          if (!new_guard.IsValid()) {
+            throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
+          }
+          built_pages.push_back(page_id);
+          auto *new_leaf = new_guard.AsMut<LeafPage>();
+          new_leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+          if (leaf != nullptr) {
+            leaf->SetNextPageId(page_id);
+            leaf->SetHighKey(key);
+          }
+          prev_guard = std::move(cur_guard);
+          cur_guard = std::move(new_guard);
+          leaf = new_leaf;
+          level.emplace_back(key, page_id);
+        }
+        leaf->Insert(key, value, comparator_);
+      }
+      if (level.empty()) {
+        root_page_id_latch_.WUnlock();
+        return;
+      }
+      BulkLoadBalanceLast<LeafPage>(&prev_guard, &cur_guard, &level, &built_pages);
+    }
+
+    while (level.size() > 1) {
+      level = BulkLoadInternalLevel(level, internal_fill, &built_pages);
+    }
+    // optimistic descents follow the root as soon as it is set
+    root_page_id_ = level.front().second;
+    UpdateRootPageId(0);
+  } catch (...) {
+    // the guards of the levels are gone, the half-built tree goes with them
+    root_page_id_ = INVALID_PAGE_ID;
+    for (auto page_id : built_pages) {
+      DeleteUnlinkedPage(page_id);
+    }
+    root_page_id_latch_.WUnlock();
+    throw;
+  }
+  root_page_id_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoadInternalLevel(const std::vector<std::pair<KeyType, page_id_t>> &children, int fill,
+                                           std::vector<page_id_t> *built_pages)
+    -> std::vector<std::pair<KeyType, page_id_t>> {
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  BasicPageGuard prev_guard;
+  BasicPageGuard cur_guard;
+  InternalPage *node = nullptr;
+  for (const auto &[key, child_page_id] : children) {
+    if (node == nullptr || node->GetSize() == fill) {
+      page_id_t page_id;
+      BasicPageGuard new_guard =
+          buffer_pool_manager_->NewPageGuarded(&page_id, node == nullptr ? INVALID_PAGE_ID : node->GetPageId());
+      if (!new_guard.IsValid()) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
+      }
+      built_pages->push_back(page_id);
+      auto *new_node = new_guard.AsMut<InternalPage>();
+      new_node->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+      if (node != nullptr) {
+        node->SetNextPageId(page_id);
+        node->SetHighKey(key);
+      }
+      prev_guard = std::move(cur_guard);
+      cur_guard = std::move(new_guard);
+      node = new_node;
+      level.emplace_back(key, page_id);
+    }
+    // key 0 is not used for the search, but keeps the separator like in a split page
+    node->SetKeyAt(node->GetSize(), key);
+    node->SetValueAt(node->GetSize(), child_page_id);
+    node->IncreaseSize(1);
+    BasicPageGuard child_guard = buffer_pool_manager_->FetchPageBasic(child_page_id);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(node->GetPageId());
+  }
+  BulkLoadBalanceLast<InternalPage>(&prev_guard, &cur_guard, &level, built_pages);
+  return level;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N>
+void BPLUSTREE_TYPE::BulkLoadBalanceLast(BasicPageGuard *prev_guard, BasicPageGuard *cur_guard,
+                                         std::vector<std::pair<KeyType, page_id_t>> *level,
+                                         std::vector<page_id_t> *built_pages) {
+  auto *node = cur_guard->AsMut<N>();
+  if (!prev_guard->IsValid() || node->GetSize() >= node->GetMinSize()) {
+    return;
+  }
+  auto *prev_node = prev_guard->AsMut<N>();
+  const int total = prev_node->GetSize() + node->GetSize();
+
+  if (total <= (node->IsLeafPage() ? leaf_max_size_ - 1 : internal_max_size_)) {
+    if (node->IsLeafPage()) {
+      reinterpret_cast<LeafPage *>(node)->MoveAllTo(reinterpret_cast<LeafPage *>(prev_node));
+    } else {
+      reinterpret_cast<InternalPage *>(node)->MoveAllTo(reinterpret_cast<InternalPage *>(prev_node), node->KeyAt(0),
+                                                        buffer_pool_manager_);
+    }
+    const page_id_t page_id = node->GetPageId();
+    cur_guard->Drop();
+    DeleteUnlinkedPage(page_id);
+    level->pop_back();
+    built_pages->pop_back();
+    return;
+  }
+
+  while (node->GetSize() < total / 2) {
+    if (node->IsLeafPage()) {
+      reinterpret_cast<LeafPage *>(prev_node)->MoveLastToFrontOf(reinterpret_cast<LeafPage *>(node));
+    } else {
+      reinterpret_cast<InternalPage *>(prev_node)->MoveLastToFrontOf(reinterpret_cast<InternalPage *>(node),
+                                                                      node->KeyAt(0), buffer_pool_manager_);
+    }
+  }
+  prev_node->SetHighKey(node->KeyAt(0));
+  level->back().first = node->KeyAt(0);
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -217,37 +431,56 @@ auto BPLUSTREE_TYPE::Split(N *node) -> N * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  // held until the end, no insert may be on its way up to a page this merges away
   root_page_id_latch_.WLock();
-  transaction->AddIntoPageSet(nullptr);  // nullptr means root_page_id_latch_
+  RetryPendingDeletes();
 
   if (IsEmpty()) {
-    ReleaseLatchFromQueue(transaction);
+    root_page_id_latch_.WUnlock();
     return;
   }
 
-  auto leaf_page = FindLeaf(key, Operation::DELETE, transaction);
-  auto *node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  WritePageGuard leaf_guard(buffer_pool_manager_, FindLeaf(key, Operation::DELETE, transaction));
+  auto *node = leaf_guard.As<LeafPage>();
 
   if (node->GetSize() == node->RemoveAndDeleteRecord(key, comparator_)) {
     ReleaseLatchFromQueue(transaction);
-    leaf_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+    leaf_guard.Drop();
+    root_page_id_latch_.WUnlock();
     return;
   }
+  leaf_guard.SetDirty();
 
   auto node_should_delete = CoalesceOrRedistribute(node, transaction);
-  leaf_page->WUnlatch();
 
   if (node_should_delete) {
     transaction->AddIntoDeletedPageSet(node->GetPageId());
   }
 
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
+  // deleting a page needs every pin on it gone
+  leaf_guard.Drop();
 
   std::for_each(transaction->GetDeletedPageSet()->begin(), transaction->GetDeletedPageSet()->end(),
-                [&bpm = buffer_pool_manager_](const page_id_t page_id) { bpm->DeletePage(page_id); });
+                [this](const page_id_t page_id) { DeleteUnlinkedPage(page_id); });
   transaction->GetDeletedPageSet()->clear();
+  root_page_id_latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeleteUnlinkedPage(page_id_t page_id) {
+  // an optimistic descent may still pin the page, it fails validation and lets go of it soon
+  if (!buffer_pool_manager_->DeletePage(page_id)) {
+    pending_deletes_.push_back(page_id);
+  }
 }
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RetryPendingDeletes() {
+  const auto freed = [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); };
+  pending_deletes_.erase(std::remove_if(pending_deletes_.begin(), pending_deletes_.end(), freed),
+                         pending_deletes_.end());
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool {
@@ -262,23 +495,19 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
     return false;
   }
 
-  auto parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  auto *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  // the parent is already write-latched by this transaction, only pin it again
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  auto *parent_node = parent_guard.AsMut<InternalPage>();
   auto idx = parent_node->ValueIndex(node->GetPageId());
 
   if (idx > 0) {
-    auto sibling_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(idx - 1));
-    sibling_page->WLatch();
-    N *sibling_node = reinterpret_cast<N *>(sibling_page->GetData());
+    WritePageGuard sibling_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(idx - 1));
+    N *sibling_node = sibling_guard.AsMut<N>();
 
     if (sibling_node->GetSize() > sibling_node->GetMinSize()) {
       Redistribute(sibling_node, node, parent_node, idx, true);
 
       ReleaseLatchFromQueue(transaction);
-
-      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      sibling_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
       return false;
     }
 
@@ -287,25 +516,17 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
     if (parent_node_should_delete) {
       transaction->AddIntoDeletedPageSet(parent_node->GetPageId());
     }
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-    sibling_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
     return true;
   }
 
   if (idx != parent_node->GetSize() - 1) {
-    auto sibling_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(idx + 1));
-    sibling_page->WLatch();
-    N *sibling_node = reinterpret_cast<N *>(sibling_page->GetData());
+    WritePageGuard sibling_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(idx + 1));
+    N *sibling_node = sibling_guard.AsMut<N>();
 
     if (sibling_node->GetSize() > sibling_node->GetMinSize()) {
       Redistribute(sibling_node, node, parent_node, idx, false);
 
       ReleaseLatchFromQueue(transaction);
-
-      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      sibling_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
       return false;
     }
 
@@ -315,9 +536,6 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
     if (parent_node_should_delete) {
       transaction->AddIntoDeletedPageSet(parent_node->GetPageId());
     }
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-    sibling_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
     return false;
   }
 
@@ -328,15 +546,13 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool {
   if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
     auto *root_node = reinterpret_cast<InternalPage *>(old_root_node);
-    auto only_child_page = buffer_pool_manager_->FetchPage(root_node->ValueAt(0));
-    auto *only_child_node = reinterpret_cast<BPlusTreePage *>(only_child_page->GetData());
+    BasicPageGuard only_child_guard = buffer_pool_manager_->FetchPageBasic(root_node->ValueAt(0));
+    auto *only_child_node = only_child_guard.AsMut<BPlusTreePage>();
     only_child_node->SetParentPageId(INVALID_PAGE_ID);
 
     root_page_id_ = only_child_node->GetPageId();
 
     UpdateRootPageId(0);
-
-    buffer_pool_manager_->UnpinPage(only_child_page->GetPageId(), true);
     return true;
   }
 
@@ -359,9 +575,11 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node,
     if (!from_prev) {
       neighbor_leaf_node->MoveFirstToEndOf(leaf_node);
       parent->SetKeyAt(index + 1, neighbor_leaf_node->KeyAt(0));
+      leaf_node->SetHighKey(neighbor_leaf_node->KeyAt(0));
     } else {
       neighbor_leaf_node->MoveLastToFrontOf(leaf_node);
       parent->SetKeyAt(index, leaf_node->KeyAt(0));
+      neighbor_leaf_node->SetHighKey(leaf_node->KeyAt(0));
     }
   } else {
     auto *internal_node = reinterpret_cast<InternalPage *>(node);
@@ -370,9 +588,11 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node,
     if (!from_prev) {
       neighbor_internal_node->MoveFirstToEndOf(internal_node, parent->KeyAt(index + 1), buffer_pool_manager_);
       parent->SetKeyAt(index + 1, neighbor_internal_node->KeyAt(0));
+      internal_node->SetHighKey(neighbor_internal_node->KeyAt(0));
     } else {
       neighbor_internal_node->MoveLastToFrontOf(internal_node, parent->KeyAt(index), buffer_pool_manager_);
       parent->SetKeyAt(index, internal_node->KeyAt(0));
+      neighbor_internal_node->SetHighKey(internal_node->KeyAt(0));
     }
   }
 }
@@ -415,68 +635,68 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, Operation operation, Transaction *transaction, bool leftMost,
                               bool rightMost) -> Page * {
-  assert(operation == Operation::SEARCH ? !(leftMost && rightMost) : transaction != nullptr);
+  assert(operation == Operation::DELETE ? transaction != nullptr : !(leftMost && rightMost));
 
   assert(root_page_id_ != INVALID_PAGE_ID);
   auto page = buffer_pool_manager_->FetchPage(root_page_id_);
   auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  if (operation == Operation::SEARCH) {
-    root_page_id_latch_.RUnlock();
-    page->RLatch();
-  } else {
-    page->WLatch();
-    // 这里要保证根不被替换，才能解锁
-    if (operation == Operation::DELETE && node->GetSize() > 2) {
-      ReleaseLatchFromQueue(transaction);
-    }
-    // 页节点没没装满，最大装n-1
-    if (operation == Operation::INSERT && node->IsLeafPage() && node->GetSize() < node->GetMaxSize() - 1) {
-      ReleaseLatchFromQueue(transaction);
+
+  if (operation != Operation::DELETE) {
+    // no remove runs while root_page_id_latch_ is shared, so pages only split: one latch at a time is enough, moving
+    // right past the splits the parents do not know of yet. Inserts latch the leaf exclusively.
+    bool exclusive = operation == Operation::INSERT && node->IsLeafPage();
+    exclusive ? page->WLatch() : page->RLatch();
+    while (true) {
+      page_id_t next_page_id;
+      if (rightMost ? node->GetNextPageId() != INVALID_PAGE_ID : !leftMost && IsBeyondHighKey(node, key)) {
+        next_page_id = node->GetNextPageId();
+      } else if (node->IsLeafPage()) {
+        break;
+      } else {
+        auto *i_node = reinterpret_cast<InternalPage *>(node);
+        if (leftMost) {
+          next_page_id = i_node->ValueAt(0);
+        } else if (rightMost) {
+          next_page_id = i_node->ValueAt(i_node->GetSize() - 1);
+        } else {
+          next_page_id = i_node->Lookup(key, comparator_);
+        }
+      }
+      assert(next_page_id > 0);
+
+      auto next_page = buffer_pool_manager_->FetchPage(next_page_id);
+      auto *next_node = reinterpret_cast<BPlusTreePage *>(next_page->GetData());
+      const bool next_exclusive = operation == Operation::INSERT && next_node->IsLeafPage();
+      next_exclusive ? next_page->WLatch() : next_page->RLatch();
+      exclusive ? page->WUnlatch() : page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+
+      page = next_page;
+      node = next_node;
+      exclusive = next_exclusive;
     }
-    if (operation == Operation::INSERT && !node->IsLeafPage() && node->GetSize() < node->GetMaxSize()) {
-      ReleaseLatchFromQueue(transaction);
+    if (operation == Operation::SEARCH) {
+      root_page_id_latch_.RUnlock();
     }
+    return page;
   }
 
+  page->WLatch();
+
   while (!node->IsLeafPage()) {
     auto *i_node = reinterpret_cast<InternalPage *>(node);
-
-    page_id_t child_node_page_id;
-    if (leftMost) {
-      child_node_page_id = i_node->ValueAt(0);
-    } else if (rightMost) {
-      child_node_page_id = i_node->ValueAt(i_node->GetSize() - 1);
-    } else {
-      child_node_page_id = i_node->Lookup(key, comparator_);
-    }
+    page_id_t child_node_page_id = i_node->Lookup(key, comparator_);
     assert(child_node_page_id > 0);
 
     auto child_page = buffer_pool_manager_->FetchPage(child_node_page_id);
     auto child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
 
-    if (operation == Operation::SEARCH) {
-      child_page->RLatch();
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    } else if (operation == Operation::INSERT) {
-      child_page->WLatch();
-      transaction->AddIntoPageSet(page);
+    child_page->WLatch();
+    transaction->AddIntoPageSet(page);
 
-      // child node is safe, release all locks on ancestors
-      if (child_node->IsLeafPage() && child_node->GetSize() < child_node->GetMaxSize() - 1) {
-        ReleaseLatchFromQueue(transaction);
-      }
-      if (!child_node->IsLeafPage() && child_node->GetSize() < child_node->GetMaxSize()) {
-        ReleaseLatchFromQueue(transaction);
-      }
-    } else if (operation == Operation::DELETE) {
-      child_page->WLatch();
-      transaction->AddIntoPageSet(page);
-
-      // child node is safe, release all locks on ancestors
-      if (child_node->GetSize() > child_node->GetMinSize()) {
-        ReleaseLatchFromQueue(transaction);
-      }
+    // child node is safe, release all locks on ancestors
+    if (child_node->GetSize() > child_node->GetMinSize()) {
+      ReleaseLatchFromQueue(transaction);
     }
 
     page = child_page;
@@ -486,6 +706,120 @@ auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, Operation operation, Transacti
   return page;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, Page **leaf, uint64_t *version) -> bool {
+  const page_id_t root_page_id = root_page_id_;
+  if (root_page_id == INVALID_PAGE_ID) {
+    *leaf = nullptr;
+    return true;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id);
+  if (page == nullptr) {
+    return false;
+  }
+  uint64_t page_version = page->GetVersion();
+  // the page may have stopped being the root before it was pinned, its data is not read before this holds
+  if (page_version % 2 == 1 || root_page_id_ != root_page_id) {
+    buffer_pool_manager_->UnpinPage(root_page_id, false);
+    return false;
+  }
+
+  while (true) {
+    // the next page is the right sibling if the page split since its parent pointed to it, else the child of key
+    const auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    page_id_t next_page_id;
+    if (IsBeyondHighKey(node, key)) {
+      next_page_id = node->GetNextPageId();
+    } else if (node->IsLeafPage()) {
+      break;
+    } else {
+      next_page_id = reinterpret_cast<const InternalPage *>(node)->Lookup(key, comparator_);
+    }
+    // a writer may have changed the page while it was read, then the next page id is garbage
+    if (!page->ValidateVersion(page_version)) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      return false;
+    }
+    Page *next_page = buffer_pool_manager_->FetchPage(next_page_id);
+    if (next_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      return false;
+    }
+    const uint64_t next_version = next_page->GetVersion();
+    // a writer unlinks a page under the latch of the parent or left sibling pointing to it, if that did not change
+    // the page was still in the tree when it was pinned. The pin only keeps its frame, a writer that unlinks the page
+    // afterwards latches it and moves its version on, and frees it once the pin is gone.
+    const bool valid = next_version % 2 == 0 && page->ValidateVersion(page_version);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (!valid) {
+      buffer_pool_manager_->UnpinPage(next_page_id, false);
+      return false;
+    }
+    page = next_page;
+    page_version = next_version;
+  }
+  *leaf = page;
+  *version = page_version;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValueOptimistic(const KeyType &key, std::vector<ValueType> *result, bool *found)
+    -> OptimisticResult {
+  Page *page;
+  uint64_t version;
+  if (!FindLeafOptimistic(key, &page, &version)) {
+    return OptimisticResult::RESTART;
+  }
+  if (page == nullptr) {
+    *found = false;
+    return OptimisticResult::SUCCESS;
+  }
+  page->RLatch();
+  ReadPageGuard leaf_guard(buffer_pool_manager_, page);
+  // under the read latch nobody writes the leaf, it only has to be the one the parent pointed to
+  if (!page->ValidateVersion(version)) {
+    return OptimisticResult::RESTART;
+  }
+  ValueType v;
+  *found = leaf_guard.As<LeafPage>()->Lookup(key, &v, comparator_);
+  if (*found) {
+    result->push_back(v);
+  }
+  return OptimisticResult::SUCCESS;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertOptimistic(const KeyType &key, const ValueType &value, bool *inserted)
+    -> OptimisticResult {
+  Page *page;
+  uint64_t version;
+  if (!FindLeafOptimistic(key, &page, &version)) {
+    return OptimisticResult::RESTART;
+  }
+  if (page == nullptr) {
+    // starting the tree sets the root
+    return OptimisticResult::FALL_BACK;
+  }
+  page->WLatch();
+  WritePageGuard leaf_guard(buffer_pool_manager_, page);
+  // taking the latch moved the version up by one, any more and another writer got in first
+  if (!page->ValidateVersion(version + 1)) {
+    return OptimisticResult::RESTART;
+  }
+  auto *leaf = leaf_guard.As<LeafPage>();
+  if (leaf->GetSize() >= leaf_max_size_ - 1) {
+    // the insert may split the leaf, which changes its ancestors
+    return OptimisticResult::FALL_BACK;
+  }
+  const int size = leaf->GetSize();
+  *inserted = leaf->Insert(key, value, comparator_) != size;
+  if (*inserted) {
+    leaf_guard.SetDirty();
+  }
+  return OptimisticResult::SUCCESS;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::Coalesce(N *neighbor_node, N *node,
@@ -534,13 +868,19 @@ void BPLUSTREE_TYPE::ReleaseLatchFromQueue(Transaction *transaction) {
   while (!transaction->GetPageSet()->empty()) {
     Page *page = transaction->GetPageSet()->front();
     transaction->GetPageSet()->pop_front();
-    if (page == nullptr) {
-      this->root_page_id_latch_.WUnlock();
-    } else {
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsBeyondHighKey(const BPlusTreePage *node, const KeyType &key) const -> bool {
+  if (node->GetNextPageId() == INVALID_PAGE_ID) {
+    return false;
   }
+  const KeyType high_key = node->IsLeafPage() ? reinterpret_cast<const LeafPage *>(node)->GetHighKey()
+                                              : reinterpret_cast<const InternalPage *>(node)->GetHighKey();
+  return comparator_(key, high_key) >= 0;
 }
 /*****************************************************************************
  * UTILITIES AND DEBUG
@@ -555,7 +895,9 @@ void BPLUSTREE_TYPE::ReleaseLatchFromQueue(Transaction *transaction) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  // inserts growing the tree run concurrently, each writes the newest root under the latch
+  WritePageGuard header_guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  auto *header_page = header_guard.AsMut<HeaderPage>();
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -563,7 +905,6 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
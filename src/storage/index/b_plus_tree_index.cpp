@@ -11,6 +11,8 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include "storage/index/external_sorter.h"
+
 namespace bustub {
 /*
  * Constructor
@@ -19,7 +21,8 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_),
+      buffer_pool_manager_(buffer_pool_manager) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
@@ -48,6 +51,45 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(const std::function<bool(Tuple *, RID *)> &next, Transaction *transaction) {
+  struct Entry {
+    KeyType key_;
+    /** Position of the entry in the input. */
+    uint64_t seq_;
+    RID rid_;
+  };
+  // The position breaks ties, so that the tree keeps the first entry of a repeated key. RIDs are not in table order
+  // once the pages of a table are no longer allocated in ascending order.
+  const auto less = [this](const Entry &lhs, const Entry &rhs) {
+    const int cmp = comparator_(lhs.key_, rhs.key_);
+    return cmp < 0 || (cmp == 0 && lhs.seq_ < rhs.seq_);
+  };
+  ExternalSorter<Entry, decltype(less)> sorter(buffer_pool_manager_, less);
+
+  Tuple key_tuple;
+  Entry entry;
+  entry.seq_ = 0;
+  while (next(&key_tuple, &entry.rid_)) {
+    entry.key_.SetFromKey(key_tuple);
+    sorter.Add(entry);
+    entry.seq_++;
+  }
+  sorter.Sort();
+
+  container_.BulkLoad(
+      [&sorter](KeyType *key, RID *rid) {
+        Entry sorted;
+        if (!sorter.Next(&sorted)) {
+          return false;
+        }
+        *key = sorted.key_;
+        *rid = sorted.rid_;
+        return true;
+      },
+      transaction);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
 
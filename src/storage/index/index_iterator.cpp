@@ -17,6 +17,10 @@ INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, Page *page, int index)
     : buffer_pool_manager_(bpm), page_(page), index_(index) {
   if (page != nullptr) {
     leaf_ = reinterpret_cast<LeafPage *>(page->GetData());
+    read_ahead_ = ReadAheadWindow(bpm, scan_prefetch_window, [](Page *leaf_page) {
+      return reinterpret_cast<LeafPage *>(leaf_page->GetData())->GetNextPageId();
+    });
+    read_ahead_.Advance(page->GetPageId(), leaf_->GetNextPageId());
   } else {
     leaf_ = nullptr;
   }
@@ -55,6 +59,7 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
     page_ = next_page;
     leaf_ = reinterpret_cast<LeafPage *>(page_->GetData());
     index_ = 0;
+    read_ahead_.Advance(page_->GetPageId(), leaf_->GetNextPageId());
   } else {
     index_++;
   }
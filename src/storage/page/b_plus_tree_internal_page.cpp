@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -30,6 +31,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id
   SetSize(0);
   SetPageId(page_id);
   SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
   SetMaxSize(max_size);
 }
 
@@ -46,6 +48,16 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { array_[index].first = key; }
 
+/*
+ * Helper methods to get/set the high key, only meaningful while the page has a
+ * right sibling
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const -> KeyType { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetHighKey(const KeyType &key) { high_key_ = key; }
+
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
@@ -64,8 +76,11 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const ->
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType {
+  // an optimistic reader may see a size a writer is changing, the search stays within the page even then, and the
+  // reader drops the result once the page version tells it so
+  const int size = std::clamp(GetSize(), 1, static_cast<int>(INTERNAL_PAGE_SIZE));
   int l = 1;
-  int r = GetSize() - 1;
+  int r = size - 1;
   while (l < r) {
     int mid = (l + r) / 2;
     if (comparator(array_[mid].first, key) >= 0) {
@@ -107,23 +122,48 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
   return GetSize();
 }
 
+/*
+ * Insert the separator key of a new child in key order. Unlike InsertNodeAfter
+ * this does not need the left sibling of the child in the page, which may still
+ * wait for its own separator.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator)
+    -> int {
+  auto *position =
+      std::upper_bound(array_ + 1, array_ + GetSize(), key,
+                       [&comparator](const auto &k, const auto &pair) { return comparator(k, pair.first) < 0; });
+  std::move_backward(position, array_ + GetSize(), array_ + GetSize() + 1);
+  *position = {key, value};
+  IncreaseSize(1);
+  return GetSize();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
                                                 BufferPoolManager *buffer_pool_manager) {
   int start_split_indx = GetMinSize();
   int original_size = GetSize();
   SetSize(start_split_indx);
-  recipient->CopyNFrom(array_ + start_split_indx, original_size - start_split_indx, buffer_pool_manager);
+  // a split runs next to inserters working on the children, which read their parent page id under their latch
+  recipient->CopyNFrom(array_ + start_split_indx, original_size - start_split_indx, buffer_pool_manager, true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager,
+                                               bool latch_children) {
   std::copy(items, items + size, array_ + GetSize());
 
   for (int i = 0; i < size; i++) {
     auto page = buffer_pool_manager->FetchPage(ValueAt(i + GetSize()));
     auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (latch_children) {
+      page->WLatch();
+    }
     node->SetParentPageId(GetPageId());
+    if (latch_children) {
+      page->WUnlatch();
+    }
     buffer_pool_manager->UnpinPage(page->GetPageId(), true);
   }
 
@@ -148,6 +188,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient,
                                                BufferPoolManager *buffer_pool_manager) {
   SetKeyAt(0, middle_key);
   recipient->CopyNFrom(array_, GetSize(), buffer_pool_manager);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
   SetSize(0);
 }
 
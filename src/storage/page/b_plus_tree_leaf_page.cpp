@@ -76,13 +76,14 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
   IncreaseSize(size);
 }
 /**
- * Helper methods to set/get next page id
+ * Helper methods to set/get the high key, only meaningful while there is a
+ * next page
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return next_page_id_; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const -> KeyType { return high_key_; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetHighKey(const KeyType &key) { high_key_ = key; }
 
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
@@ -162,6 +163,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
   recipient->CopyNFrom(array_, GetSize());
   recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
   SetSize(0);
 }
 
@@ -60,6 +60,12 @@ void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) { parent_page_id_
 auto BPlusTreePage::GetPageId() const -> page_id_t { return page_id_; }
 void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
 
+/*
+ * Helper methods to get/set the page id of the right sibling
+ */
+auto BPlusTreePage::GetNextPageId() const -> page_id_t { return next_page_id_; }
+void BPlusTreePage::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
 /*
  * Helper methods to set lsn
  */
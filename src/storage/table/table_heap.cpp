@@ -11,8 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <utility>
 
 #include "common/logger.h"
+#include "concurrency/occ_manager.h"
+#include "concurrency/version_store.h"
 #include "fmt/format.h"
 #include "storage/table/table_heap.h"
 
@@ -29,103 +32,139 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
                      Transaction *txn)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
   // Initialize the first table page.
-  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
-  BUSTUB_ASSERT(first_page != nullptr,
+  auto first_page_guard = buffer_pool_manager_->NewPageGuarded(&first_page_id_);
+  BUSTUB_ASSERT(first_page_guard.IsValid(),
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->Init(first_page_id_, BUSTUB_PAGE_SIZE, INVALID_LSN, log_manager_, txn);
-  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  first_page_guard.AsMut<TablePage>()->Init(first_page_id_, BUSTUB_PAGE_SIZE, INVALID_LSN, log_manager_, txn);
 }
 
 auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
+  if (RejectSnapshotWrite(txn)) {
+    return false;
+  }
   if (tuple.size_ + 32 > BUSTUB_PAGE_SIZE) {  // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  // Decided before the write, so that a snapshot beginning meanwhile waits for it or finds its undo record.
+  const bool keep_version = KeepsVersions(txn);
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  auto cur_guard = buffer_pool_manager_->FetchPageWrite(first_page_id_);
+  if (!cur_guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  cur_page->WLatch();
-
   // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
+  // Pages that turn out to be full are released without being marked dirty.
+  while (!cur_guard.As<TablePage>()->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
+    auto *cur_page = cur_guard.As<TablePage>();
     auto next_page_id = cur_page->GetNextPageId();
     // If the next page is a valid page,
     if (next_page_id != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      next_page->WLatch();
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
+      // Latch the next page before the assignment unlatches and unpins the current page.
+      auto next_guard = buffer_pool_manager_->FetchPageWrite(next_page_id);
+      if (!next_guard.IsValid()) {
+        txn->SetState(TransactionState::ABORTED);
+        return false;
+      }
+      cur_guard = std::move(next_guard);
     } else {
       // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
+      auto new_guard = buffer_pool_manager_->NewPageGuarded(&next_page_id, cur_page->GetTablePageId());
       // If we could not create a new page,
-      if (new_page == nullptr) {
+      if (!new_guard.IsValid()) {
         // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
         txn->SetState(TransactionState::ABORTED);
         return false;
       }
       // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, BUSTUB_PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
+      auto new_write_guard = new_guard.UpgradeWrite();
+      cur_guard.AsMut<TablePage>()->SetNextPageId(next_page_id);
+      new_write_guard.AsMut<TablePage>()->Init(next_page_id, BUSTUB_PAGE_SIZE, cur_page->GetTablePageId(), log_manager_,
+                                               txn);
+      cur_guard = std::move(new_write_guard);
     }
   }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+  // A snapshot that reads the page after the latch is released must find that the tuple did not exist before.
+  if (keep_version) {
+    txn->GetVersionStore()->AddUndo(*rid, txn->GetTransactionId(), false, Tuple{});
+  }
+  if (IsOptimistic(txn)) {
+    txn->GetOccManager()->MarkAbsent(*rid, txn->GetTransactionId());
+  } else {
+    BumpWord(*rid, txn);
+  }
+  cur_guard.SetDirty();
+  cur_guard.Drop();
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
   return true;
 }
 
 auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
+  if (RejectSnapshotWrite(txn)) {
+    return false;
+  }
+  if (IsOptimistic(txn) && txn->GetState() == TransactionState::GROWING) {
+    txn->GetOccWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
+    return true;
+  }
   // TODO(Amadou): remove empty page
+  const bool keeps_versions = KeepsVersions(txn);
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  // Otherwise, mark the tuple as deleted, keeping the tuple for snapshots.
+  Tuple old_tuple;
+  const bool keep_version = keeps_versions && guard.As<TablePage>()->ReadTuple(rid, &old_tuple);
+  if (guard.AsMut<TablePage>()->MarkDelete(rid, txn, lock_manager_, log_manager_) && keep_version) {
+    txn->GetVersionStore()->AddUndo(rid, txn->GetTransactionId(), true, old_tuple);
+  }
+  BumpWord(rid, txn);
+  guard.Drop();
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
   return true;
 }
 
 auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) -> bool {
+  if (RejectSnapshotWrite(txn)) {
+    return false;
+  }
+  if (IsOptimistic(txn) && txn->GetState() == TransactionState::GROWING) {
+    txn->GetOccWriteSet()->emplace_back(rid, WType::UPDATE, tuple, this);
+    return true;
+  }
+  const bool keep_version = KeepsVersions(txn);
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
-  page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  bool is_updated = guard.As<TablePage>()->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  // Rolling back an update, the transaction manager drops the version.
+  const bool is_forward = is_updated && txn->GetState() != TransactionState::ABORTED;
+  if (is_updated) {
+    guard.SetDirty();
+  }
+  if (is_forward && keep_version) {
+    txn->GetVersionStore()->AddUndo(rid, txn->GetTransactionId(), true, old_tuple);
+  }
+  if (is_updated) {
+    BumpWord(rid, txn);
+  }
+  guard.Drop();
   // Update the transaction's write set.
-  if (is_updated && txn->GetState() != TransactionState::ABORTED) {
+  if (is_forward) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
   }
   return is_updated;
@@ -133,47 +172,99 @@ auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
 
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
-  page->WLatch();
-  page->ApplyDelete(rid, txn, log_manager_);
+  guard.AsMut<TablePage>()->ApplyDelete(rid, txn, log_manager_);
+  BumpWord(rid, txn);
   /** Commented out to make compatible with p4; This is called only on commit or delete, which consequently unlocks the
    * tuple; so should be fine */
   // lock_manager_->Unlock(txn, rid);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page containing that RID.");
   // Rollback the delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  guard.AsMut<TablePage>()->RollbackDelete(rid, txn, log_manager_);
+  BumpWord(rid, txn);
 }
 
 auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock) -> bool {
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto guard = buffer_pool_manager_->FetchPageBasic(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Read the tuple from the page.
-  if (acquire_read_lock) {
-    page->RLatch();
+  if (!acquire_read_lock) {
+    return ReadTuple(guard.As<TablePage>(), rid, tuple, txn);
+  }
+  auto read_guard = guard.UpgradeRead();
+  return ReadTuple(read_guard.As<TablePage>(), rid, tuple, txn);
+}
+
+auto TableHeap::IsSnapshotRead(Transaction *txn) -> bool {
+  return txn != nullptr && txn->GetIsolationLevel() == IsolationLevel::SNAPSHOT_ISOLATION &&
+         txn->GetVersionStore() != nullptr;
+}
+
+auto TableHeap::KeepsVersions(Transaction *txn) -> bool {
+  return txn->GetVersionStore() != nullptr && txn->GetVersionStore()->KeepsVersions(txn);
+}
+
+auto TableHeap::IsOptimistic(Transaction *txn) -> bool {
+  return txn != nullptr && txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC && txn->GetOccManager() != nullptr;
+}
+
+void TableHeap::BumpWord(const RID &rid, Transaction *txn) {
+  if (txn->GetOccManager() != nullptr) {
+    txn->GetOccManager()->BumpWord(rid);
+  }
+}
+
+auto TableHeap::RejectSnapshotWrite(Transaction *txn) -> bool {
+  if (txn->GetIsolationLevel() != IsolationLevel::SNAPSHOT_ISOLATION) {
+    return false;
   }
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
-  if (acquire_read_lock) {
-    page->RUnlatch();
+  txn->SetState(TransactionState::ABORTED);
+  return true;
+}
+
+auto TableHeap::ReadTuple(TablePage *page, RID rid, Tuple *tuple, Transaction *txn) -> bool {
+  if (IsOptimistic(txn)) {
+    return ReadOptimistic(page, rid, tuple, txn);
+  }
+  if (!IsSnapshotRead(txn)) {
+    return page->GetTuple(rid, tuple, txn, lock_manager_);
+  }
+  // The page latch keeps writers from changing the tuple and its versions in between.
+  bool exists = page->ReadTuple(rid, tuple);
+  txn->GetVersionStore()->Resolve(rid, txn->GetReadTs(), &exists, tuple);
+  tuple->rid_ = rid;
+  return exists;
+}
+
+auto TableHeap::ReadOptimistic(TablePage *page, RID rid, Tuple *tuple, Transaction *txn) -> bool {
+  // the transaction reads its own buffered writes
+  auto *writes = txn->GetOccWriteSet();
+  for (auto write = writes->rbegin(); write != writes->rend(); ++write) {
+    if (write->rid_ == rid && write->table_ == this) {
+      if (write->wtype_ == WType::DELETE) {
+        return false;
+      }
+      *tuple = write->tuple_;
+      tuple->rid_ = rid;
+      return true;
+    }
   }
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  // A writer changes the tuple under the page latch while it holds the word locked, so the word and the tuple match.
+  const uint64_t word = txn->GetOccManager()->LoadWord(rid);
+  txn->GetOccReadSet()->emplace_back(rid, word);
+  return OccManager::IsVisible(word, txn->GetTransactionId()) && page->ReadTuple(rid, tuple);
 }
 
 auto TableHeap::Begin(Transaction *txn) -> TableIterator {
@@ -182,13 +273,10 @@ auto TableHeap::Begin(Transaction *txn) -> TableIterator {
   RID rid;
   auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-    page->RLatch();
+    auto guard = buffer_pool_manager_->FetchPageRead(page_id);
+    auto *page = guard.As<TablePage>();
     // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-    auto found_tuple = page->GetFirstTupleRid(&rid);
-    page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    if (found_tuple) {
+    if (page->GetFirstTupleRid(&rid, IsSnapshotRead(txn))) {
       break;
     }
     page_id = page->GetNextPageId();
@@ -20,10 +20,12 @@ namespace bustub {
 
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
     : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
-  if (rid.GetPageId() != INVALID_PAGE_ID) {
-    if (!table_heap_->GetTuple(tuple_->rid_, tuple_, txn_)) {
+  if (rid.GetPageId() != INVALID_PAGE_ID && !table_heap_->GetTuple(tuple_->rid_, tuple_, txn_)) {
+    if (!TableHeap::IsSnapshotRead(txn_) && !TableHeap::IsOptimistic(txn_)) {
       throw bustub::Exception("read non-existing tuple");
     }
+    // the transaction sees no tuple in the first slot
+    ++(*this);
   }
 }
 
@@ -42,31 +44,42 @@ auto TableIterator::operator++() -> TableIterator & {
   auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
   BUSTUB_ENSURE(cur_page != nullptr, "BPM full");  // all pages are pinned
 
+  // A snapshot also visits deleted tuples and empty slots, and skips the ones it sees no tuple in. An optimistic
+  // transaction skips the tuples it deleted, and the ones running transactions inserted.
+  const bool snapshot = TableHeap::IsSnapshotRead(txn_);
+  const bool skip_invisible = snapshot || TableHeap::IsOptimistic(txn_);
   cur_page->RLatch();
+  RID cur_rid = tuple_->rid_;
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
-        break;
+  while (true) {
+    if (!cur_page->GetNextTupleRid(cur_rid, &next_tuple_rid, snapshot)) {  // end of this page
+      while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
+        auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+        cur_page->RUnlatch();
+        buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+        cur_page = next_page;
+        cur_page->RLatch();
+        read_ahead_.Advance(cur_page->GetTablePageId(), cur_page->GetNextPageId());
+        if (cur_page->GetFirstTupleRid(&next_tuple_rid, snapshot)) {
+          break;
+        }
       }
     }
-  }
-  tuple_->rid_ = next_tuple_rid;
-
-  if (*this != table_heap_->End()) {
+    tuple_->rid_ = next_tuple_rid;
+    if (*this == table_heap_->End()) {
+      break;
+    }
     // DO NOT ACQUIRE READ LOCK twice in a single thread otherwise it may deadlock.
     // See https://users.rust-lang.org/t/how-bad-is-the-potential-deadlock-mentioned-in-rwlocks-document/67234
-    if (!table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, false)) {
+    if (table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, false)) {
+      break;
+    }
+    if (!skip_invisible) {
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       throw bustub::Exception("read non-existing tuple");
     }
+    cur_rid = next_tuple_rid;
   }
   // release until copy the tuple
   cur_page->RUnlatch();
@@ -74,6 +87,23 @@ auto TableIterator::operator++() -> TableIterator & {
   return *this;
 }
 
+void TableIterator::EnableReadAhead(size_t window) {
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  read_ahead_ = ReadAheadWindow(buffer_pool_manager, window, [](Page *page) {
+    return static_cast<TablePage *>(page)->GetNextPageId();
+  });
+  const page_id_t page_id = tuple_->rid_.GetPageId();
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id));
+  BUSTUB_ENSURE(cur_page != nullptr, "BPM full");
+  cur_page->RLatch();
+  read_ahead_.Advance(page_id, cur_page->GetNextPageId());
+  cur_page->RUnlatch();
+  buffer_pool_manager->UnpinPage(page_id, false);
+}
+
 auto TableIterator::operator++(int) -> TableIterator {
   TableIterator clone(*this);
   ++(*this);
@@ -0,0 +1,137 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include "buffer/arc_replacer.h"
+
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** Load a page into a frame the way the buffer pool does and leave it unpinned. */
+void Load(ARCReplacer *replacer, frame_id_t frame_id, page_id_t page_id) {
+  replacer->RecordAccess(frame_id);
+  replacer->RecordLoad(frame_id, page_id);
+  replacer->SetEvictable(frame_id, true);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer replacer(4);
+  for (frame_id_t f = 0; f < 4; f++) {
+    Load(&replacer, f, f);
+  }
+  ASSERT_EQ(4U, replacer.Size());
+
+  // frame 0 is used again after other pages were loaded and moves to T2. Frame 3 was just loaded, so its second
+  // access is correlated and it stays in T1.
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(3);
+
+  // T1 = [3, 2, 1] is above its target of 0, evict its LRU frames. Pages 1 and 2 go to B1.
+  frame_id_t value;
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_EQ(2U, replacer.Size());
+  ASSERT_EQ(0U, replacer.GetTarget());
+
+  // page 1 comes back from B1: T1 was too small, and the page goes to T2
+  Load(&replacer, 1, 1);
+  ASSERT_EQ(1U, replacer.GetTarget());
+
+  // T1 = [3] is at its target, evict from T2 = [1, 0]. Page 0 goes to B2.
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+
+  // page 0 comes back from B2: T2 was too small
+  Load(&replacer, 0, 0);
+  ASSERT_EQ(0U, replacer.GetTarget());
+  ASSERT_EQ(3U, replacer.Size());
+
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_FALSE(replacer.Evict(&value));
+}
+
+// NOLINTNEXTLINE
+TEST(ARCReplacerTest, PinnedFrameTest) {
+  ARCReplacer replacer(4);
+  for (frame_id_t f = 0; f < 3; f++) {
+    Load(&replacer, f, f);
+  }
+  replacer.SetEvictable(0, false);
+  ASSERT_EQ(2U, replacer.Size());
+  EXPECT_THROW(replacer.Remove(0), std::logic_error);
+
+  frame_id_t value;
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  replacer.Remove(2);
+  ASSERT_EQ(0U, replacer.Size());
+  ASSERT_FALSE(replacer.Evict(&value));
+
+  replacer.SetEvictable(0, true);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+}
+
+// NOLINTNEXTLINE
+TEST(ARCReplacerTest, ScanResistanceTest) {
+  const size_t num_frames = 16;
+  ARCReplacer replacer(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> frame_of_page;
+  std::vector<page_id_t> page_of_frame(num_frames, INVALID_PAGE_ID);
+  frame_id_t next_free = 0;
+  auto access = [&](page_id_t page_id) {
+    auto it = frame_of_page.find(page_id);
+    if (it != frame_of_page.end()) {
+      replacer.RecordAccess(it->second);
+      return;
+    }
+    frame_id_t frame_id = next_free;
+    if (static_cast<size_t>(next_free) < num_frames) {
+      next_free++;
+    } else {
+      ASSERT_TRUE(replacer.Evict(&frame_id));
+      frame_of_page.erase(page_of_frame[frame_id]);
+    }
+    frame_of_page[page_id] = frame_id;
+    page_of_frame[frame_id] = page_id;
+    Load(&replacer, frame_id, page_id);
+  };
+
+  // pages 0-3 are the hot inner pages of an index, mixed with lookups of pages that are never used again
+  page_id_t cold_page = 1000;
+  for (int round = 0; round < 200; round++) {
+    for (page_id_t hot = 0; hot < 4; hot++) {
+      access(hot);
+    }
+    access(cold_page++);
+  }
+  // a sequential scan touches each page once per tuple
+  for (int i = 0; i < 100; i++) {
+    for (int tuple = 0; tuple < 4; tuple++) {
+      access(cold_page);
+    }
+    cold_page++;
+  }
+  for (page_id_t hot = 0; hot < 4; hot++) {
+    EXPECT_EQ(1U, frame_of_page.count(hot)) << "hot page " << hot << " was evicted by the scan";
+  }
+}
+
+}  // namespace bustub
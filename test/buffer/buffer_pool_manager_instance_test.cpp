@@ -12,12 +12,23 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <cstdio>
+#include <mutex>  // NOLINT
 #include <random>
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/read_ahead_window.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_manager_uring.h"
 
 namespace bustub {
 
@@ -274,4 +285,436 @@ TEST(BufferPoolManagerInstanceTest, FetchPage) {
   delete disk_manager;
 }
 
+// Hits take the optimistic path while other threads keep evicting frames underneath them.
+void ConcurrentHitEvict(ReplacerType replacer_type) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_pages = 32;
+  const size_t num_threads = 4;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k, nullptr, replacer_type);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page-%d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      std::default_random_engine rng(tid);
+      // even threads mostly hit the first pages, odd threads scan everything and force evictions
+      std::uniform_int_distribution<size_t> pick(0, tid % 2 == 0 ? 3 : num_pages - 1);
+      for (int i = 0; i < 2000; i++) {
+        const page_id_t page_id = page_ids[pick(rng)];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ("page-" + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // every pin has been released, so every frame must be reusable again
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentHitEvictTest) {
+  for (auto replacer_type : {ReplacerType::LRUK, ReplacerType::HEAP_LRUK, ReplacerType::TWO_Q, ReplacerType::ARC,
+                             ReplacerType::CLOCK_PRO}) {
+    ConcurrentHitEvict(replacer_type);
+  }
+}
+
+// Counts the reads of every page, and holds reads of blocked_page_ until it is released.
+class BlockingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      reads_[page_id]++;
+      cv_.notify_all();
+      cv_.wait(lock, [&] { return page_id != blocked_page_; });
+    }
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  auto Reads(page_id_t page_id) -> int {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reads_[page_id];
+  }
+
+  // Wait until page_id has been read at least count times.
+  void WaitForReads(page_id_t page_id, int count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return reads_[page_id] >= count; });
+  }
+
+  void Block(page_id_t page_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocked_page_ = page_id;
+  }
+
+  void Release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocked_page_ = INVALID_PAGE_ID;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<page_id_t, int> reads_;
+  page_id_t blocked_page_{INVALID_PAGE_ID};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_pages = 16;
+
+  auto *disk_manager = new BlockingDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // the second half of the pages pushes the first half out of the pool
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page-%d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // prefetched pages are read once in the background, and fetching them afterwards is a hit
+  bpm->PrefetchPages({page_ids[0], page_ids[1], page_ids[2]});
+  for (size_t i = 0; i < 3; i++) {
+    disk_manager->WaitForReads(page_ids[i], 1);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page-" + std::to_string(page_ids[i])).c_str()));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    EXPECT_EQ(1, disk_manager->Reads(page_ids[i]));
+  }
+
+  // a fetch of a page whose prefetch is still reading waits for it instead of reading the page again
+  disk_manager->Block(page_ids[3]);
+  bpm->PrefetchPages({page_ids[3]});
+  disk_manager->WaitForReads(page_ids[3], 1);
+  std::atomic<bool> fetched{false};
+  std::thread fetcher([&] {
+    auto *page = bpm->FetchPage(page_ids[3]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page-" + std::to_string(page_ids[3])).c_str()));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[3], false));
+    fetched = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(fetched);
+  disk_manager->Release();
+  fetcher.join();
+  EXPECT_TRUE(fetched);
+  EXPECT_EQ(1, disk_manager->Reads(page_ids[3]));
+
+  // resident pages are skipped
+  bpm->PrefetchPages({page_ids[num_pages - 1], page_ids[4]});
+  disk_manager->WaitForReads(page_ids[4], 1);
+  auto *page = bpm->FetchPage(page_ids[4]);
+  ASSERT_NE(nullptr, page);
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[4], false));
+  EXPECT_EQ(1, disk_manager->Reads(page_ids[4]));
+  EXPECT_EQ(0, disk_manager->Reads(page_ids[num_pages - 1]));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ReadAheadTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 32;
+
+  auto *disk_manager = new BlockingDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // a chain of pages, each holding the id of the next one, whose first half is pushed out of the pool
+  std::vector<page_id_t> page_ids(num_pages);
+  Page *prev_page = nullptr;
+  for (size_t i = 0; i <= num_pages; i++) {
+    Page *page = nullptr;
+    if (i < num_pages) {
+      page = bpm->NewPage(&page_ids[i]);
+      ASSERT_NE(nullptr, page);
+    }
+    if (prev_page != nullptr) {
+      reinterpret_cast<page_id_t *>(prev_page->GetData())[0] = page == nullptr ? INVALID_PAGE_ID : page_ids[i];
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i - 1], true));
+    }
+    prev_page = page;
+  }
+
+  {
+    ReadAheadWindow read_ahead(bpm, 4, [](Page *page) { return reinterpret_cast<page_id_t *>(page->GetData())[0]; });
+
+    // the window starts filling in the background, the scan does not wait for the read it just queued
+    disk_manager->Block(page_ids[1]);
+    read_ahead.Advance(page_ids[0], page_ids[1]);
+    disk_manager->WaitForReads(page_ids[1], 1);
+    EXPECT_EQ(0, disk_manager->Reads(page_ids[2]));
+    disk_manager->Release();
+
+    // once the fill is done, the scan takes its pages over and keeps the window full
+    while (disk_manager->Reads(page_ids[5]) == 0) {
+      read_ahead.Advance(page_ids[1], page_ids[2]);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (size_t i = 1; i <= 5; i++) {
+      EXPECT_EQ(1, disk_manager->Reads(page_ids[i]));
+    }
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Counts the page writes made by threads other than the one that created it.
+class WriteCountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+    std::lock_guard<std::mutex> lock(mutex_);
+    (std::this_thread::get_id() == owner_ ? foreground_writes_ : background_writes_)++;
+    cv_.notify_all();
+  }
+
+  auto ForegroundWrites() -> int {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return foreground_writes_;
+  }
+
+  // Wait until other threads have written at least count pages.
+  void WaitForBackgroundWrites(int count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return background_writes_ >= count; });
+  }
+
+ private:
+  const std::thread::id owner_{std::this_thread::get_id()};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int foreground_writes_{0};
+  int background_writes_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundWriterTest) {
+  const size_t buffer_pool_size = 64;
+  // pool_size / 16 frames at the eviction end are kept clean
+  const size_t lookahead = 4;
+
+  for (auto type : {ReplacerType::LRUK, ReplacerType::HEAP_LRUK, ReplacerType::TWO_Q, ReplacerType::ARC,
+                    ReplacerType::CLOCK_PRO}) {
+    auto *disk_manager = new WriteCountingDiskManager();
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2, nullptr, type);
+
+    std::vector<page_id_t> page_ids;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page-%d", page_id);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids.push_back(page_id);
+    }
+
+    // once the next victims are clean, misses evict them without writing. Stopping the writer waits for it to
+    // finish its round, so it no longer pins any of them.
+    bpm->RunBackgroundWriter();
+    disk_manager->WaitForBackgroundWrites(lookahead);
+    bpm->StopBackgroundWriter();
+    for (size_t i = 0; i < lookahead; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(0, disk_manager->ForegroundWrites());
+
+    // pages written by the background writer read back intact
+    for (auto page_id : page_ids) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), ("page-" + std::to_string(page_id)).c_str()));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmStartTest) {
+  const std::string warm_start_file = "warm_start_test.warm";
+  remove(warm_start_file.c_str());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+
+  // with k = 1 the replacer is plain LRU, so the recency order is the order of the last accesses
+  auto *bpm = new BufferPoolManagerInstance(8, disk_manager, 1);
+  bpm->SetWarmStartFile(warm_start_file);
+  EXPECT_EQ(0U, bpm->WarmStart());
+  for (int i = 0; i < 12; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page-%d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // pages 4 to 11 are resident, touch them from 11 down to 4 and keep page 4 pinned
+  for (page_id_t page_id = 11; page_id >= 4; page_id--) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    if (page_id != 4) {
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+  bpm->DumpResidentPages();
+  ASSERT_TRUE(bpm->UnpinPage(4, false));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // a smaller pool reloads the most recently used pages, pinned ones included
+  bpm = new BufferPoolManagerInstance(4, disk_manager, 1);
+  bpm->SetWarmStartFile(warm_start_file);
+  EXPECT_EQ(4U, bpm->WarmStart());
+  std::set<page_id_t> resident;
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    auto &page = bpm->GetPages()[i];
+    resident.insert(page.GetPageId());
+    EXPECT_EQ("page-" + std::to_string(page.GetPageId()), page.GetData());
+    EXPECT_EQ(0, page.GetPinCount());
+  }
+  EXPECT_EQ(std::set<page_id_t>({4, 5, 6, 7}), resident);
+
+  // they are evicted in their old order, least recently used first
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  ASSERT_TRUE(bpm->UnpinPage(0, false));
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_NE(7, bpm->GetPages()[i].GetPageId());
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(warm_start_file.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmStartFreedPageTest) {
+  const std::string warm_start_file = "warm_start_freed_test.warm";
+  remove(warm_start_file.c_str());
+  auto *disk_manager = new DiskManagerUring("warm_start_freed_test.db", false);
+
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  bpm->SetWarmStartFile(warm_start_file);
+  for (int i = 0; i < 4; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // the dump is older than the delete, like a periodic dump or one before a crash
+  bpm->DumpResidentPages();
+  ASSERT_TRUE(bpm->DeletePage(2));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  bpm = new BufferPoolManagerInstance(4, disk_manager);
+  bpm->SetWarmStartFile(warm_start_file);
+  EXPECT_EQ(3U, bpm->WarmStart());
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_NE(2, bpm->GetPages()[i].GetPageId());
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(warm_start_file.c_str());
+  remove("warm_start_freed_test.db");
+  remove("warm_start_freed_test.db.fsm");
+  remove("warm_start_freed_test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FreedPageFetchedBackTest) {
+  auto *disk_manager = new DiskManagerUring("reuse_test.db", false);
+  auto *bpm = new BufferPoolManagerInstance(2, disk_manager);
+
+  // a page that was freed and then fetched back in, like an unlatched reader that lost a race does
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  ASSERT_EQ(0, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_TRUE(bpm->DeletePage(page_id));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // its id is handed out again, the page gets a single frame
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  ASSERT_EQ(0, page_id);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "LIVE DATA");
+  page_id_t other_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+  ASSERT_TRUE(bpm->UnpinPage(other_page_id, false));
+  EXPECT_EQ(page, bpm->FetchPage(page_id));
+  EXPECT_STREQ("LIVE DATA", page->GetData());
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+
+  // while the freed page stays pinned its id is skipped, and handed out once the pin is gone
+  ASSERT_TRUE(bpm->DeletePage(other_page_id));
+  ASSERT_NE(nullptr, bpm->FetchPage(other_page_id));
+  page_id_t new_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&new_page_id));
+  EXPECT_EQ(other_page_id + 1, new_page_id);
+  ASSERT_TRUE(bpm->UnpinPage(new_page_id, false));
+  ASSERT_TRUE(bpm->UnpinPage(other_page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&new_page_id));
+  EXPECT_EQ(other_page_id, new_page_id);
+  int num_frames = 0;
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    num_frames += bpm->GetPages()[i].GetPageId() == new_page_id ? 1 : 0;
+  }
+  EXPECT_EQ(1, num_frames);
+  ASSERT_TRUE(bpm->UnpinPage(new_page_id, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("reuse_test.db");
+  remove("reuse_test.db.fsm");
+  remove("reuse_test.log");
+}
+
 }  // namespace bustub
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_page_table_test.cpp
+//
+// Identification: test/buffer/concurrent_page_table_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/concurrent_page_table.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ConcurrentPageTableTest, SampleTest) {
+  ConcurrentPageTable table(4);
+  frame_id_t frame_id;
+
+  EXPECT_FALSE(table.Find(0, frame_id));
+  table.Insert(0, 3);
+  table.Insert(8, 1);
+  table.Insert(16, 2);
+  EXPECT_EQ(3U, table.Size());
+
+  ASSERT_TRUE(table.Find(0, frame_id));
+  EXPECT_EQ(3, frame_id);
+  ASSERT_TRUE(table.Find(16, frame_id));
+  EXPECT_EQ(2, frame_id);
+
+  // overwrite an existing mapping
+  table.Insert(8, 0);
+  ASSERT_TRUE(table.Find(8, frame_id));
+  EXPECT_EQ(0, frame_id);
+  EXPECT_EQ(3U, table.Size());
+
+  EXPECT_TRUE(table.Remove(8));
+  EXPECT_FALSE(table.Remove(8));
+  EXPECT_FALSE(table.Find(8, frame_id));
+  EXPECT_FALSE(table.Find(INVALID_PAGE_ID, frame_id));
+  EXPECT_EQ(2U, table.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(ConcurrentPageTableTest, ChurnTest) {
+  // Replace every entry many times over, so tombstones build up and force rehashing.
+  const size_t num_frames = 16;
+  ConcurrentPageTable table(num_frames);
+  for (size_t i = 0; i < num_frames; i++) {
+    table.Insert(static_cast<page_id_t>(i), static_cast<frame_id_t>(i));
+  }
+  for (page_id_t page_id = num_frames; page_id < 10000; page_id++) {
+    const auto frame_id = static_cast<frame_id_t>(page_id % num_frames);
+    ASSERT_TRUE(table.Remove(page_id - static_cast<page_id_t>(num_frames)));
+    table.Insert(page_id, frame_id);
+    ASSERT_EQ(num_frames, table.Size());
+  }
+  for (page_id_t page_id = 10000 - num_frames; page_id < 10000; page_id++) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(table.Find(page_id, frame_id));
+    EXPECT_EQ(page_id % static_cast<page_id_t>(num_frames), frame_id);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ConcurrentPageTableTest, ConcurrentReaderTest) {
+  // Lock-free readers must never see a page mapped to a frame it was never assigned to.
+  const size_t num_frames = 8;
+  ConcurrentPageTable table(num_frames);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 2; tid++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        for (page_id_t page_id = 0; page_id < 2000; page_id++) {
+          frame_id_t frame_id;
+          if (table.Find(page_id, frame_id)) {
+            ASSERT_EQ(page_id % static_cast<page_id_t>(num_frames), frame_id);
+          }
+        }
+      }
+    });
+  }
+
+  for (page_id_t page_id = 0; page_id < 2000; page_id++) {
+    if (page_id >= static_cast<page_id_t>(num_frames)) {
+      table.Remove(page_id - static_cast<page_id_t>(num_frames));
+    }
+    table.Insert(page_id, page_id % static_cast<page_id_t>(num_frames));
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+}  // namespace bustub
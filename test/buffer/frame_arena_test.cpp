@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, LayoutTest) {
+  const size_t num_frames = 10;
+  for (bool use_huge_pages : {false, true}) {
+    FrameArena arena(num_frames, use_huge_pages);
+    for (size_t i = 0; i < num_frames; i++) {
+      char *frame = arena.GetFrame(i);
+      EXPECT_EQ(arena.GetFrame(0) + i * BUSTUB_PAGE_SIZE, frame);
+      for (size_t j = 0; j < BUSTUB_PAGE_SIZE; j++) {
+        ASSERT_EQ(0, frame[j]);
+      }
+      memset(frame, static_cast<int>(i), BUSTUB_PAGE_SIZE);
+    }
+    EXPECT_EQ(num_frames - 1, static_cast<size_t>(arena.GetFrame(num_frames - 1)[BUSTUB_PAGE_SIZE - 1]));
+
+    // with or without reserved huge pages, the arena starts on a huge page boundary
+    if (use_huge_pages) {
+      EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % FrameArena::HUGE_PAGE_SIZE);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 8;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  enable_huge_page_frames = true;
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+  enable_huge_page_frames = false;
+
+  // the metadata of every frame is on its own cache lines
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(&bpm->GetPages()[i]) % BUSTUB_CACHE_LINE_SIZE);
+  }
+
+  // pages written through the arena survive eviction and come back from disk
+  for (int i = 0; i < static_cast<int>(buffer_pool_size) * 2; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (int i = 0; i < static_cast<int>(buffer_pool_size) * 2; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(i), page->GetData());
+    ASSERT_TRUE(bpm->UnpinPage(i, false));
+  }
+}
+
+}  // namespace bustub
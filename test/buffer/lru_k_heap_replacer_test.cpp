@@ -0,0 +1,157 @@
+/**
+ * lru_k_heap_replacer_test.cpp
+ */
+
+#include "buffer/lru_k_heap_replacer.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(HeapLRUKReplacerTest, SampleTest) {
+  HeapLRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: add six elements to the replacer. We have [1,2,3,4,5]. Frame 6 is non-evictable.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.RecordAccess(5);
+  lru_replacer.RecordAccess(6);
+  lru_replacer.SetEvictable(1, true);
+  lru_replacer.SetEvictable(2, true);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.SetEvictable(4, true);
+  lru_replacer.SetEvictable(5, true);
+  lru_replacer.SetEvictable(6, false);
+  ASSERT_EQ(5, lru_replacer.Size());
+
+  // Scenario: Insert access history for frame 1. Now frame 1 has two access histories.
+  // All other frames have max backward k-dist. The order of eviction is [2,3,4,5,1].
+  lru_replacer.RecordAccess(1);
+
+  // Scenario: Evict three pages from the replacer. Elements with max k-distance should be popped
+  // first based on LRU.
+  int value;
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(2, value);
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(3, value);
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(4, value);
+  ASSERT_EQ(2, lru_replacer.Size());
+
+  // Scenario: Now replacer has frames [5,1].
+  // Insert new frames 3, 4, and update access history for 5. We should end with [3,1,5,4]
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.RecordAccess(5);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.SetEvictable(4, true);
+  ASSERT_EQ(4, lru_replacer.Size());
+
+  // Scenario: continue looking for victims. We expect 3 to be evicted next.
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Set 6 to be evictable. 6 Should be evicted next since it has max backward k-dist.
+  lru_replacer.SetEvictable(6, true);
+  ASSERT_EQ(4, lru_replacer.Size());
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(6, value);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Now we have [1,5,4]. Continue looking for victims.
+  lru_replacer.SetEvictable(1, false);
+  ASSERT_EQ(2, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(5, value);
+  ASSERT_EQ(1, lru_replacer.Size());
+
+  // Update access history for 1. Now we have [4,1]. Next victim is 4.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(1, true);
+  ASSERT_EQ(2, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(value, 4);
+
+  ASSERT_EQ(1, lru_replacer.Size());
+
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(value, 1);
+  ASSERT_EQ(0, lru_replacer.Size());
+
+  // These operations should not modify size
+  ASSERT_EQ(false, lru_replacer.Evict(&value));
+  ASSERT_EQ(0, lru_replacer.Size());
+  lru_replacer.Remove(1);
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(HeapLRUKReplacerTest, RandomizedTest) {
+  // Compare against a brute-force LRU-K that keeps every access and scans all frames on eviction.
+  const size_t num_frames = 64;
+  const size_t k = 3;
+  HeapLRUKReplacer replacer(num_frames, k);
+
+  std::vector<std::vector<size_t>> history(num_frames);
+  std::vector<bool> evictable(num_frames, false);
+  size_t now = 0;
+  auto reference_victim = [&]() -> frame_id_t {
+    frame_id_t victim = -1;
+    bool victim_inf = false;
+    size_t victim_ts = std::numeric_limits<size_t>::max();
+    for (size_t f = 0; f < num_frames; f++) {
+      if (!evictable[f]) {
+        continue;
+      }
+      const bool inf = history[f].size() < k;
+      const size_t ts = inf ? history[f].front() : history[f][history[f].size() - k];
+      if (victim == -1 || (inf && !victim_inf) || (inf == victim_inf && ts < victim_ts)) {
+        victim = static_cast<frame_id_t>(f);
+        victim_inf = inf;
+        victim_ts = ts;
+      }
+    }
+    return victim;
+  };
+
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<frame_id_t> pick_frame(0, num_frames - 1);
+  std::uniform_int_distribution<int> pick_op(0, 9);
+  for (int i = 0; i < 20000; i++) {
+    const frame_id_t frame_id = pick_frame(gen);
+    const int op = pick_op(gen);
+    if (op < 6) {
+      replacer.RecordAccess(frame_id);
+      history[frame_id].push_back(now++);
+    } else if (op < 9) {
+      const bool set_evictable = op == 6 || op == 7;
+      replacer.SetEvictable(frame_id, set_evictable);
+      if (!history[frame_id].empty()) {
+        evictable[frame_id] = set_evictable;
+      }
+    } else {
+      const frame_id_t expected = reference_victim();
+      frame_id_t victim;
+      ASSERT_EQ(expected != -1, replacer.Evict(&victim));
+      if (expected != -1) {
+        ASSERT_EQ(expected, victim);
+        history[victim].clear();
+        evictable[victim] = false;
+      }
+    }
+    ASSERT_EQ(static_cast<size_t>(std::count(evictable.begin(), evictable.end(), true)), replacer.Size());
+  }
+}
+}  // namespace bustub
@@ -688,4 +688,56 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   remove("catalog_test.log");
 }
 
+// An index created over a table that has tuples already is loaded with them
+TEST(CatalogTest, CreateIndexOnPopulatedTable) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  const std::string table_name{"foobar"};
+  const std::string index_name{"index1"};
+
+  std::vector<Column> columns{};
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::INTEGER);
+  Schema schema{columns};
+  auto *table_info = catalog->CreateTable(txn.get(), table_name, schema);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, table_info);
+
+  // keys in descending order over more pages than the buffer pool holds, every key twice, B is the position
+  const int32_t num_tuples = 4000;
+  const int64_t num_keys = num_tuples / 2;
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < num_tuples; i++) {
+    Tuple tuple{{ValueFactory::GetBigIntValue(num_keys - 1 - i % num_keys), ValueFactory::GetIntegerValue(i)},
+                &schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn.get()));
+    rids.push_back(rid);
+  }
+
+  std::vector<Column> key_columns{};
+  std::vector<uint32_t> key_attrs{};
+  key_columns.emplace_back("A", TypeId::BIGINT);
+  key_attrs.emplace_back(0);
+  Schema key_schema{key_columns};
+  auto *index_info = catalog->CreateIndex<BigintKeyType, BigintValueType, BigintComparatorType>(
+      txn.get(), index_name, table_name, schema, key_schema, key_attrs, BIGINT_SIZE, BigintHashFunctionType{});
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+
+  // every key is found, at the first tuple in table order that has it
+  std::vector<RID> result;
+  for (int64_t key = 0; key < num_keys; key++) {
+    result.clear();
+    Tuple key_tuple{{ValueFactory::GetBigIntValue(key)}, &key_schema};
+    index_info->index_->ScanKey(key_tuple, &result, txn.get());
+    ASSERT_EQ(1, result.size()) << key;
+    EXPECT_EQ(rids[num_keys - 1 - key], result[0]) << key;
+  }
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
 }  // namespace bustub
@@ -21,7 +21,7 @@
       << "Test Failed Due to Time Out";
 
 namespace bustub {
-TEST(LockManagerDeadlockDetectionTest, DISABLED_EdgeTest) {
+TEST(LockManagerDeadlockDetectionTest, EdgeTest) {
   LockManager lock_mgr{};
 
   const int num_nodes = 100;
@@ -63,7 +63,7 @@ TEST(LockManagerDeadlockDetectionTest, DISABLED_EdgeTest) {
   }
 }
 
-TEST(LockManagerDeadlockDetectionTest, DISABLED_BasicDeadlockDetectionTest) {
+TEST(LockManagerDeadlockDetectionTest, BasicDeadlockDetectionTest) {
   LockManager lock_mgr{};
   TransactionManager txn_mgr{&lock_mgr};
 
@@ -122,4 +122,84 @@ TEST(LockManagerDeadlockDetectionTest, DISABLED_BasicDeadlockDetectionTest) {
   delete txn0;
   delete txn1;
 }
+
+TEST(LockManagerDeadlockDetectionTest, WoundWaitTest) {
+  LockManager lock_mgr{DeadlockPolicy::WOUND_WAIT};
+  TransactionManager txn_mgr{&lock_mgr};
+
+  table_oid_t toid{0};
+  RID rid0{0, 0};
+  RID rid1{1, 1};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  auto *txn2 = txn_mgr.Begin();
+  for (auto *txn : {txn0, txn1, txn2}) {
+    EXPECT_TRUE(lock_mgr.LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, toid));
+  }
+  EXPECT_TRUE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+
+  // the older txn0 wounds txn1, and waits until txn1 gives up its lock
+  std::thread t0([&] {
+    EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+    EXPECT_EQ(TransactionState::GROWING, txn0->GetState());
+  });
+  while (txn1->GetState() != TransactionState::ABORTED) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_FALSE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+  txn_mgr.Abort(txn1);
+  t0.join();
+
+  // the younger txn2 waits for txn0
+  std::thread t2([&] {
+    EXPECT_TRUE(lock_mgr.LockRow(txn2, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+    EXPECT_EQ(TransactionState::GROWING, txn2->GetState());
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(TransactionState::GROWING, txn0->GetState());
+  txn_mgr.Commit(txn0);
+  t2.join();
+  txn_mgr.Commit(txn2);
+
+  delete txn0;
+  delete txn1;
+  delete txn2;
+}
+
+TEST(LockManagerDeadlockDetectionTest, WaitDieTest) {
+  LockManager lock_mgr{DeadlockPolicy::WAIT_DIE};
+  TransactionManager txn_mgr{&lock_mgr};
+
+  table_oid_t toid{0};
+  RID rid0{0, 0};
+  RID rid1{1, 1};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  auto *txn2 = txn_mgr.Begin();
+  for (auto *txn : {txn0, txn1, txn2}) {
+    EXPECT_TRUE(lock_mgr.LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, toid));
+  }
+  EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+  EXPECT_TRUE(lock_mgr.LockRow(txn2, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+
+  // the younger txn1 dies instead of waiting for txn0
+  EXPECT_FALSE(lock_mgr.LockRow(txn1, LockManager::LockMode::SHARED, toid, rid0));
+  EXPECT_EQ(TransactionState::ABORTED, txn1->GetState());
+  txn_mgr.Abort(txn1);
+
+  // the older txn0 waits for txn2
+  std::thread t0([&] {
+    EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+    EXPECT_EQ(TransactionState::GROWING, txn0->GetState());
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(TransactionState::GROWING, txn2->GetState());
+  txn_mgr.Commit(txn2);
+  t0.join();
+  txn_mgr.Commit(txn0);
+
+  delete txn0;
+  delete txn1;
+  delete txn2;
+}
 }  // namespace bustub
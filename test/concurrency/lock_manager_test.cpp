@@ -4,6 +4,9 @@
 
 #include "concurrency/lock_manager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <random>
 #include <thread>  // NOLINT
 
@@ -109,7 +112,7 @@ void TableLockTest1() {
     delete txns[i];
   }
 }
-TEST(LockManagerTest, DISABLED_TableLockTest1) { TableLockTest1(); }  // NOLINT
+TEST(LockManagerTest, TableLockTest1) { TableLockTest1(); }  // NOLINT
 
 /** Upgrading single transaction from S -> X */
 void TableLockUpgradeTest1() {
@@ -134,7 +137,7 @@ void TableLockUpgradeTest1() {
 
   delete txn1;
 }
-TEST(LockManagerTest, DISABLED_TableLockUpgradeTest1) { TableLockUpgradeTest1(); }  // NOLINT
+TEST(LockManagerTest, TableLockUpgradeTest1) { TableLockUpgradeTest1(); }  // NOLINT
 
 void RowLockTest1() {
   LockManager lock_mgr{};
@@ -190,7 +193,7 @@ void RowLockTest1() {
     delete txns[i];
   }
 }
-TEST(LockManagerTest, DISABLED_RowLockTest1) { RowLockTest1(); }  // NOLINT
+TEST(LockManagerTest, RowLockTest1) { RowLockTest1(); }  // NOLINT
 
 void TwoPLTest1() {
   LockManager lock_mgr{};
@@ -239,6 +242,162 @@ void TwoPLTest1() {
   delete txn;
 }
 
-TEST(LockManagerTest, DISABLED_TwoPLTest1) { TwoPLTest1(); }  // NOLINT
+TEST(LockManagerTest, TwoPLTest1) { TwoPLTest1(); }  // NOLINT
+
+/** Many transactions update overlapping rows under X row locks, taken in row order so they never deadlock. */
+void RowLockContentionTest() {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+
+  const int num_threads = 8;
+  const int txns_per_thread = 200;
+  const int num_rows = 16;
+  const int rows_per_txn = 4;
+  std::vector<int> counters(num_rows, 0);
+
+  auto task = [&](int thread_id) {
+    std::mt19937 gen(thread_id);
+    std::uniform_int_distribution<int> row(0, num_rows - 1);
+    for (int i = 0; i < txns_per_thread; i++) {
+      auto *txn = txn_mgr.Begin();
+      EXPECT_TRUE(lock_mgr.LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+      std::vector<int> rows;
+      while (rows.size() < static_cast<size_t>(rows_per_txn)) {
+        const int r = row(gen);
+        if (std::find(rows.begin(), rows.end(), r) == rows.end()) {
+          rows.push_back(r);
+        }
+      }
+      std::sort(rows.begin(), rows.end());
+      for (int r : rows) {
+        EXPECT_TRUE(lock_mgr.LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{0, static_cast<uint32_t>(r)}));
+      }
+      CheckTxnRowLockSize(txn, oid, 0, rows_per_txn);
+      for (int r : rows) {
+        counters[r]++;
+      }
+      txn_mgr.Commit(txn);
+      CheckTxnRowLockSize(txn, oid, 0, 0);
+      CheckTableLockSizes(txn, 0, 0, 0, 0, 0);
+      delete txn;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int total = 0;
+  for (int counter : counters) {
+    total += counter;
+  }
+  EXPECT_EQ(num_threads * txns_per_thread * rows_per_txn, total);
+}
+TEST(LockManagerTest, RowLockContentionTest) { RowLockContentionTest(); }  // NOLINT
+
+/** A shared lock waits for an exclusive lock on the same row, and an unlock wakes it up. */
+void RowLockWaitTest() {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+  RID rid{0, 0};
+
+  auto *writer = txn_mgr.Begin();
+  auto *reader = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockTable(reader, LockManager::LockMode::INTENTION_SHARED, oid));
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid, rid));
+
+  std::atomic<bool> granted{false};
+  std::thread waiter([&] {
+    EXPECT_TRUE(lock_mgr.LockRow(reader, LockManager::LockMode::SHARED, oid, rid));
+    granted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(granted);
+
+  txn_mgr.Commit(writer);
+  waiter.join();
+  EXPECT_TRUE(granted);
+  EXPECT_TRUE(reader->IsRowSharedLocked(oid, rid));
+  txn_mgr.Commit(reader);
+
+  delete writer;
+  delete reader;
+}
+TEST(LockManagerTest, RowLockWaitTest) { RowLockWaitTest(); }  // NOLINT
+
+/** Row locks are traded for a table lock at the threshold, unless another transaction holds a lock in the way. */
+void LockEscalationTest() {
+  const size_t threshold = lock_escalation_threshold;
+  lock_escalation_threshold = 10;
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+  table_oid_t other_oid = 1;
+
+  auto *writer = txn_mgr.Begin();
+  auto *reader = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockTable(reader, LockManager::LockMode::INTENTION_SHARED, other_oid));
+  for (uint32_t i = 0; i < 9; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid, RID{0, i}));
+  }
+  CheckTxnRowLockSize(writer, oid, 0, 9);
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::SHARED, oid, RID{1, 0}));
+  CheckTxnRowLockSize(writer, oid, 0, 0);
+  CheckTableLockSizes(writer, 0, 1, 0, 0, 0);
+  EXPECT_TRUE(writer->IsTableEscalated(oid));
+  EXPECT_EQ(1U, lock_mgr.GetNumEscalations());
+
+  // the table lock covers the rows from now on
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid, RID{2, 0}));
+  CheckTxnRowLockSize(writer, oid, 0, 0);
+  EXPECT_TRUE(lock_mgr.UnlockRow(writer, oid, RID{0, 0}));
+  CheckGrowing(writer);
+
+  // shared row locks under IS become S, while the other transaction's IS is compatible
+  for (uint32_t i = 0; i < 10; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(reader, LockManager::LockMode::SHARED, other_oid, RID{0, i}));
+  }
+  CheckTxnRowLockSize(reader, other_oid, 0, 0);
+  CheckTableLockSizes(reader, 1, 0, 0, 0, 0);
+  EXPECT_EQ(2U, lock_mgr.GetNumEscalations());
+  txn_mgr.Commit(writer);
+  txn_mgr.Commit(reader);
+  CheckTableLockSizes(writer, 0, 0, 0, 0, 0);
+  EXPECT_FALSE(writer->IsTableEscalated(oid));
+
+  // an intention lock of another transaction keeps X from being granted, the row locks stay
+  auto *txn1 = txn_mgr.Begin();
+  auto *txn2 = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(txn1, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockTable(txn2, LockManager::LockMode::INTENTION_SHARED, oid));
+  for (uint32_t i = 0; i < 10; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, oid, RID{0, i}));
+  }
+  CheckTxnRowLockSize(txn1, oid, 0, 10);
+  CheckTableLockSizes(txn1, 0, 0, 0, 1, 0);
+  EXPECT_EQ(2U, lock_mgr.GetNumEscalations());
+  txn_mgr.Commit(txn2);
+  for (uint32_t i = 10; i < 20; i++) {
+    EXPECT_TRUE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, oid, RID{0, i}));
+  }
+  CheckTxnRowLockSize(txn1, oid, 0, 0);
+  CheckTableLockSizes(txn1, 0, 1, 0, 0, 0);
+  EXPECT_EQ(3U, lock_mgr.GetNumEscalations());
+  txn_mgr.Commit(txn1);
+
+  delete writer;
+  delete reader;
+  delete txn1;
+  delete txn2;
+  lock_escalation_threshold = threshold;
+}
+TEST(LockManagerTest, LockEscalationTest) { LockEscalationTest(); }  // NOLINT
 
 }  // namespace bustub
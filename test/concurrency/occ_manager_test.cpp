@@ -0,0 +1,226 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// occ_manager_test.cpp
+//
+// Identification: test/concurrency/occ_manager_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/occ_manager.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+class OccManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    disk_manager_ = std::make_unique<DiskManagerUnlimitedMemory>();
+    bpm_ = std::make_unique<BufferPoolManagerInstance>(50, disk_manager_.get());
+    lock_manager_ = std::make_unique<LockManager>();
+    txn_manager_ = std::make_unique<TransactionManager>(lock_manager_.get());
+    auto *txn = txn_manager_->Begin();
+    table_ = std::make_unique<TableHeap>(bpm_.get(), lock_manager_.get(), nullptr, txn);
+    for (int i = 0; i < NUM_TUPLES; i++) {
+      RID rid;
+      ASSERT_TRUE(table_->InsertTuple(MakeTuple(i), &rid, txn));
+      rids_.push_back(rid);
+    }
+    txn_manager_->Commit(txn);
+    delete txn;
+  }
+
+  auto MakeTuple(int32_t value) -> Tuple { return {{Value(TypeId::INTEGER, value)}, &schema_}; }
+
+  /** @return the value txn reads from the tuple at rid, -1 if it sees none */
+  auto Read(const RID &rid, Transaction *txn) -> int32_t {
+    Tuple tuple;
+    return table_->GetTuple(rid, &tuple, txn) ? tuple.GetValue(&schema_, 0).GetAs<int32_t>() : -1;
+  }
+
+  /** @return the values txn sees scanning the table */
+  auto Scan(Transaction *txn) -> std::vector<int32_t> {
+    std::vector<int32_t> values;
+    for (auto it = table_->Begin(txn); it != table_->End(); ++it) {
+      values.push_back(it->GetValue(&schema_, 0).GetAs<int32_t>());
+    }
+    return values;
+  }
+
+  auto BeginOptimistic() -> Transaction * { return txn_manager_->Begin(nullptr, IsolationLevel::OPTIMISTIC); }
+
+  static constexpr int NUM_TUPLES = 4;
+  Schema schema_{{Column{"v", TypeId::INTEGER}}};
+  std::unique_ptr<DiskManagerUnlimitedMemory> disk_manager_;
+  std::unique_ptr<BufferPoolManagerInstance> bpm_;
+  std::unique_ptr<LockManager> lock_manager_;
+  std::unique_ptr<TransactionManager> txn_manager_;
+  std::unique_ptr<TableHeap> table_;
+  std::vector<RID> rids_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(OccManagerTest, BufferedWriteTest) {
+  auto *writer = BeginOptimistic();
+  auto *reader = BeginOptimistic();
+
+  // the writes stay in the writer until it commits, the inserted tuple is hidden from the reader
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(100), rids_[0], writer));
+  ASSERT_TRUE(table_->MarkDelete(rids_[1], writer));
+  RID inserted_rid;
+  ASSERT_TRUE(table_->InsertTuple(MakeTuple(101), &inserted_rid, writer));
+  EXPECT_EQ((std::vector<int32_t>{100, 2, 3, 101}), Scan(writer));
+  EXPECT_EQ((std::vector<int32_t>{0, 1, 2, 3}), Scan(reader));
+
+  // the writer commits without taking a single lock
+  ASSERT_TRUE(txn_manager_->Commit(writer));
+  EXPECT_TRUE(writer->GetExclusiveTableLockSet()->empty());
+  EXPECT_TRUE(writer->GetIntentionExclusiveTableLockSet()->empty());
+  delete writer;
+
+  // the reader read what the writer changed, and fails validation
+  EXPECT_FALSE(txn_manager_->Commit(reader));
+  EXPECT_EQ(TransactionState::ABORTED, reader->GetState());
+  delete reader;
+
+  auto *later = BeginOptimistic();
+  EXPECT_EQ((std::vector<int32_t>{100, 2, 3, 101}), Scan(later));
+  ASSERT_TRUE(txn_manager_->Commit(later));
+  delete later;
+
+  // the commit timestamps come from the current epoch
+  EXPECT_GE(txn_manager_->GetOccManager()->LoadWord(rids_[0]) >> OccManager::WORD_SHIFT,
+            txn_manager_->GetOccManager()->GetEpoch() << 32);
+}
+
+// NOLINTNEXTLINE
+TEST_F(OccManagerTest, ValidationTest) {
+  // both read the tuple and update it, the second to commit lost its read
+  auto *first = BeginOptimistic();
+  auto *second = BeginOptimistic();
+  EXPECT_EQ(2, Read(rids_[2], first));
+  EXPECT_EQ(2, Read(rids_[2], second));
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(20), rids_[2], first));
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(21), rids_[2], second));
+  ASSERT_TRUE(txn_manager_->Commit(first));
+  EXPECT_FALSE(txn_manager_->Commit(second));
+  delete first;
+  delete second;
+
+  // blind writes never conflict, the last to commit wins
+  first = BeginOptimistic();
+  second = BeginOptimistic();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(30), rids_[3], first));
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(31), rids_[3], second));
+  ASSERT_TRUE(txn_manager_->Commit(second));
+  ASSERT_TRUE(txn_manager_->Commit(first));
+  delete first;
+  delete second;
+
+  // a transaction that does not validate its reads still invalidates the readers of what it writes
+  auto *reader = BeginOptimistic();
+  EXPECT_EQ(0, Read(rids_[0], reader));
+  auto *locking = txn_manager_->Begin();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(40), rids_[0], locking));
+  txn_manager_->Commit(locking);
+  delete locking;
+  EXPECT_FALSE(txn_manager_->Commit(reader));
+  delete reader;
+
+  Transaction check(1000);
+  EXPECT_EQ((std::vector<int32_t>{40, 1, 20, 30}), Scan(&check));
+}
+
+// NOLINTNEXTLINE
+TEST_F(OccManagerTest, ReclaimTest) {
+  auto *occ_manager = txn_manager_->GetOccManager();
+  auto *writer = BeginOptimistic();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(10), rids_[0], writer));
+  ASSERT_TRUE(txn_manager_->Commit(writer));
+  delete writer;
+  const uint64_t word = occ_manager->LoadWord(rids_[0]);
+  EXPECT_NE(0, word);
+  // the commit created the word of the tuple it wrote
+  EXPECT_EQ(1, occ_manager->GetNumWords());
+
+  // a running transaction keeps the words it may have read
+  auto *reader = BeginOptimistic();
+  EXPECT_EQ(10, Read(rids_[0], reader));
+  occ_manager->AdvanceEpoch();
+  occ_manager->AdvanceEpoch();
+  EXPECT_EQ(1, occ_manager->GetNumWords());
+  EXPECT_EQ(word, occ_manager->LoadWord(rids_[0]));
+  ASSERT_TRUE(txn_manager_->Commit(reader));
+  delete reader;
+
+  // once it ended, the word is reclaimed
+  occ_manager->AdvanceEpoch();
+  EXPECT_EQ(0, occ_manager->GetNumWords());
+
+  // the next read creates the word again, and a write to the tuple still invalidates the reader
+  reader = BeginOptimistic();
+  EXPECT_EQ(10, Read(rids_[0], reader));
+  EXPECT_EQ(1, occ_manager->GetNumWords());
+  auto *locking = txn_manager_->Begin();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(11), rids_[0], locking));
+  txn_manager_->Commit(locking);
+  delete locking;
+  EXPECT_FALSE(txn_manager_->Commit(reader));
+  delete reader;
+}
+
+// NOLINTNEXTLINE
+TEST_F(OccManagerTest, ConcurrentReclaimTest) {
+  auto *occ_manager = txn_manager_->GetOccManager();
+  const int num_threads = 4;
+  const int increments_per_thread = 200;
+
+  // increments of the tuples race with words being reclaimed, and none of them gets lost
+  std::atomic<bool> done{false};
+  std::thread reclaimer([&] {
+    while (!done) {
+      occ_manager->AdvanceEpoch();
+      std::this_thread::yield();
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      for (int committed = 0; committed < increments_per_thread;) {
+        auto *txn = BeginOptimistic();
+        const RID &rid = rids_[(committed + i) % 2];
+        const int32_t value = Read(rid, txn);
+        if (table_->UpdateTuple(MakeTuple(value + 1), rid, txn) && txn_manager_->Commit(txn)) {
+          committed++;
+        } else if (txn->GetState() != TransactionState::ABORTED) {
+          txn_manager_->Abort(txn);
+        }
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  reclaimer.join();
+
+  Transaction check(1000);
+  const auto values = Scan(&check);
+  EXPECT_EQ(num_threads * increments_per_thread + 1, values[0] + values[1]);
+}
+
+}  // namespace bustub
@@ -16,6 +16,7 @@
 #include <cstdio>
 #include <memory>
 #include <random>
+#include <shared_mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -48,7 +49,14 @@ class TransactionTest : public ::testing::Test {
   }
 
   // This function is called after every test.
-  void TearDown() override { remove("executor_test.db"); };
+  void TearDown() override {
+    // the instance writes its side files as it shuts down
+    bustub_.reset();
+    remove("executor_test.db");
+    remove("executor_test.db.fsm");
+    remove("executor_test.db.warm");
+    remove("executor_test.log");
+  };
 
   std::unique_ptr<BustubInstance> bustub_;
 };
@@ -67,6 +75,38 @@ void CheckTxnRowLockSize(Transaction *txn, size_t shared_size, size_t exclusive_
   EXPECT_EQ(txn->GetExclusiveLockSet()->size(), exclusive_size);
 }
 
+// NOLINTNEXTLINE
+TEST_F(TransactionTest, RecycleTest) {
+  auto *txn_manager = bustub_->txn_manager_;
+  auto *txn = txn_manager->Begin(nullptr, IsolationLevel::READ_COMMITTED);
+  const txn_id_t txn_id = txn->GetTransactionId();
+  EXPECT_EQ(txn, TransactionManager::GetTransaction(txn_id));
+  txn->GetSharedTableLockSet()->insert(0);
+  txn->GetWriteSet()->emplace_back(RID(0, 0), WType::INSERT, Tuple{}, nullptr);
+  txn->GetWriteSet()->clear();
+  txn->GetSharedTableLockSet()->clear();
+  txn_manager->Commit(txn);
+
+  // a finished transaction leaves the transaction map
+  {
+    std::shared_lock<std::shared_mutex> l(TransactionManager::txn_map_mutex);
+    EXPECT_EQ(0U, TransactionManager::txn_map.count(txn_id));
+  }
+
+  // the next transaction on this thread reuses it, reset and with the memory of its write set
+  const size_t capacity = txn->GetWriteSet()->capacity();
+  txn_manager->Recycle(txn);
+  auto *reused = txn_manager->Begin();
+  EXPECT_EQ(txn, reused);
+  EXPECT_NE(txn_id, reused->GetTransactionId());
+  EXPECT_EQ(TransactionState::GROWING, reused->GetState());
+  EXPECT_EQ(IsolationLevel::REPEATABLE_READ, reused->GetIsolationLevel());
+  EXPECT_TRUE(reused->GetSharedTableLockSet()->empty());
+  EXPECT_EQ(capacity, reused->GetWriteSet()->capacity());
+  txn_manager->Abort(reused);
+  txn_manager->Recycle(reused);
+}
+
 // NOLINTNEXTLINE
 TEST_F(TransactionTest, DISABLED_SimpleInsertRollbackTest) {
   // txn1: INSERT INTO empty_table2 VALUES (200, 20), (201, 21), (202, 22)
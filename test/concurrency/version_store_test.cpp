@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store_test.cpp
+//
+// Identification: test/concurrency/version_store_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/version_store.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+class VersionStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    disk_manager_ = std::make_unique<DiskManagerUnlimitedMemory>();
+    bpm_ = std::make_unique<BufferPoolManagerInstance>(50, disk_manager_.get());
+    lock_manager_ = std::make_unique<LockManager>();
+    txn_manager_ = std::make_unique<TransactionManager>(lock_manager_.get());
+    auto *txn = txn_manager_->Begin();
+    table_ = std::make_unique<TableHeap>(bpm_.get(), lock_manager_.get(), nullptr, txn);
+    for (int i = 0; i < NUM_TUPLES; i++) {
+      RID rid;
+      ASSERT_TRUE(table_->InsertTuple(MakeTuple(i), &rid, txn));
+      rids_.push_back(rid);
+    }
+    txn_manager_->Commit(txn);
+    delete txn;
+  }
+
+  auto MakeTuple(int32_t value) -> Tuple { return {{Value(TypeId::INTEGER, value)}, &schema_}; }
+
+  auto ValueOf(const Tuple &tuple) -> int32_t { return tuple.GetValue(&schema_, 0).GetAs<int32_t>(); }
+
+  /** @return the values txn sees scanning the table */
+  auto Scan(Transaction *txn) -> std::vector<int32_t> {
+    std::vector<int32_t> values;
+    for (auto it = table_->Begin(txn); it != table_->End(); ++it) {
+      values.push_back(ValueOf(*it));
+    }
+    return values;
+  }
+
+  static constexpr int NUM_TUPLES = 10;
+  Schema schema_{{Column{"v", TypeId::INTEGER}}};
+  std::unique_ptr<DiskManagerUnlimitedMemory> disk_manager_;
+  std::unique_ptr<BufferPoolManagerInstance> bpm_;
+  std::unique_ptr<LockManager> lock_manager_;
+  std::unique_ptr<TransactionManager> txn_manager_;
+  std::unique_ptr<TableHeap> table_;
+  std::vector<RID> rids_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(VersionStoreTest, SnapshotReadTest) {
+  // without a snapshot running, the inserts kept no versions
+  EXPECT_EQ(0U, txn_manager_->GetVersionStore()->GetNumVersions());
+
+  auto *snapshot = txn_manager_->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+
+  // a committed update, delete and insert, and an update that is still running
+  auto *writer = txn_manager_->Begin();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(100), rids_[0], writer));
+  ASSERT_TRUE(table_->MarkDelete(rids_[1], writer));
+  RID inserted_rid;
+  ASSERT_TRUE(table_->InsertTuple(MakeTuple(101), &inserted_rid, writer));
+  txn_manager_->Commit(writer);
+  delete writer;
+  auto *running = txn_manager_->Begin();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(102), rids_[2], running));
+
+  // the snapshot sees the table as it was when it began
+  Tuple tuple;
+  ASSERT_TRUE(table_->GetTuple(rids_[0], &tuple, snapshot));
+  EXPECT_EQ(0, ValueOf(tuple));
+  EXPECT_EQ(rids_[0], tuple.GetRid());
+  ASSERT_TRUE(table_->GetTuple(rids_[1], &tuple, snapshot));
+  EXPECT_EQ(1, ValueOf(tuple));
+  ASSERT_TRUE(table_->GetTuple(rids_[2], &tuple, snapshot));
+  EXPECT_EQ(2, ValueOf(tuple));
+  EXPECT_FALSE(table_->GetTuple(inserted_rid, &tuple, snapshot));
+  std::vector<int32_t> expected;
+  for (int i = 0; i < NUM_TUPLES; i++) {
+    expected.push_back(i);
+  }
+  EXPECT_EQ(expected, Scan(snapshot));
+
+  // a snapshot that began after the commit sees its writes, but not the running update
+  auto *later = txn_manager_->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+  expected.erase(expected.begin() + 1);
+  expected[0] = 100;
+  expected.push_back(101);
+  EXPECT_EQ(expected, Scan(later));
+  txn_manager_->Commit(later);
+  delete later;
+
+  // snapshots never write
+  EXPECT_FALSE(table_->MarkDelete(rids_[3], snapshot));
+  EXPECT_EQ(TransactionState::ABORTED, snapshot->GetState());
+  txn_manager_->Abort(snapshot);
+  delete snapshot;
+
+  // with the snapshots gone, only the running update keeps a version
+  EXPECT_EQ(3U, txn_manager_->CollectGarbage());
+  EXPECT_EQ(1U, txn_manager_->GetVersionStore()->GetNumVersions());
+  txn_manager_->Abort(running);
+  delete running;
+  EXPECT_EQ(0U, txn_manager_->GetVersionStore()->GetNumVersions());
+  Transaction reader(1000);
+  ASSERT_TRUE(table_->GetTuple(rids_[2], &tuple, &reader));
+  EXPECT_EQ(2, ValueOf(tuple));
+}
+
+// NOLINTNEXTLINE
+TEST_F(VersionStoreTest, GarbageCollectorTest) {
+  auto *snapshot = txn_manager_->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+  for (int round = 1; round <= 3; round++) {
+    auto *writer = txn_manager_->Begin();
+    for (int i = 0; i < NUM_TUPLES; i++) {
+      ASSERT_TRUE(table_->UpdateTuple(MakeTuple(round * 100 + i), rids_[i], writer));
+    }
+    txn_manager_->Commit(writer);
+    delete writer;
+  }
+
+  // the snapshot keeps every version alive, and still reads the first ones, the inserts took no commit timestamp
+  EXPECT_EQ(0, txn_manager_->GetWatermark());
+  EXPECT_EQ(0U, txn_manager_->CollectGarbage());
+  EXPECT_EQ(3U * NUM_TUPLES, txn_manager_->GetVersionStore()->GetNumVersions());
+  EXPECT_EQ(0, Scan(snapshot)[0]);
+  txn_manager_->Commit(snapshot);
+  delete snapshot;
+
+  // the garbage collector drops them once it is gone
+  txn_manager_->RunGarbageCollector();
+  for (int i = 0; i < 100 && txn_manager_->GetVersionStore()->GetNumVersions() > 0; i++) {
+    std::this_thread::sleep_for(version_gc_interval);
+  }
+  txn_manager_->StopGarbageCollector();
+  EXPECT_EQ(0U, txn_manager_->GetVersionStore()->GetNumVersions());
+  EXPECT_EQ(3, txn_manager_->GetWatermark());
+}
+
+// NOLINTNEXTLINE
+TEST_F(VersionStoreTest, UnversionedWriterTest) {
+  // without a snapshot running, a writer keeps no versions
+  auto *writer = txn_manager_->Begin();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(100), rids_[0], writer));
+  ASSERT_TRUE(table_->MarkDelete(rids_[1], writer));
+  EXPECT_EQ(0U, txn_manager_->GetVersionStore()->GetNumVersions());
+
+  // a snapshot that begins waits for it to end, and then sees its writes
+  std::atomic<bool> began{false};
+  Transaction *snapshot = nullptr;
+  std::thread snapshot_thread([&] {
+    snapshot = txn_manager_->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+    began = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(began);
+
+  // the writers that start meanwhile keep versions, and do not wait
+  auto *versioned = txn_manager_->Begin();
+  ASSERT_TRUE(table_->UpdateTuple(MakeTuple(102), rids_[2], versioned));
+  EXPECT_EQ(1U, txn_manager_->GetVersionStore()->GetNumVersions());
+
+  txn_manager_->Commit(writer);
+  delete writer;
+  snapshot_thread.join();
+  ASSERT_TRUE(began);
+  std::vector<int32_t> expected{100};
+  for (int i = 2; i < NUM_TUPLES; i++) {
+    expected.push_back(i);
+  }
+  EXPECT_EQ(expected, Scan(snapshot));
+
+  txn_manager_->Commit(versioned);
+  delete versioned;
+  EXPECT_EQ(expected, Scan(snapshot));
+  txn_manager_->Commit(snapshot);
+  delete snapshot;
+  EXPECT_EQ(1U, txn_manager_->CollectGarbage());
+  EXPECT_EQ(0U, txn_manager_->GetVersionStore()->GetNumVersions());
+}
+
+}  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// small_set_test.cpp
+//
+// Identification: test/container/small_set_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/small_set.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "common/rid.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(SmallSetTest, SpillTest) {
+  SmallSet<int, 4> set;
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(set.insert(i).second);
+  }
+  EXPECT_FALSE(set.insert(2).second);
+  EXPECT_FALSE(set.IsSpilled());
+
+  // the fifth key moves the keys to the heap, where they are still found
+  for (int i = 4; i < 100; i++) {
+    EXPECT_TRUE(set.insert(i).second);
+  }
+  EXPECT_TRUE(set.IsSpilled());
+  EXPECT_EQ(100U, set.size());
+  for (int i = 0; i < 100; i += 2) {
+    EXPECT_EQ(1U, set.erase(i));
+  }
+  EXPECT_EQ(0U, set.erase(0));
+  std::vector<int> keys(set.begin(), set.end());
+  std::sort(keys.begin(), keys.end());
+  ASSERT_EQ(50U, keys.size());
+  for (int i = 0; i < 50; i++) {
+    EXPECT_EQ(2 * i + 1, keys[i]);
+    EXPECT_EQ(1U, set.count(2 * i + 1));
+    EXPECT_EQ(0U, set.count(2 * i));
+  }
+
+  // clearing goes back to the inline keys
+  set.clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_FALSE(set.IsSpilled());
+  EXPECT_TRUE(set.insert(7).second);
+  EXPECT_EQ(7, *set.find(7));
+  EXPECT_EQ(set.end(), set.find(8));
+}
+
+// NOLINTNEXTLINE
+TEST(SmallSetTest, MapTest) {
+  SmallMap<int, SmallSet<RID, 2>, 2> map;
+  for (int table = 0; table < 3; table++) {
+    for (int slot = 0; slot < 3; slot++) {
+      map[table].insert(RID(table, slot));
+    }
+  }
+  EXPECT_TRUE(map.IsSpilled());
+  EXPECT_EQ(3U, map.size());
+  EXPECT_EQ(3U, map[1].size());
+  EXPECT_EQ(1U, map.find(2)->second.count(RID(2, 1)));
+
+  // erasing an entry moves the last one, with its set, into its place
+  EXPECT_EQ(1U, map.erase(0));
+  EXPECT_EQ(map.end(), map.find(0));
+  EXPECT_EQ(1U, map.find(2)->second.count(RID(2, 2)));
+  EXPECT_EQ(3U, map.find(2)->second.size());
+}
+
+}  // namespace bustub
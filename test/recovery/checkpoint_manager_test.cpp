@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checkpoint_manager_test.cpp
+//
+// Identification: test/recovery/checkpoint_manager_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/checkpoint_manager.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+class CheckpointManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override { RemoveFiles(); }
+
+  void TearDown() override { RemoveFiles(); }
+
+  static void RemoveFiles() {
+    remove("checkpoint_manager_test.db");
+    remove("checkpoint_manager_test.log");
+    remove("checkpoint_manager_test.log.master");
+  }
+
+  static auto MakeTuple(const Schema &schema, int32_t id, const std::string &payload) -> Tuple {
+    return {{Value(TypeId::INTEGER, id), Value(TypeId::VARCHAR, payload)}, &schema};
+  }
+
+  static auto SameTuple(const Tuple &lhs, const Tuple &rhs) -> bool {
+    return lhs.GetLength() == rhs.GetLength() && memcmp(lhs.GetData(), rhs.GetData(), lhs.GetLength()) == 0;
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(CheckpointManagerTest, FuzzyCheckpointTest) {
+  Schema schema({Column{"id", TypeId::INTEGER}, Column{"payload", TypeId::VARCHAR, 128}});
+  const std::string payload(100, 'x');
+  auto disk_manager = std::make_unique<DiskManager>("checkpoint_manager_test.db");
+  auto lock_manager = std::make_unique<LockManager>();
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  auto checkpoint_manager = std::make_unique<CheckpointManager>(txn_manager.get(), log_manager.get(), bpm.get());
+  log_manager->RunFlushThread();
+  EXPECT_EQ(0, disk_manager->ReadCheckpointOffset());
+
+  const int num_tuples = 200;
+  Transaction *txn = txn_manager->Begin();
+  auto table = std::make_unique<TableHeap>(bpm.get(), lock_manager.get(), log_manager.get(), txn);
+  const page_id_t first_page_id = table->GetFirstPageId();
+  std::vector<Tuple> tuples;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.push_back(MakeTuple(schema, i, payload));
+    ASSERT_TRUE(table->InsertTuple(tuples[i], &rids[i], txn));
+  }
+  txn_manager->Commit(txn);
+  delete txn;
+
+  // the first checkpoint writes out every page the committed transaction changed
+  EXPECT_FALSE(bpm->GetDirtyPageTable().empty());
+  checkpoint_manager->BeginCheckpoint();
+  checkpoint_manager->EndCheckpoint();
+  EXPECT_TRUE(bpm->GetDirtyPageTable().empty());
+
+  // the second one runs while a transaction is active, and does not keep others from beginning and committing
+  Transaction *straddler = txn_manager->Begin();
+  ASSERT_TRUE(table->MarkDelete(rids[10], straddler));
+  checkpoint_manager->BeginCheckpoint();
+  txn = txn_manager->Begin();
+  RID committed_rid;
+  const Tuple committed_tuple = MakeTuple(schema, num_tuples, payload);
+  ASSERT_TRUE(table->InsertTuple(committed_tuple, &committed_rid, txn));
+  txn_manager->Commit(txn);
+  delete txn;
+  checkpoint_manager->EndCheckpoint();
+
+  // recovery skips the part of the log before the running transaction began
+  EXPECT_GT(disk_manager->ReadCheckpointOffset(), 0);
+
+  // a transaction that began after the checkpoint is still running at the crash
+  Transaction *loser = txn_manager->Begin();
+  RID loser_rid;
+  ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, -2, payload), &loser_rid, loser));
+  ASSERT_TRUE(table->MarkDelete(rids[20], loser));
+  log_manager->StopFlushThread();
+
+  // crash, the buffer pool goes away without writing its pages
+  checkpoint_manager.reset();
+  table.reset();
+  bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager.get());
+  LogRecovery log_recovery(disk_manager.get(), bpm.get());
+  log_recovery.Redo();
+  log_recovery.Undo();
+  EXPECT_EQ(log_manager->GetNextLSN() - 1, log_recovery.GetMaxLSN());
+
+  table = std::make_unique<TableHeap>(bpm.get(), lock_manager.get(), log_manager.get(), first_page_id);
+  Transaction reader(1000);
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple;
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, &reader, false)) << i;
+    EXPECT_TRUE(SameTuple(tuples[i], tuple)) << i;
+  }
+  Tuple tuple;
+  ASSERT_TRUE(table->GetTuple(committed_rid, &tuple, &reader, false));
+  EXPECT_TRUE(SameTuple(committed_tuple, tuple));
+  EXPECT_FALSE(table->GetTuple(loser_rid, &tuple, &reader, false));
+  delete straddler;
+  delete loser;
+  disk_manager->ShutDown();
+}
+
+}  // namespace bustub
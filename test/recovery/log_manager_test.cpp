@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_manager.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+class LogManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    remove("log_manager_test.db");
+    remove("log_manager_test.log");
+  }
+
+  void TearDown() override {
+    remove("log_manager_test.db");
+    remove("log_manager_test.log");
+  }
+
+  /** @return the (lsn, type) of every record in the log file */
+  static auto ReadLogFile() -> std::vector<std::pair<lsn_t, LogRecordType>> {
+    std::ifstream log_file("log_manager_test.log", std::ios::binary);
+    std::vector<char> log((std::istreambuf_iterator<char>(log_file)), std::istreambuf_iterator<char>());
+    std::vector<std::pair<lsn_t, LogRecordType>> records;
+    for (size_t offset = 0; offset < log.size();) {
+      int32_t size;
+      lsn_t lsn;
+      LogRecordType type;
+      memcpy(&size, &log[offset], sizeof(int32_t));
+      memcpy(&lsn, &log[offset + 4], sizeof(lsn_t));
+      memcpy(&type, &log[offset + 16], sizeof(LogRecordType));
+      records.emplace_back(lsn, type);
+      offset += size;
+    }
+    return records;
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AppendTest) {
+  auto disk_manager = std::make_unique<DiskManager>("log_manager_test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  log_manager->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  EXPECT_EQ(0, log_manager->AppendLogRecord(&begin));
+  LogRecord new_page(0, 0, LogRecordType::NEWPAGE, INVALID_PAGE_ID, 3);
+  EXPECT_EQ(1, log_manager->AppendLogRecord(&new_page));
+  LogRecord commit(0, 1, LogRecordType::COMMIT);
+  EXPECT_EQ(2, log_manager->AppendLogRecord(&commit));
+  EXPECT_EQ(3, log_manager->GetNextLSN());
+
+  log_manager->Flush(2);
+  EXPECT_EQ(2, log_manager->GetPersistentLSN());
+  auto records = ReadLogFile();
+  ASSERT_EQ(3U, records.size());
+  EXPECT_EQ(LogRecordType::BEGIN, records[0].second);
+  EXPECT_EQ(LogRecordType::NEWPAGE, records[1].second);
+  EXPECT_EQ(2, records[2].first);
+  EXPECT_EQ(LogRecordType::COMMIT, records[2].second);
+
+  log_manager->StopFlushThread();
+  ASSERT_FALSE(enable_logging);
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, GroupCommitTest) {
+  auto disk_manager = std::make_unique<DiskManager>("log_manager_test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  log_manager->RunFlushThread();
+
+  // more log than fits into the log buffer, so appenders also have to swap buffers themselves
+  const int num_threads = 8;
+  const int num_txns = 300;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < num_txns; j++) {
+        const txn_id_t txn_id = i * num_txns + j;
+        LogRecord begin(txn_id, INVALID_LSN, LogRecordType::BEGIN);
+        const lsn_t begin_lsn = log_manager->AppendLogRecord(&begin);
+        LogRecord new_page(txn_id, begin_lsn, LogRecordType::NEWPAGE, INVALID_PAGE_ID, txn_id);
+        const lsn_t new_page_lsn = log_manager->AppendLogRecord(&new_page);
+        LogRecord commit(txn_id, new_page_lsn, LogRecordType::COMMIT);
+        const lsn_t commit_lsn = log_manager->AppendLogRecord(&commit);
+        log_manager->Flush(commit_lsn);
+        ASSERT_GE(log_manager->GetPersistentLSN(), commit_lsn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+
+  // every record made it to the log exactly once, and commits shared log writes
+  const int num_records = num_threads * num_txns * 3;
+  auto records = ReadLogFile();
+  ASSERT_EQ(static_cast<size_t>(num_records), records.size());
+  std::vector<bool> seen(num_records, false);
+  for (auto &[lsn, type] : records) {
+    ASSERT_LT(lsn, num_records);
+    EXPECT_FALSE(seen[lsn]);
+    seen[lsn] = true;
+  }
+  EXPECT_LE(disk_manager->GetNumFlushes(), num_threads * num_txns);
+  disk_manager->ShutDown();
+}
+
+}  // namespace bustub
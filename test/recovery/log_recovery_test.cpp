@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_recovery_test.cpp
+//
+// Identification: test/recovery/log_recovery_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_recovery.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+class LogRecoveryTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    remove("log_recovery_test.db");
+    remove("log_recovery_test.log");
+  }
+
+  void TearDown() override {
+    remove("log_recovery_test.db");
+    remove("log_recovery_test.log");
+  }
+
+  static auto MakeTuple(const Schema &schema, int32_t id, const std::string &payload) -> Tuple {
+    return {{Value(TypeId::INTEGER, id), Value(TypeId::VARCHAR, payload)}, &schema};
+  }
+
+  static auto SameTuple(const Tuple &lhs, const Tuple &rhs) -> bool {
+    return lhs.GetLength() == rhs.GetLength() && memcmp(lhs.GetData(), rhs.GetData(), lhs.GetLength()) == 0;
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, RedoUndoTest) {
+  Schema schema({Column{"id", TypeId::INTEGER}, Column{"payload", TypeId::VARCHAR, 128}});
+  const std::string payload(100, 'x');
+  auto disk_manager = std::make_unique<DiskManager>("log_recovery_test.db");
+  auto lock_manager = std::make_unique<LockManager>();
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager.get());
+  log_manager->RunFlushThread();
+
+  // a committed transaction fills a few pages
+  const int num_tuples = 200;
+  Transaction *txn = txn_manager->Begin();
+  auto table = std::make_unique<TableHeap>(bpm.get(), lock_manager.get(), log_manager.get(), txn);
+  const page_id_t first_page_id = table->GetFirstPageId();
+  std::vector<Tuple> tuples;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.push_back(MakeTuple(schema, i, payload));
+    ASSERT_TRUE(table->InsertTuple(tuples[i], &rids[i], txn));
+  }
+  txn_manager->Commit(txn);
+  delete txn;
+
+  // and one that is still running at the crash changes some of them
+  Transaction *loser = txn_manager->Begin();
+  RID loser_rid;
+  ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, -1, payload), &loser_rid, loser));
+  ASSERT_TRUE(table->MarkDelete(rids[0], loser));
+  ASSERT_TRUE(table->UpdateTuple(MakeTuple(schema, -2, "short"), rids[100], loser));
+  log_manager->StopFlushThread();
+
+  // crash, the buffer pool goes away without writing its pages
+  table.reset();
+  bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager.get());
+  LogRecovery log_recovery(disk_manager.get(), bpm.get());
+  log_recovery.Redo();
+  log_recovery.Undo();
+  EXPECT_EQ(log_manager->GetNextLSN() - 1, log_recovery.GetMaxLSN());
+
+  table = std::make_unique<TableHeap>(bpm.get(), lock_manager.get(), log_manager.get(), first_page_id);
+  Transaction reader(1000);
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple;
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, &reader, false)) << i;
+    EXPECT_TRUE(SameTuple(tuples[i], tuple)) << i;
+  }
+  Tuple tuple;
+  EXPECT_FALSE(table->GetTuple(loser_rid, &tuple, &reader, false));
+  delete loser;
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, DoubleCrashTest) {
+  Schema schema({Column{"id", TypeId::INTEGER}, Column{"payload", TypeId::VARCHAR, 128}});
+  const std::string payload(100, 'x');
+  auto disk_manager = std::make_unique<DiskManager>("log_recovery_test.db");
+  auto lock_manager = std::make_unique<LockManager>();
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager.get());
+  log_manager->RunFlushThread();
+
+  const int num_tuples = 200;
+  Transaction *txn = txn_manager->Begin();
+  auto table = std::make_unique<TableHeap>(bpm.get(), lock_manager.get(), log_manager.get(), txn);
+  const page_id_t first_page_id = table->GetFirstPageId();
+  std::vector<Tuple> tuples;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.push_back(MakeTuple(schema, i, payload));
+    ASSERT_TRUE(table->InsertTuple(tuples[i], &rids[i], txn));
+  }
+  txn_manager->Commit(txn);
+  delete txn;
+
+  // the loser was committing, it applied one of its deletes already
+  Transaction *loser = txn_manager->Begin();
+  RID loser_rid;
+  ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, -1, payload), &loser_rid, loser));
+  ASSERT_TRUE(table->MarkDelete(rids[0], loser));
+  ASSERT_TRUE(table->UpdateTuple(MakeTuple(schema, -2, "short"), rids[100], loser));
+  ASSERT_TRUE(table->MarkDelete(rids[150], loser));
+  table->ApplyDelete(rids[150], loser);
+  log_manager->StopFlushThread();
+  delete loser;
+
+  // first crash, recovery logs how it rolls the loser back
+  table.reset();
+  bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager.get());
+  {
+    LogRecovery log_recovery(disk_manager.get(), bpm.get(), log_manager.get());
+    log_recovery.Redo();
+    log_recovery.Undo();
+  }
+  log_manager->RunFlushThread();
+
+  // a transaction after recovery may take the slots the undo freed
+  table = std::make_unique<TableHeap>(bpm.get(), lock_manager.get(), log_manager.get(), first_page_id);
+  const Tuple after = MakeTuple(schema, -3, payload);
+  RID after_rid;
+  txn = txn_manager->Begin();
+  ASSERT_TRUE(table->InsertTuple(after, &after_rid, txn));
+  txn_manager->Commit(txn);
+  delete txn;
+  log_manager->StopFlushThread();
+
+  // second crash, the new log manager continues the log, the loser is not undone again
+  table.reset();
+  bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager.get());
+  log_manager = std::make_unique<LogManager>(disk_manager.get());
+  const lsn_t max_lsn = [&] {
+    LogRecovery log_recovery(disk_manager.get(), bpm.get(), log_manager.get());
+    log_recovery.Redo();
+    log_recovery.Undo();
+    return log_recovery.GetMaxLSN();
+  }();
+  EXPECT_EQ(max_lsn + 1, log_manager->GetNextLSN());
+
+  table = std::make_unique<TableHeap>(bpm.get(), lock_manager.get(), log_manager.get(), first_page_id);
+  Transaction reader(1000);
+  Tuple tuple;
+  int num_read = 0;
+  for (auto it = table->Begin(&reader); it != table->End(); ++it) {
+    num_read++;
+  }
+  EXPECT_EQ(num_tuples + 1, num_read);
+  ASSERT_TRUE(table->GetTuple(after_rid, &tuple, &reader, false));
+  EXPECT_TRUE(SameTuple(after, tuple));
+  for (int i = 0; i < num_tuples; i++) {
+    if (rids[i] == after_rid) {
+      continue;
+    }
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, &reader, false)) << i;
+    EXPECT_TRUE(SameTuple(tuples[i], tuple)) << i;
+  }
+  disk_manager->ShutDown();
+}
+
+}  // namespace bustub
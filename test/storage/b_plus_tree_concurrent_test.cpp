@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -333,4 +334,154 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, BLinkSplitTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  // the smallest nodes, so that splits on every level race with inserts landing on the pages they move
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // neighboring keys go to different threads
+  const int64_t num_keys = 4000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < num_keys; key++) {
+    keys.push_back(key);
+  }
+  LaunchParallelTest(8, InsertHelperSplit, &tree, keys, 8);
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids)) << key;
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key++;
+  }
+  EXPECT_EQ(num_keys, current_key);
+
+  // removes rely on the parent pointers and high keys the concurrent splits left behind
+  DeleteHelper(&tree, keys);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, OptimisticMixTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  // small nodes, so that the optimistic inserts and lookups run into splits and merges
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys first, the lower half is removed while the odd keys go in and the upper half is looked up
+  const int64_t num_keys = 2000;
+  std::vector<int64_t> keys;
+  std::vector<int64_t> remove_keys;
+  std::vector<int64_t> kept_keys;
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    keys.push_back(key);
+    (key < num_keys / 2 ? remove_keys : kept_keys).push_back(key);
+  }
+  InsertHelper(&tree, keys);
+  keys.clear();
+  for (int64_t key = 1; key < num_keys; key += 2) {
+    keys.push_back(key);
+  }
+
+  std::atomic<int64_t> missing{0};
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < 4; i++) {
+    threads.emplace_back(InsertHelperSplit, &tree, keys, 4, i);
+  }
+  for (uint64_t i = 0; i < 2; i++) {
+    threads.emplace_back(DeleteHelperSplit, &tree, remove_keys, 2, i);
+  }
+  for (int i = 0; i < 2; i++) {
+    threads.emplace_back([&] {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      for (int round = 0; round < 5; round++) {
+        for (auto key : kept_keys) {
+          rids.clear();
+          index_key.SetFromInteger(key);
+          if (!tree.GetValue(index_key, &rids) || rids[0].GetSlotNum() != key) {
+            missing++;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, missing);
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    const bool removed = key % 2 == 0 && key < num_keys / 2;
+    EXPECT_EQ(!removed, tree.GetValue(index_key, &rids)) << key;
+  }
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    size++;
+  }
+  EXPECT_EQ(num_keys - static_cast<int64_t>(remove_keys.size()), size);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeConcurrentTest, TornInternalSizeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+  Page page;
+  auto *internal = reinterpret_cast<InternalPage *>(page.GetData());
+  internal->Init(1);
+  GenericKey<8> index_key;
+  for (int i = 0; i < 4; i++) {
+    index_key.SetFromInteger(i * 10);
+    internal->SetKeyAt(i, index_key);
+    internal->SetValueAt(i, 100 + i);
+  }
+  internal->SetSize(4);
+  index_key.SetFromInteger(25);
+  EXPECT_EQ(102, internal->Lookup(index_key, comparator));
+
+  // an optimistic reader may see any size while a writer changes the page, the search stays within the page
+  for (int torn_size : {-7, 0, 1 << 20}) {
+    internal->SetSize(torn_size);
+    internal->Lookup(index_key, comparator);
+  }
+}
+
 }  // namespace bustub
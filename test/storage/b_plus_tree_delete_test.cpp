@@ -15,6 +15,7 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_uring.h"
 #include "storage/index/b_plus_tree.h"
 #include "test_util.h"  // NOLINT
 
@@ -163,4 +164,72 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+TEST(BPlusTreeTests, PinnedDeleteTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  remove("test.db");
+  remove("test.db.fsm");
+  // the free space map hands out the lowest free page ids, so a page that is not freed leaves a gap in them
+  auto *disk_manager = new DiskManagerUring("test.db", false);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  auto *transaction = new Transaction(0);
+
+  // two leaves under a root
+  for (int64_t key = 1; key <= 3; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, key), transaction));
+  }
+  const page_id_t root_page_id = tree.GetRootPageId();
+  auto *root = reinterpret_cast<BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>> *>(
+      bpm->FetchPage(root_page_id)->GetData());
+  ASSERT_FALSE(root->IsLeafPage());
+  ASSERT_EQ(2, root->GetSize());
+  const page_id_t right_leaf_page_id = root->ValueAt(1);
+  bpm->UnpinPage(root_page_id, false);
+
+  // a descent still pins the right leaf while the removes merge it away, so it is freed later
+  auto *right_leaf = reinterpret_cast<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(
+      bpm->FetchPage(right_leaf_page_id)->GetData());
+  std::vector<GenericKey<8>> right_keys;
+  for (int i = 0; i < right_leaf->GetSize(); i++) {
+    right_keys.push_back(right_leaf->KeyAt(i));
+  }
+  for (const auto &key : right_keys) {
+    tree.Remove(key, transaction);
+  }
+  EXPECT_NE(root_page_id, tree.GetRootPageId());
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(root_page_id, page_id);
+  bpm->UnpinPage(page_id, false);
+
+  // the next remove frees it once the pin is gone, even if it finds nothing to remove
+  bpm->UnpinPage(right_leaf_page_id, false);
+  index_key.SetFromInteger(100);
+  tree.Remove(index_key, transaction);
+  page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(right_leaf_page_id, page_id);
+  bpm->UnpinPage(page_id, false);
+
+  index_key.SetFromInteger(1);
+  std::vector<RID> rids;
+  EXPECT_TRUE(tree.GetValue(index_key, &rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.db.fsm");
+  remove("test.log");
+}
+
 }  // namespace bustub
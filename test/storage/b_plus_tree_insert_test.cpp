@@ -15,6 +15,7 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_uring.h"
 #include "storage/index/b_plus_tree.h"
 #include "test_util.h"  // NOLINT
 
@@ -195,4 +196,130 @@ TEST(BPlusTreeTests, DISABLED_InsertTest3) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 16, 16);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // 13 keys fill a leaf, the one left over is balanced with the leaf before it; key 100 comes twice, the second time
+  // with a different value
+  const int64_t num_keys = 13 * 400 + 1;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < num_keys; key++) {
+    keys.push_back(key);
+  }
+  keys.insert(keys.begin() + 100, 100);
+  size_t next = 0;
+  tree.BulkLoad(
+      [&](GenericKey<8> *key, RID *value) {
+        if (next == keys.size()) {
+          return false;
+        }
+        key->SetFromInteger(keys[next]);
+        value->Set(next == 101 ? 1 : 0, keys[next]);
+        next++;
+        return true;
+      },
+      transaction);
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids)) << key;
+    ASSERT_EQ(1, rids.size());
+    // the first of the repeated entries is kept
+    EXPECT_EQ(RID(0, key), rids[0]);
+  }
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key++;
+  }
+  EXPECT_EQ(num_keys, current_key);
+
+  // the loaded pages take inserts and removes like split ones, and keep their size bounds through them
+  for (int64_t key = num_keys; key < num_keys + 1000; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  for (int64_t key = 0; key < num_keys + 1000; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BulkLoadFailureTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  remove("test.db");
+  remove("test.db.fsm");
+  // the free space map hands out the lowest free page ids, so a leaked page leaves a gap in them
+  auto *disk_manager = new DiskManagerUring("test.db", false);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 16, 16);
+  GenericKey<8> index_key;
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // the input fails after enough keys for two levels of pages
+  int64_t next = 0;
+  const auto failing_input = [&](GenericKey<8> *key, RID *value) {
+    if (next == 3000) {
+      throw Exception("input failed");
+    }
+    key->SetFromInteger(next);
+    value->Set(0, next);
+    next++;
+    return true;
+  };
+  EXPECT_THROW(tree.BulkLoad(failing_input), Exception);
+
+  // the tree stays empty and takes inserts, so its root latch was released, and the built pages were deleted
+  EXPECT_TRUE(tree.IsEmpty());
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(HEADER_PAGE_ID + 1, page_id);
+  bpm->UnpinPage(page_id, false);
+  bpm->DeletePage(page_id);
+  index_key.SetFromInteger(7);
+  EXPECT_TRUE(tree.Insert(index_key, RID(0, 7)));
+  std::vector<RID> rids;
+  EXPECT_TRUE(tree.GetValue(index_key, &rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.db.fsm");
+  remove("test.log");
+}
+
 }  // namespace bustub
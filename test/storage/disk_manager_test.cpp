@@ -10,11 +10,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_uring.h"
 
 namespace bustub {
 
@@ -23,12 +34,14 @@ class DiskManagerTest : public ::testing::Test {
   // This function is called before every test.
   void SetUp() override {
     remove("test.db");
+    remove("test.db.fsm");
     remove("test.log");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
+    remove("test.db.fsm");
     remove("test.log");
   };
 };
@@ -55,6 +68,189 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeOffsetTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // past 2 GiB, the file is sparse so this does not take the space
+  const page_id_t page_id = 600000;
+  dm.WritePage(page_id, data);
+  dm.ReadPage(page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SegmentTest) {
+  const size_t segment_pages = 4;
+  const int num_pages = 10;
+  std::vector<char> buf(num_pages * BUSTUB_PAGE_SIZE);
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  {
+    auto dm = DiskManagerUring("test.db", false, segment_pages);
+    for (int i = 0; i < num_pages; i++) {
+      std::snprintf(data, sizeof(data), "page %d", i);
+      dm.WritePage(i, data);
+    }
+
+    // a run across segment boundaries reads from every segment it touches
+    dm.ReadPages(2, 7, buf.data());
+    for (int i = 0; i < 7; i++) {
+      EXPECT_EQ("page " + std::to_string(i + 2), std::string(buf.data() + i * BUSTUB_PAGE_SIZE));
+    }
+    dm.ShutDown();
+  }
+
+  // pages 0-3 stay in the database file, 4-7 and 8-9 go to the next segments
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test.db", &stat_buf));
+  EXPECT_EQ(segment_pages * BUSTUB_PAGE_SIZE, static_cast<size_t>(stat_buf.st_size));
+  ASSERT_EQ(0, stat("test.db.1", &stat_buf));
+  EXPECT_EQ(segment_pages * BUSTUB_PAGE_SIZE, static_cast<size_t>(stat_buf.st_size));
+  ASSERT_EQ(0, stat("test.db.2", &stat_buf));
+  EXPECT_EQ(2U * BUSTUB_PAGE_SIZE, static_cast<size_t>(stat_buf.st_size));
+
+  // with preallocation, a new segment gets its full size up front
+  enable_segment_preallocation = true;
+  {
+    auto dm = DiskManagerUring("test.db", false, segment_pages);
+    std::snprintf(data, sizeof(data), "page 12");
+    dm.WritePage(12, data);
+    dm.ShutDown();
+  }
+  enable_segment_preallocation = false;
+  ASSERT_EQ(0, stat("test.db.3", &stat_buf));
+  EXPECT_EQ(segment_pages * BUSTUB_PAGE_SIZE, static_cast<size_t>(stat_buf.st_size));
+
+  for (auto *file_name : {"test.db.1", "test.db.2", "test.db.3"}) {
+    remove(file_name);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPagesTest) {
+  const size_t num_pages = 5;
+  std::vector<char> buf(num_pages * BUSTUB_PAGE_SIZE, 'x');
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  for (int i = 0; i < 3; i++) {
+    std::snprintf(data, sizeof(data), "page %d", i);
+    dm.WritePage(i, data);
+  }
+
+  // the run starts inside the file and ends past its end, which reads as zeros
+  dm.ReadPages(1, num_pages, buf.data());
+  EXPECT_STREQ("page 1", buf.data());
+  EXPECT_STREQ("page 2", buf.data() + BUSTUB_PAGE_SIZE);
+  for (size_t i = 2 * BUSTUB_PAGE_SIZE; i < buf.size(); i++) {
+    ASSERT_EQ(0, buf[i]);
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWriteTest) {
+  const int num_pages = 100;
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    std::vector<char> data(num_pages * BUSTUB_PAGE_SIZE);
+    std::vector<char> buf(num_pages * BUSTUB_PAGE_SIZE);
+    auto dm = DiskManagerUring("test.db", use_io_uring);
+    if (!use_io_uring) {
+      EXPECT_FALSE(dm.IsUsingIoUring());
+    }
+
+    // many requests in flight at once, completed in any order
+    std::vector<std::future<void>> requests;
+    for (int i = 0; i < num_pages; i++) {
+      std::snprintf(&data[i * BUSTUB_PAGE_SIZE], BUSTUB_PAGE_SIZE, "page %d", i);
+      requests.push_back(dm.WritePageAsync(i, &data[i * BUSTUB_PAGE_SIZE]));
+    }
+    for (auto &request : requests) {
+      request.get();
+    }
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+    requests.clear();
+    for (int i = num_pages - 1; i >= 0; i--) {
+      requests.push_back(dm.ReadPageAsync(i, &buf[i * BUSTUB_PAGE_SIZE]));
+    }
+    for (auto &request : requests) {
+      request.get();
+    }
+    EXPECT_EQ(0, std::memcmp(buf.data(), data.data(), buf.size()));
+
+    // the synchronous calls go through the same queue, reads past the end of the file are zeros
+    std::memset(buf.data(), 'x', buf.size());
+    dm.ReadPages(num_pages - 1, 3, buf.data());
+    EXPECT_STREQ("page 99", buf.data());
+    for (size_t i = BUSTUB_PAGE_SIZE; i < 3 * BUSTUB_PAGE_SIZE; i++) {
+      ASSERT_EQ(0, buf[i]);
+    }
+    dm.ReadPage(7, buf.data());
+    EXPECT_STREQ("page 7", buf.data());
+
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  enable_direct_io = true;
+  // whether or not the file system takes O_DIRECT, aligned and unaligned buffers both work
+  auto dm = DiskManagerUring("test.db", false);
+  enable_direct_io = false;
+  std::unique_ptr<char, void (*)(void *)> aligned(
+      static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, BUSTUB_PAGE_SIZE)), std::free);
+  std::vector<char> unaligned(BUSTUB_PAGE_SIZE + 1);
+
+  std::snprintf(aligned.get(), BUSTUB_PAGE_SIZE, "aligned");
+  std::snprintf(&unaligned[1], BUSTUB_PAGE_SIZE, "unaligned");
+  dm.WritePage(0, aligned.get());
+  dm.WritePage(1, &unaligned[1]);
+
+  dm.ReadPage(1, aligned.get());
+  EXPECT_STREQ("unaligned", aligned.get());
+  dm.ReadPage(0, &unaligned[1]);
+  EXPECT_STREQ("aligned", &unaligned[1]);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, IOErrorTest) {
+  // the database file may not grow past 10.5 pages, a write beyond fails with EFBIG instead of raising SIGXFSZ
+  rlimit old_limit{};
+  ASSERT_EQ(0, getrlimit(RLIMIT_FSIZE, &old_limit));
+  auto *old_handler = std::signal(SIGXFSZ, SIG_IGN);
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    auto dm = DiskManagerUring("test.db", use_io_uring);
+    std::vector<char> data(BUSTUB_PAGE_SIZE, 'x');
+    rlimit limit = old_limit;
+    limit.rlim_cur = 10 * BUSTUB_PAGE_SIZE + BUSTUB_PAGE_SIZE / 2;
+    ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &limit));
+
+    dm.WritePage(9, data.data());
+    // the first half of page 10 fits, the rest of the short write fails
+    EXPECT_THROW(dm.WritePage(10, data.data()), Exception);
+    EXPECT_THROW(dm.WritePageAsync(20, data.data()).get(), Exception);
+
+    ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &old_limit));
+    std::vector<char> buf(BUSTUB_PAGE_SIZE);
+    dm.ReadPage(9, buf.data());
+    EXPECT_EQ(data, buf);
+    dm.ShutDown();
+  }
+  std::signal(SIGXFSZ, old_handler);
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
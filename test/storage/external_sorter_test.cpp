@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter_test.cpp
+//
+// Identification: test/storage/external_sorter_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_uring.h"
+#include "storage/index/external_sorter.h"
+
+namespace bustub {
+
+TEST(ExternalSorterTest, InMemoryTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(8, disk_manager);
+  {
+    ExternalSorter<int64_t, std::less<>> sorter(bpm, std::less<>());
+    for (int64_t i = 100; i > 0; i--) {
+      sorter.Add(i);
+    }
+    sorter.Sort();
+    int64_t entry;
+    for (int64_t i = 1; i <= 100; i++) {
+      ASSERT_TRUE(sorter.Next(&entry));
+      EXPECT_EQ(i, entry);
+    }
+    EXPECT_FALSE(sorter.Next(&entry));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ExternalSorterTest, MergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  // fewer frames than pages of runs, so that the runs are evicted and read back
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+
+  const int64_t num_entries = 50000;
+  std::vector<int64_t> entries;
+  for (int64_t i = 0; i < num_entries; i++) {
+    entries.push_back(i);
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(15445));
+  {
+    // runs of two pages merged three at a time, so that it takes several passes
+    ExternalSorter<int64_t, std::less<>> sorter(bpm, std::less<>(), 2 * BUSTUB_PAGE_SIZE, 3);
+    for (auto entry : entries) {
+      sorter.Add(entry);
+    }
+    EXPECT_EQ(num_entries, sorter.Size());
+    sorter.Sort();
+    int64_t entry;
+    for (int64_t i = 0; i < num_entries; i++) {
+      ASSERT_TRUE(sorter.Next(&entry));
+      EXPECT_EQ(i, entry);
+    }
+    EXPECT_FALSE(sorter.Next(&entry));
+  }
+
+  {
+    // a sorter dropped before it is read deletes its runs
+    ExternalSorter<int64_t, std::less<>> sorter(bpm, std::less<>(), BUSTUB_PAGE_SIZE, 3);
+    for (auto entry : entries) {
+      sorter.Add(entry);
+    }
+    sorter.Sort();
+    int64_t entry;
+    ASSERT_TRUE(sorter.Next(&entry));
+    EXPECT_EQ(0, entry);
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(ExternalSorterTest, ExceptionTest) {
+  remove("sorter_test.db");
+  remove("sorter_test.db.fsm");
+  // the free space map hands out the lowest free page ids, so a leaked page leaves a gap in them
+  auto *disk_manager = new DiskManagerUring("sorter_test.db", false);
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+
+  // a comparison fails in the middle of the first merge pass, once the comparisons are armed
+  bool armed = false;
+  int budget = 10000;
+  const auto less = [&](int64_t lhs, int64_t rhs) {
+    if (armed && --budget == 0) {
+      throw Exception("comparison failed");
+    }
+    return lhs < rhs;
+  };
+  std::vector<int64_t> entries(20000);
+  std::iota(entries.begin(), entries.end(), 0);
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(15445));
+  {
+    ExternalSorter<int64_t, decltype(less)> sorter(bpm, less, BUSTUB_PAGE_SIZE, 3);
+    for (auto entry : entries) {
+      sorter.Add(entry);
+    }
+    armed = true;
+    EXPECT_THROW(sorter.Sort(), Exception);
+  }
+
+  // the sorter deleted the pages of its runs, those read in part and those merged in part included
+  for (page_id_t i = 0; i < 200; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(i, page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("sorter_test.db");
+  remove("sorter_test.db.fsm");
+  remove("sorter_test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_test.cpp
+//
+// Identification: test/storage/free_space_map_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <cstdio>
+#include <memory>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_uring.h"
+
+namespace bustub {
+
+class FreeSpaceMapTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    remove("fsm_test.db");
+    remove("fsm_test.db.fsm");
+  }
+
+  void TearDown() override {
+    remove("fsm_test.db");
+    remove("fsm_test.db.fsm");
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(FreeSpaceMapTest, AllocateTest) {
+  FreeSpaceMap fsm("fsm_test.db.fsm", 0);
+  for (page_id_t i = 0; i < 10; i++) {
+    EXPECT_EQ(i, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+  }
+
+  // freed pages are handed out again, lowest first
+  fsm.Deallocate(7);
+  fsm.Deallocate(3);
+  EXPECT_FALSE(fsm.IsAllocated(3));
+  EXPECT_EQ(3, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+  EXPECT_EQ(7, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+  EXPECT_EQ(10, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+
+  // with a hint, the closest free page wins
+  fsm.Deallocate(2);
+  fsm.Deallocate(8);
+  EXPECT_EQ(8, fsm.Allocate(9, 1, 0));
+  EXPECT_EQ(2, fsm.Allocate(9, 1, 0));
+
+  // pages of other residue classes are left alone
+  fsm.Deallocate(4);
+  fsm.Deallocate(5);
+  EXPECT_EQ(5, fsm.Allocate(INVALID_PAGE_ID, 2, 1));
+  EXPECT_EQ(13, fsm.Allocate(INVALID_PAGE_ID, 4, 1));
+  EXPECT_EQ(4, fsm.Allocate(INVALID_PAGE_ID, 2, 0));
+}
+
+// NOLINTNEXTLINE
+TEST_F(FreeSpaceMapTest, PersistenceTest) {
+  {
+    // a map created for an existing database takes over its pages, and the pages span two map pages
+    FreeSpaceMap fsm("fsm_test.db.fsm", 5);
+    EXPECT_TRUE(fsm.IsAllocated(4));
+    EXPECT_FALSE(fsm.IsAllocated(5));
+    for (int i = 0; i < 40000; i++) {
+      fsm.Allocate(INVALID_PAGE_ID, 1, 0);
+    }
+    fsm.Deallocate(1);
+    fsm.Deallocate(39000);
+  }
+  FreeSpaceMap fsm("fsm_test.db.fsm", 0);
+  EXPECT_FALSE(fsm.IsAllocated(1));
+  EXPECT_FALSE(fsm.IsAllocated(39000));
+  EXPECT_TRUE(fsm.IsAllocated(39001));
+  EXPECT_EQ(1, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+  EXPECT_EQ(39000, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+  EXPECT_EQ(40005, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+}
+
+// NOLINTNEXTLINE
+TEST_F(FreeSpaceMapTest, DeferredFlushTest) {
+  FreeSpaceMap fsm("fsm_test.db.fsm", 0);
+  for (page_id_t i = 0; i < 10; i++) {
+    fsm.Allocate(INVALID_PAGE_ID, 1, 0);
+  }
+  fsm.Flush();
+
+  // changes stay in memory until a flush, a second map opened on the file still sees the old state
+  fsm.Deallocate(5);
+  EXPECT_EQ(10, fsm.Allocate(INVALID_PAGE_ID, 4, 2));
+  EXPECT_TRUE(FreeSpaceMap("fsm_test.db.fsm", 0).IsAllocated(5));
+  EXPECT_FALSE(FreeSpaceMap("fsm_test.db.fsm", 0).IsAllocated(10));
+
+  // writing a page that is on disk already leaves the map alone, writing a new one flushes it first
+  fsm.FlushAllocation(3);
+  EXPECT_TRUE(FreeSpaceMap("fsm_test.db.fsm", 0).IsAllocated(5));
+  fsm.FlushAllocation(10);
+  EXPECT_FALSE(FreeSpaceMap("fsm_test.db.fsm", 0).IsAllocated(5));
+  EXPECT_TRUE(FreeSpaceMap("fsm_test.db.fsm", 0).IsAllocated(10));
+
+  // the lowest free page is found again after pages below the last one found are freed
+  EXPECT_EQ(5, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+  EXPECT_EQ(11, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+  fsm.Deallocate(1);
+  EXPECT_EQ(1, fsm.Allocate(INVALID_PAGE_ID, 1, 0));
+}
+
+// NOLINTNEXTLINE
+TEST_F(FreeSpaceMapTest, BufferPoolTest) {
+  auto disk_manager = std::make_unique<DiskManagerUring>("fsm_test.db", false);
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(4, disk_manager.get(), 2);
+
+  page_id_t page_ids[8];
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // a deleted page is reused, whether or not it is still in the buffer pool
+  ASSERT_TRUE(bpm->DeletePage(page_ids[1]));
+  ASSERT_TRUE(bpm->DeletePage(page_ids[6]));
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(page_ids[1], page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPageNear(&page_id, page_ids[7]));
+  EXPECT_EQ(page_ids[6], page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(8, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  bpm->FlushAllPages();
+  disk_manager->ShutDown();
+}
+
+}  // namespace bustub
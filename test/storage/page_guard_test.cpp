@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+
+/** The frame holding page_id, to look at its pin count and dirty flag. */
+auto FrameOf(BufferPoolManagerInstance *bpm, page_id_t page_id) -> Page * {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    if (bpm->GetPages()[i].GetPageId() == page_id) {
+      return &bpm->GetPages()[i];
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, PinAndDirtyTest) {
+  const size_t buffer_pool_size = 4;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  page_id_t page_id;
+  {
+    auto guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "hello");
+    EXPECT_EQ(1, FrameOf(bpm.get(), page_id)->GetPinCount());
+
+    // moving hands the pin over, the moved-from guard no longer owns anything
+    auto moved = std::move(guard);
+    EXPECT_FALSE(guard.IsValid());  // NOLINT(bugprone-use-after-move)
+    EXPECT_EQ(1, FrameOf(bpm.get(), page_id)->GetPinCount());
+  }
+  EXPECT_EQ(0, FrameOf(bpm.get(), page_id)->GetPinCount());
+  EXPECT_TRUE(FrameOf(bpm.get(), page_id)->IsDirty());
+
+  // reading does not mark the page dirty, and Drop releases the pin before the guard goes away
+  ASSERT_TRUE(bpm->FlushPage(page_id));
+  auto guard = bpm->FetchPageBasic(page_id);
+  EXPECT_EQ(0, strcmp(guard.GetData(), "hello"));
+  guard.Drop();
+  guard.Drop();
+  EXPECT_EQ(0, FrameOf(bpm.get(), page_id)->GetPinCount());
+  EXPECT_FALSE(FrameOf(bpm.get(), page_id)->IsDirty());
+
+  // with every frame pinned by guards the pool is full, assigning over a guard frees its frame
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t new_page_id;
+    guards.push_back(bpm->NewPageGuarded(&new_page_id));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  page_id_t new_page_id;
+  EXPECT_FALSE(bpm->NewPageGuarded(&new_page_id).IsValid());
+  guards[0] = BasicPageGuard();
+  EXPECT_TRUE(bpm->NewPageGuarded(&new_page_id).IsValid());
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, LatchTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(4, disk_manager.get(), 2);
+
+  page_id_t page_id;
+  auto basic = bpm->NewPageGuarded(&page_id);
+  ASSERT_TRUE(basic.IsValid());
+  auto *page = FrameOf(bpm.get(), page_id);
+
+  {
+    auto write_guard = basic.UpgradeWrite();
+    EXPECT_FALSE(basic.IsValid());  // NOLINT(bugprone-use-after-move)
+    EXPECT_FALSE(page->TryRLatch());
+    write_guard.AsMut<int>()[0] = 42;
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+
+  {
+    // readers share the latch, and each holds its own pin
+    auto read_guard = bpm->FetchPageRead(page_id);
+    auto other_read_guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(42, read_guard.As<int>()[0]);
+    EXPECT_EQ(2, page->GetPinCount());
+    read_guard = std::move(other_read_guard);
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // every latch was released, so the page can be latched for writing again
+  auto write_guard = bpm->FetchPageWrite(page_id);
+  ASSERT_TRUE(write_guard.IsValid());
+  write_guard.Drop();
+  ASSERT_TRUE(page->TryRLatch());
+  page->RUnlatch();
+}
+
+}  // namespace bustub
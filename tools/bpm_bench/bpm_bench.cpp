@@ -0,0 +1,132 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "common/exception.h"
+#include "fmt/core.h"
+#include "storage/disk/disk_manager_memory.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+struct BpmBenchConfig {
+  size_t num_instances_;
+  size_t pool_size_;
+  size_t num_pages_;
+  size_t num_threads_;
+  size_t replacer_k_;
+  uint64_t duration_ms_;
+};
+
+/**
+ * Run a fetch / unpin workload against a ParallelBufferPoolManager with the given number of instances.
+ * 80% of the accesses go to the first 20% of the pages, so most fetches hit while some still have to evict.
+ * @return the number of fetches per second over all threads
+ */
+auto RunBench(const BpmBenchConfig &config) -> double {
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::ParallelBufferPoolManager>(
+      config.num_instances_, config.pool_size_ / config.num_instances_, disk_manager.get(), config.replacer_k_);
+
+  std::vector<bustub::page_id_t> page_ids;
+  for (size_t i = 0; i < config.num_pages_; i++) {
+    bustub::page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    if (page == nullptr) {
+      throw bustub::Exception("cannot allocate page");
+    }
+    page_ids.push_back(page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < config.num_threads_; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937_64 gen(thread_id);
+      std::uniform_int_distribution<size_t> hot(0, std::max<size_t>(page_ids.size() / 5, 1) - 1);
+      std::uniform_int_distribution<size_t> all(0, page_ids.size() - 1);
+      std::uniform_int_distribution<int> coin(0, 9);
+      uint64_t ops = 0;
+      while (!stop) {
+        auto page_id = page_ids[coin(gen) < 8 ? hot(gen) : all(gen)];
+        auto *page = bpm->FetchPage(page_id);
+        if (page != nullptr) {
+          bpm->UnpinPage(page_id, false);
+          ops++;
+        }
+      }
+      total_ops += ops;
+    });
+  }
+
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(config.duration_ms_));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  return static_cast<double>(total_ops) * 1000 / static_cast<double>(elapsed);
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-bpm-bench");
+  program.add_argument("--duration").help("run each configuration for n milliseconds");
+  program.add_argument("--threads").help("number of worker threads");
+  program.add_argument("--instances").help("number of buffer pool instances, sweeps 1..16 if not set");
+  program.add_argument("--pool-size").help("total number of frames over all instances");
+  program.add_argument("--pages").help("number of distinct pages accessed");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  BpmBenchConfig config{1, 1024, 4096, std::max<size_t>(std::thread::hardware_concurrency(), 2), 2, 2000};
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoi(program.get("--duration"));
+  }
+  if (program.present("--threads")) {
+    config.num_threads_ = std::stoi(program.get("--threads"));
+  }
+  if (program.present("--pool-size")) {
+    config.pool_size_ = std::stoi(program.get("--pool-size"));
+  }
+  if (program.present("--pages")) {
+    config.num_pages_ = std::stoi(program.get("--pages"));
+  }
+
+  std::vector<size_t> instance_counts{1, 2, 4, 8, 16};
+  if (program.present("--instances")) {
+    instance_counts = {static_cast<size_t>(std::stoi(program.get("--instances")))};
+  }
+
+  std::cerr << fmt::format("x: {} threads, {} frames, {} pages, {}ms per run", config.num_threads_, config.pool_size_,
+                           config.num_pages_, config.duration_ms_)
+            << std::endl;
+  for (auto num_instances : instance_counts) {
+    config.num_instances_ = num_instances;
+    auto throughput = RunBench(config);
+    std::cout << fmt::format("instances={:<3} fetches/s={:.0f}", num_instances, throughput) << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/core.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+struct LockBenchConfig {
+  size_t num_rows_;
+  size_t rows_per_txn_;
+  size_t read_percent_;
+  uint64_t duration_ms_;
+  bool unordered_;
+};
+
+struct LockBenchResult {
+  double row_locks_per_sec_;
+  double commits_per_sec_;
+  double abort_rate_;
+};
+
+/**
+ * Every thread runs transactions that take an intention lock on the table and lock rows_per_txn random rows, in row
+ * order so that they never deadlock unless config.unordered_ is set, then commit. read_percent of the transactions
+ * lock their rows shared. A transaction aborted by the deadlock policy gives up its locks and is not retried.
+ */
+auto RunBench(const LockBenchConfig &config, size_t num_threads, bustub::DeadlockPolicy deadlock_policy)
+    -> LockBenchResult {
+  bustub::LockManager lock_manager(deadlock_policy);
+  bustub::TransactionManager txn_manager(&lock_manager);
+  const bustub::table_oid_t oid = 0;
+  std::atomic<bool> stop{false};
+  std::vector<size_t> locks(num_threads, 0);
+  std::vector<size_t> commits(num_threads, 0);
+  std::vector<size_t> aborts(num_threads, 0);
+
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937_64 gen(thread_id);
+      std::uniform_int_distribution<uint32_t> row(0, config.num_rows_ - 1);
+      std::uniform_int_distribution<size_t> percent(0, 99);
+      std::vector<uint32_t> rows;
+      size_t num_locks = 0;
+      while (!stop) {
+        const bool read_only = percent(gen) < config.read_percent_;
+        auto *txn = txn_manager.Begin();
+        lock_manager.LockTable(txn,
+                               read_only ? bustub::LockManager::LockMode::INTENTION_SHARED
+                                         : bustub::LockManager::LockMode::INTENTION_EXCLUSIVE,
+                               oid);
+        rows.clear();
+        for (size_t i = 0; i < config.rows_per_txn_; i++) {
+          rows.push_back(row(gen));
+        }
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        if (config.unordered_) {
+          std::shuffle(rows.begin(), rows.end(), gen);
+        }
+        for (auto r : rows) {
+          if (!lock_manager.LockRow(
+                  txn, read_only ? bustub::LockManager::LockMode::SHARED : bustub::LockManager::LockMode::EXCLUSIVE,
+                  oid, bustub::RID(static_cast<bustub::page_id_t>(r / 64), r % 64))) {
+            break;
+          }
+          num_locks++;
+        }
+        // wound-wait may abort a transaction that is not waiting, it finds out here
+        if (txn->GetState() == bustub::TransactionState::ABORTED) {
+          txn_manager.Abort(txn);
+          aborts[thread_id]++;
+        } else {
+          txn_manager.Commit(txn);
+          commits[thread_id]++;
+        }
+        txn_manager.Recycle(txn);
+      }
+      locks[thread_id] = num_locks;
+    });
+  }
+
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(config.duration_ms_));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::max<uint64_t>(ClockMs() - start, 1);
+
+  size_t total_locks = 0;
+  size_t total_commits = 0;
+  size_t total_aborts = 0;
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    total_locks += locks[thread_id];
+    total_commits += commits[thread_id];
+    total_aborts += aborts[thread_id];
+  }
+  const auto seconds = static_cast<double>(elapsed) / 1000;
+  const size_t total_txns = std::max<size_t>(total_commits + total_aborts, 1);
+  return {static_cast<double>(total_locks) / seconds, static_cast<double>(total_commits) / seconds,
+          static_cast<double>(total_aborts) / static_cast<double>(total_txns)};
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-lock-bench");
+  program.add_argument("--threads").help("run with this many threads only, otherwise 1, 2, 4, ... 64");
+  program.add_argument("--rows").help("number of distinct rows locked");
+  program.add_argument("--rows-per-txn").help("rows locked by each transaction");
+  program.add_argument("--read-percent").help("percentage of transactions that lock their rows shared");
+  program.add_argument("--duration").help("run time per thread count in ms");
+  program.add_argument("--unordered").help("lock the rows of a transaction in random order, so that deadlocks happen");
+  program.add_argument("--deadlock-policy").help("run with detection, wound_wait or wait_die only, otherwise all three");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  LockBenchConfig config{1000000, 8, 50, 2000, false};
+  if (program.present("--rows")) {
+    config.num_rows_ = std::stoi(program.get("--rows"));
+  }
+  if (program.present("--rows-per-txn")) {
+    config.rows_per_txn_ = std::stoi(program.get("--rows-per-txn"));
+  }
+  if (program.present("--read-percent")) {
+    config.read_percent_ = std::stoi(program.get("--read-percent"));
+  }
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoi(program.get("--duration"));
+  }
+  if (program.present("--unordered")) {
+    config.unordered_ = program.get("--unordered") == "true" || program.get("--unordered") == "yes";
+  }
+  if (config.num_rows_ == 0) {
+    std::cerr << "--rows must be positive" << std::endl;
+    return 1;
+  }
+
+  std::vector<size_t> thread_counts{1, 2, 4, 8, 16, 32, 64};
+  if (program.present("--threads")) {
+    thread_counts = {static_cast<size_t>(std::stoi(program.get("--threads")))};
+  }
+
+  std::vector<std::string> policies{"detection", "wound_wait", "wait_die"};
+  if (program.present("--deadlock-policy")) {
+    policies = {program.get("--deadlock-policy")};
+  }
+  std::vector<bustub::DeadlockPolicy> deadlock_policies;
+  for (const auto &name : policies) {
+    auto policy = bustub::DeadlockPolicy::DETECTION;
+    if (!bustub::LockManager::ParseDeadlockPolicy(name, &policy)) {
+      std::cerr << "unknown deadlock policy " << name << std::endl;
+      return 1;
+    }
+    deadlock_policies.push_back(policy);
+  }
+
+  std::cerr << fmt::format("x: {} rows, {} rows per txn{}, {}% read-only, {} ms per run", config.num_rows_,
+                           config.rows_per_txn_, config.unordered_ ? " in random order" : "", config.read_percent_,
+                           config.duration_ms_)
+            << std::endl;
+  for (size_t i = 0; i < policies.size(); i++) {
+    for (auto num_threads : thread_counts) {
+      auto result = RunBench(config, num_threads, deadlock_policies[i]);
+      std::cout << fmt::format("policy={:<10} threads={:<4} row_locks/s={:.0f} commits/s={:.0f} abort_rate={:.3f}",
+                               policies[i], num_threads, result.row_locks_per_sec_, result.commits_per_sec_,
+                               result.abort_rate_)
+                << std::endl;
+    }
+  }
+
+  return 0;
+}
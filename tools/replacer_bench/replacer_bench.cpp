@@ -0,0 +1,227 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/replacer.h"
+#include "common/exception.h"
+#include "fmt/core.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+struct ReplacerBenchConfig {
+  size_t num_frames_;
+  size_t num_pages_;
+  size_t num_ops_;
+  size_t k_;
+};
+
+/**
+ * 80% of the accesses go to the first 20% of the pages, the rest are uniform.
+ */
+auto MakeHotSetTrace(const ReplacerBenchConfig &config) -> std::vector<bustub::page_id_t> {
+  std::mt19937_64 gen(15445);
+  std::uniform_int_distribution<bustub::page_id_t> hot(0, std::max<size_t>(config.num_pages_ / 5, 1) - 1);
+  std::uniform_int_distribution<bustub::page_id_t> all(0, config.num_pages_ - 1);
+  std::uniform_int_distribution<int> coin(0, 9);
+  std::vector<bustub::page_id_t> trace(config.num_ops_);
+  for (auto &page : trace) {
+    page = coin(gen) < 8 ? hot(gen) : all(gen);
+  }
+  return trace;
+}
+
+/**
+ * Index lookups mixed with table scans. The index has 3/4 of num_frames pages whose accesses are skewed towards the
+ * upper levels; one operation in a thousand scans the next num_frames pages of a table heap much larger than the pool,
+ * touching each heap page once per tuple like TableIterator does.
+ */
+auto MakeScanTrace(const ReplacerBenchConfig &config) -> std::vector<bustub::page_id_t> {
+  const size_t index_pages = std::max<size_t>(config.num_frames_ * 3 / 4, 1);
+  const size_t heap_pages = std::max(config.num_pages_, index_pages + 1) - index_pages;
+  const size_t tuples_per_page = 4;
+  std::mt19937_64 gen(15445);
+  std::uniform_int_distribution<int> coin(0, 999);
+  std::vector<bustub::page_id_t> trace;
+  trace.reserve(config.num_ops_);
+  size_t scan_cursor = 0;
+  while (trace.size() < config.num_ops_) {
+    if (coin(gen) != 0) {
+      // a root to leaf traversal, level l picks one of the first index_pages / 8^(2-l) pages
+      for (size_t l = 0; l < 3 && trace.size() < config.num_ops_; l++) {
+        const size_t level_size = std::max<size_t>(index_pages >> (3 * (2 - l)), 1);
+        trace.push_back(static_cast<bustub::page_id_t>(std::uniform_int_distribution<size_t>(0, level_size - 1)(gen)));
+      }
+      continue;
+    }
+    for (size_t i = 0; i < config.num_frames_ && trace.size() < config.num_ops_; i++) {
+      const auto page = static_cast<bustub::page_id_t>(index_pages + scan_cursor);
+      scan_cursor = (scan_cursor + 1) % heap_pages;
+      for (size_t t = 0; t < tuples_per_page && trace.size() < config.num_ops_; t++) {
+        trace.push_back(page);
+      }
+    }
+  }
+  return trace;
+}
+
+/** Read a trace with one page id per line. Empty lines and lines starting with '#' are skipped. */
+auto ReadTrace(const std::string &path) -> std::vector<bustub::page_id_t> {
+  std::ifstream in(path);
+  if (!in) {
+    throw bustub::Exception(fmt::format("cannot open trace {}", path));
+  }
+  std::vector<bustub::page_id_t> trace;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    trace.push_back(static_cast<bustub::page_id_t>(std::stol(line)));
+  }
+  return trace;
+}
+
+void WriteTrace(const std::string &path, const std::vector<bustub::page_id_t> &trace) {
+  std::ofstream out(path);
+  if (!out) {
+    throw bustub::Exception(fmt::format("cannot open trace {}", path));
+  }
+  for (auto page : trace) {
+    out << page << '\n';
+  }
+}
+
+/**
+ * Replay a trace through a replacer the way a buffer pool drives it: every access pins and unpins the page's frame,
+ * and a miss takes a free frame or evicts a victim and loads the page into it.
+ * @return the number of page accesses per second, and the hit rate
+ */
+auto Replay(bustub::Replacer *replacer, size_t num_frames, const std::vector<bustub::page_id_t> &trace)
+    -> std::pair<double, double> {
+  std::unordered_map<bustub::page_id_t, bustub::frame_id_t> frame_of_page;
+  std::vector<bustub::page_id_t> page_of_frame(num_frames, bustub::INVALID_PAGE_ID);
+  size_t next_free = 0;
+  size_t hits = 0;
+
+  auto start = ClockMs();
+  for (auto page : trace) {
+    bustub::frame_id_t frame_id;
+    auto resident = frame_of_page.find(page);
+    if (resident != frame_of_page.end()) {
+      hits++;
+      frame_id = resident->second;
+      replacer->RecordAccess(frame_id);
+    } else {
+      if (next_free < num_frames) {
+        frame_id = static_cast<bustub::frame_id_t>(next_free++);
+      } else {
+        if (!replacer->Evict(&frame_id)) {
+          throw bustub::Exception("no evictable frame");
+        }
+        frame_of_page.erase(page_of_frame[frame_id]);
+      }
+      frame_of_page[page] = frame_id;
+      page_of_frame[frame_id] = page;
+      replacer->RecordAccess(frame_id);
+      replacer->RecordLoad(frame_id, page);
+    }
+    replacer->SetEvictable(frame_id, false);
+    replacer->SetEvictable(frame_id, true);
+  }
+  auto elapsed = std::max<uint64_t>(ClockMs() - start, 1);
+  return {static_cast<double>(trace.size()) * 1000 / static_cast<double>(elapsed),
+          static_cast<double>(hits) / static_cast<double>(std::max<size_t>(trace.size(), 1))};
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-replacer-bench");
+  program.add_argument("--replacer").help("replacer to run (lru_k, heap_lru_k, 2q, arc, clock_pro), runs all if not set");
+  program.add_argument("--workload").help("synthetic workload (hotset, scan), defaults to hotset");
+  program.add_argument("--trace").help("replay the page ids in this file, one per line, instead of a workload");
+  program.add_argument("--write-trace").help("write the page ids of the synthetic workload to this file");
+  program.add_argument("--frames").help("number of frames");
+  program.add_argument("--pages").help("number of distinct pages accessed");
+  program.add_argument("--ops").help("number of page accesses");
+  program.add_argument("--k").help("lookback constant k");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  ReplacerBenchConfig config{131072, 524288, 1000000, 2};
+  if (program.present("--frames")) {
+    config.num_frames_ = std::stoi(program.get("--frames"));
+  }
+  if (program.present("--pages")) {
+    config.num_pages_ = std::stoi(program.get("--pages"));
+  }
+  if (program.present("--ops")) {
+    config.num_ops_ = std::stoi(program.get("--ops"));
+  }
+  if (program.present("--k")) {
+    config.k_ = std::stoi(program.get("--k"));
+  }
+  if (config.num_pages_ < config.num_frames_) {
+    std::cerr << "--pages must be at least --frames" << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> replacers{"lru_k", "heap_lru_k", "2q", "arc", "clock_pro"};
+  if (program.present("--replacer")) {
+    replacers = {program.get("--replacer")};
+  }
+
+  std::vector<bustub::page_id_t> trace;
+  std::string source;
+  if (program.present("--trace")) {
+    source = program.get("--trace");
+    trace = ReadTrace(source);
+  } else {
+    source = program.present("--workload") ? program.get("--workload") : "hotset";
+    if (source == "hotset") {
+      trace = MakeHotSetTrace(config);
+    } else if (source == "scan") {
+      trace = MakeScanTrace(config);
+    } else {
+      std::cerr << "unknown workload " << source << std::endl;
+      return 1;
+    }
+    if (program.present("--write-trace")) {
+      WriteTrace(program.get("--write-trace"), trace);
+    }
+  }
+
+  std::cerr << fmt::format("x: {}, {} frames, {} accesses, k={}", source, config.num_frames_, trace.size(), config.k_)
+            << std::endl;
+  for (const auto &name : replacers) {
+    bustub::ReplacerType type;
+    if (!bustub::Replacer::ParseType(name, &type)) {
+      std::cerr << "unknown replacer " << name << std::endl;
+      return 1;
+    }
+    auto replacer = bustub::Replacer::Create(type, config.num_frames_, config.k_);
+    auto [throughput, hit_rate] = Replay(replacer.get(), config.num_frames_, trace);
+    std::cout << fmt::format("replacer={:<12} accesses/s={:<12.0f} hit_rate={:.4f}", name, throughput, hit_rate)
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -27,24 +27,33 @@ auto GetWidthOfUtf8(const void *beg, const void *end, size_t *width) -> int {
 auto main(int argc, char **argv) -> int {
   ft_set_u8strwid_func(&GetWidthOfUtf8);
 
-  auto bustub = std::make_unique<bustub::BustubInstance>("test.db");
-
   auto default_prompt = "bustub> ";
   auto emoji_prompt = "\U0001f6c1> ";  // the bathtub emoji
   bool use_emoji_prompt = false;
   bool disable_tty = false;
+  auto replacer_type = bustub::ReplacerType::LRUK;
 
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--emoji-prompt") == 0) {
       use_emoji_prompt = true;
-      break;
+      continue;
     }
     if (strcmp(argv[i], "--disable-tty") == 0) {
       disable_tty = true;
-      break;
+      continue;
+    }
+    if (strcmp(argv[i], "--replacer") == 0 && i + 1 < argc) {
+      if (!bustub::Replacer::ParseType(argv[++i], &replacer_type)) {
+        std::cerr << "unknown replacer " << argv[i] << ", expected lru_k, heap_lru_k, 2q, arc or clock_pro"
+                  << std::endl;
+        return 1;
+      }
+      continue;
     }
   }
 
+  auto bustub = std::make_unique<bustub::BustubInstance>("test.db", 1, replacer_type);
+
   bustub->GenerateMockTable();
 
   if (bustub->buffer_pool_manager_ != nullptr) {
@@ -13,6 +13,7 @@
 #include "common/bustub_instance.h"
 #include "common/exception.h"
 #include "common/util/string_util.h"
+#include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "concurrency/transaction_manager.h"
 #include "fmt/core.h"
@@ -53,12 +54,19 @@ struct TerrierTotalMetrics {
     committed_update_txn_cnt_ += committed_cnt;
   }
 
-  void Report() {
+  static auto AbortRate(uint64_t aborted_cnt, uint64_t committed_cnt) -> double {
+    return aborted_cnt == 0 ? 0 : aborted_cnt / static_cast<double>(aborted_cnt + committed_cnt);
+  }
+
+  void Report(const std::string &concurrency_control) {
     auto now = ClockMs();
     auto elsped = now - start_time_;
     auto count_txn_per_sec = committed_count_txn_cnt_ / static_cast<double>(elsped) * 1000;
     auto update_txn_per_sec = committed_update_txn_cnt_ / static_cast<double>(elsped) * 1000;
 
+    fmt::print("{}: update abort rate {:.3}, count abort rate {:.3}\n", concurrency_control,
+               AbortRate(aborted_update_txn_cnt_, committed_update_txn_cnt_),
+               AbortRate(aborted_count_txn_cnt_, committed_count_txn_cnt_));
     fmt::print("<<< BEGIN\n");
     fmt::print("update: {}\n", update_txn_per_sec);
     fmt::print("count: {}\n", count_txn_per_sec);
@@ -120,6 +128,8 @@ auto main(int argc, char **argv) -> int {
   program.add_argument("--duration").help("run terrier bench for n milliseconds");
   program.add_argument("--force-create-index").help("create index in terrier bench");
   program.add_argument("--force-enable-update").help("use update statement in terrier bench");
+  program.add_argument("--deadlock-policy").help("detection, wound_wait or wait_die");
+  program.add_argument("--concurrency-control").help("2pl, or occ to validate the updates optimistically");
 
   try {
     program.parse_args(argc, argv);
@@ -129,7 +139,32 @@ auto main(int argc, char **argv) -> int {
     return 1;
   }
 
-  auto bustub = std::make_unique<bustub::BustubInstance>();
+  std::string deadlock_policy_name = "detection";
+  auto deadlock_policy = bustub::DeadlockPolicy::DETECTION;
+  if (program.present("--deadlock-policy")) {
+    deadlock_policy_name = program.get("--deadlock-policy");
+    if (!bustub::LockManager::ParseDeadlockPolicy(deadlock_policy_name, &deadlock_policy)) {
+      std::cerr << "unknown deadlock policy " << deadlock_policy_name << std::endl;
+      return 1;
+    }
+  }
+
+  // Under occ, the updates run optimistically and the counts read a snapshot, neither takes locks.
+  bool use_occ = false;
+  if (program.present("--concurrency-control")) {
+    const auto concurrency_control = program.get("--concurrency-control");
+    if (concurrency_control != "2pl" && concurrency_control != "occ") {
+      std::cerr << "unknown concurrency control " << concurrency_control << std::endl;
+      return 1;
+    }
+    use_occ = concurrency_control == "occ";
+  }
+  const auto update_isolation =
+      use_occ ? bustub::IsolationLevel::OPTIMISTIC : bustub::IsolationLevel::REPEATABLE_READ;
+  const auto count_isolation =
+      use_occ ? bustub::IsolationLevel::SNAPSHOT_ISOLATION : bustub::IsolationLevel::REPEATABLE_READ;
+
+  auto bustub = std::make_unique<bustub::BustubInstance>(1, bustub::ReplacerType::LRUK, deadlock_policy);
   auto writer = bustub::SimpleStreamWriter(std::cerr);
 
   // create schema
@@ -198,7 +233,7 @@ auto main(int argc, char **argv) -> int {
     auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
     bustub->ExecuteSqlTxn(query, writer, txn);
     bustub->txn_manager_->Commit(txn);
-    delete txn;
+    bustub->txn_manager_->Recycle(txn);
     if (ss.str() != fmt::format("{}\t\n", BUSTUB_NFT_NUM)) {
       fmt::print("unexpected result \"{}\" when insert\n", ss.str());
       exit(1);
@@ -213,7 +248,8 @@ auto main(int argc, char **argv) -> int {
   total_metrics.Begin();
 
   for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &bustub, enable_update, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &bustub, enable_update, duration_ms, update_isolation,
+                                      &total_metrics] {
       const size_t nft_range_size = BUSTUB_NFT_NUM / BUSTUB_TERRIER_THREAD;
       const size_t nft_range_begin = thread_id * nft_range_size;
       const size_t nft_range_end = (thread_id + 1) * nft_range_size;
@@ -233,7 +269,7 @@ auto main(int argc, char **argv) -> int {
         bool txn_success = true;
 
         if (enable_update) {
-          auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+          auto txn = bustub->txn_manager_->Begin(nullptr, update_isolation);
           std::string query = fmt::format("UPDATE nft SET terrier = {} WHERE id = {}", terrier_id, nft_id);
           if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
             txn_success = false;
@@ -244,16 +280,18 @@ auto main(int argc, char **argv) -> int {
             exit(1);
           }
 
-          if (txn_success) {
-            bustub->txn_manager_->Commit(txn);
+          if (!txn_success) {
+            bustub->txn_manager_->Abort(txn);
+            metrics.TxnAborted();
+          } else if (bustub->txn_manager_->Commit(txn)) {
             metrics.TxnCommitted();
           } else {
-            bustub->txn_manager_->Abort(txn);
+            // failed validation at commit
             metrics.TxnAborted();
           }
-          delete txn;
+          bustub->txn_manager_->Recycle(txn);
         } else {
-          auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+          auto txn = bustub->txn_manager_->Begin(nullptr, update_isolation);
 
           std::string query = fmt::format("DELETE FROM nft WHERE id = {}", nft_id);
           if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
@@ -268,12 +306,14 @@ auto main(int argc, char **argv) -> int {
           if (!txn_success) {
             bustub->txn_manager_->Abort(txn);
             metrics.TxnAborted();
-            delete txn;
+            bustub->txn_manager_->Recycle(txn);
+          } else if (!bustub->txn_manager_->Commit(txn)) {
+            metrics.TxnAborted();
+            bustub->txn_manager_->Recycle(txn);
           } else {
-            bustub->txn_manager_->Commit(txn);
-            delete txn;
+            bustub->txn_manager_->Recycle(txn);
 
-            txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+            txn = bustub->txn_manager_->Begin(nullptr, update_isolation);
 
             query = fmt::format("INSERT INTO nft VALUES ({}, {})", nft_id, terrier_id);
             if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
@@ -288,11 +328,12 @@ auto main(int argc, char **argv) -> int {
             if (!txn_success) {
               bustub->txn_manager_->Abort(txn);
               metrics.TxnAborted();
-            } else {
-              bustub->txn_manager_->Commit(txn);
+            } else if (bustub->txn_manager_->Commit(txn)) {
               metrics.TxnCommitted();
+            } else {
+              metrics.TxnAborted();
             }
-            delete txn;
+            bustub->txn_manager_->Recycle(txn);
           }
         }
 
@@ -304,7 +345,7 @@ auto main(int argc, char **argv) -> int {
   }
 
   for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &bustub, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &bustub, duration_ms, count_isolation, &total_metrics] {
       std::random_device r;
       std::default_random_engine gen(r());
       std::uniform_int_distribution<int> terrier_uniform_dist(0, BUSTUB_TERRIER_CNT - 1);
@@ -317,7 +358,7 @@ auto main(int argc, char **argv) -> int {
         auto writer = bustub::SimpleStreamWriter(ss, true);
         auto terrier_id = terrier_uniform_dist(gen);
 
-        auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+        auto txn = bustub->txn_manager_->Begin(nullptr, count_isolation);
         bool txn_success = true;
 
         std::string query = fmt::format("SELECT count(*) FROM nft WHERE terrier = {}", terrier_id);
@@ -332,7 +373,7 @@ auto main(int argc, char **argv) -> int {
           bustub->txn_manager_->Abort(txn);
           metrics.TxnAborted();
         }
-        delete txn;
+        bustub->txn_manager_->Recycle(txn);
 
         metrics.Report();
       }
@@ -351,14 +392,14 @@ auto main(int argc, char **argv) -> int {
     auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
     bustub->ExecuteSqlTxn("SELECT count(*) FROM nft", writer, txn);
     bustub->txn_manager_->Commit(txn);
-    delete txn;
+    bustub->txn_manager_->Recycle(txn);
     if (ss.str() != fmt::format("{}\t\n", BUSTUB_NFT_NUM)) {
       fmt::print("unexpected result \"{}\" when verifying\n", ss.str());
       exit(1);
     }
   }
 
-  total_metrics.Report();
+  total_metrics.Report(use_occ ? "occ" : fmt::format("2pl, deadlock policy {}", deadlock_policy_name));
 
   return 0;
 }